@@ -19,6 +19,9 @@
 //    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+// ConfigurationPlayer has more members than the default limit of 10:
+#define FUSION_MAX_VECTOR_SIZE 20
+
 #include "common/ConfigFile.hpp"
 #include "common/MediaCommon.hpp"
 #include "common/GeneralEvents.hpp"
@@ -69,7 +72,15 @@ BOOST_FUSION_ADAPT_STRUCT(ConfigurationPlayer,
 			  (bool, useOptimalPixelFormat)
 			  (bool, useXvClipping)
 			  (bool, enableDeinterlacer)
-			  (std::string, deinterlacer));
+			  (std::string, deinterlacer)
+			  (int, readAheadSize)
+			  (double, bufferLowSeconds)
+			  (double, bufferHighSeconds)
+			  (int, bufferLowSize)
+			  (int, bufferHighSize)
+			  (bool, accurateSeek)
+			  (int, decoderThreads)
+			  (std::string, decoderThreadTypes));
 
 BOOST_FUSION_ADAPT_STRUCT(ConfigurationData,
 			  (StationList, stationList)
@@ -119,6 +130,14 @@ std::ostream& operator<<(std::ostream& strm, const ConfigurationPlayer& cp)
     strm << "useXvClipping = " << cp.useXvClipping << std::endl;
     strm << "enableDeinterlacer = " << cp.enableDeinterlacer << std::endl;
     strm << "deinterlacer = " << cp.deinterlacer << std::endl;
+    strm << "readAheadSize = " << cp.readAheadSize << std::endl;
+    strm << "bufferLowSeconds = " << cp.bufferLowSeconds << std::endl;
+    strm << "bufferHighSeconds = " << cp.bufferHighSeconds << std::endl;
+    strm << "bufferLowSize = " << cp.bufferLowSize << std::endl;
+    strm << "bufferHighSize = " << cp.bufferHighSize << std::endl;
+    strm << "accurateSeek = " << cp.accurateSeek << std::endl;
+    strm << "decoderThreads = " << cp.decoderThreads << std::endl;
+    strm << "decoderThreadTypes = " << cp.decoderThreadTypes << std::endl;
     return strm;
 }
 
@@ -147,6 +166,7 @@ struct config_parser : qi::grammar<ForwardIterator, ConfigurationData(), ascii::
     config_parser() : config_parser::base_type(config_data_)
     {
         using qi::int_;
+        using qi::double_;
         using qi::lit;
         using boost::spirit::qi::lexeme;
         using ascii::char_;
@@ -182,7 +202,15 @@ struct config_parser : qi::grammar<ForwardIterator, ConfigurationData(), ascii::
             >> ( ( lit("useOptimalPixelFormat") >> '=' >> bool_ >> ';' ) ^
 		 ( lit("useXvClipping") >> '=' >> bool_ >> ';' ) ^
 		 ( lit("enableDeinterlacer") >> '=' >> bool_ >> ';' ) ^
-		 ( lit("deinterlacer") >> '=' >> quoted_string >> ';' ) )
+		 ( lit("deinterlacer") >> '=' >> quoted_string >> ';' ) ^
+		 ( lit("readAheadSize") >> '=' >> int_ >> ';' ) ^
+		 ( lit("bufferLowSeconds") >> '=' >> double_ >> ';' ) ^
+		 ( lit("bufferHighSeconds") >> '=' >> double_ >> ';' ) ^
+		 ( lit("bufferLowSize") >> '=' >> int_ >> ';' ) ^
+		 ( lit("bufferHighSize") >> '=' >> int_ >> ';' ) ^
+		 ( lit("accurateSeek") >> '=' >> bool_ >> ';' ) ^
+		 ( lit("decoderThreads") >> '=' >> int_ >> ';' ) ^
+		 ( lit("decoderThreadTypes") >> '=' >> quoted_string >> ';' ) )
             >> '}' >> ";";
 
 	config_data_ %=
@@ -207,6 +235,7 @@ struct config_generator : karma::grammar<OutputIterator, ConfigurationData()>
     config_generator() : config_generator::base_type(config_data_)
     {
         using karma::int_;
+        using karma::double_;
         using karma::lit;
 	using karma::bool_;
 
@@ -241,6 +270,14 @@ struct config_generator : karma::grammar<OutputIterator, ConfigurationData()>
 	    << lit("    useXvClipping") << " = " << bool_ << ";\n"
 	    << lit("    enableDeinterlacer") << " = " << bool_ << ";\n"
 	    << lit("    deinterlacer") << " = " << quoted_string << ";\n"
+	    << lit("    readAheadSize") << " = " << int_ << ";\n"
+	    << lit("    bufferLowSeconds") << " = " << double_ << ";\n"
+	    << lit("    bufferHighSeconds") << " = " << double_ << ";\n"
+	    << lit("    bufferLowSize") << " = " << int_ << ";\n"
+	    << lit("    bufferHighSize") << " = " << int_ << ";\n"
+	    << lit("    accurateSeek") << " = " << bool_ << ";\n"
+	    << lit("    decoderThreads") << " = " << int_ << ";\n"
+	    << lit("    decoderThreadTypes") << " = " << quoted_string << ";\n"
             << "};\n";
 
 	config_data_ =
@@ -99,12 +99,33 @@ struct ConfigurationPlayer
     ConfigurationPlayer()
 	: useOptimalPixelFormat(true),
 	  useXvClipping(true),
-	  enableDeinterlacer(true)
+	  enableDeinterlacer(true),
+	  readAheadSize(8192),
+	  bufferLowSeconds(1),
+	  bufferHighSeconds(3),
+	  bufferLowSize(4096),
+	  bufferHighSize(16384),
+	  accurateSeek(true),
+	  decoderThreads(0),
+	  decoderThreadTypes()
     {}
     bool useOptimalPixelFormat;
     bool useXvClipping;
     bool enableDeinterlacer;
     std::string deinterlacer;
+    int readAheadSize;  // KiB, 0 disables read-ahead
+    // Watermarks for the packets queued per stream:
+    double bufferLowSeconds;
+    double bufferHighSeconds;
+    int bufferLowSize;  // KiB
+    int bufferHighSize; // KiB
+    bool accurateSeek;
+    // Video decoder threads, 0 uses one thread per core:
+    int decoderThreads;
+    // Threading per codec, e.g. "default=frame+slice,mpeg2video=slice".
+    // Types are frame, slice or none. default is used for other codecs
+    // and is frame+slice if not given:
+    std::string decoderThreadTypes;
 };
 
 struct ConfigurationData
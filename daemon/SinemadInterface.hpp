@@ -23,6 +23,7 @@
 #define SINEMAD_INTERFACE_HPP
 
 #include "platform/interface.hpp"
+#include "platform/wire_format.hpp"
 #include "receiver/TunerFacade.hpp"
 
 namespace sdif
@@ -44,4 +45,15 @@ struct SinemadInterface
 
 }
 
+namespace itf
+{
+
+template<>
+struct wire_format<sdif::SinemadInterface>
+{
+    typedef binary_format type;
+};
+
+}
+
 #endif
@@ -236,6 +236,12 @@ void GtkmmMediaPlayer::process(boost::shared_ptr<NotificationNewStream> event)
     notificationNewStream(*event);
 }
 
+void GtkmmMediaPlayer::process(boost::shared_ptr<NotificationTrickPlayEnded>)
+{
+    TRACE_DEBUG();
+    notificationTrickPlayEnded();
+}
+
 void GtkmmMediaPlayer::process(boost::shared_ptr<CloseFileResp>)
 {
     notificationCurrentTime(0);
@@ -42,6 +42,7 @@ public:
     sigc::signal<void, NotificationDeinterlacerList> notificationDeinterlacerList;
     sigc::signal<void, NotificationVideoAttribute> notificationVideoAttribute;
     sigc::signal<void, NotificationNewStream> notificationNewStream;
+    sigc::signal<void> notificationTrickPlayEnded;
     sigc::signal<void> notificationFileClosed;
     sigc::signal<void> resizeMainWindow;
 
@@ -59,6 +60,7 @@ public:
     virtual void process(boost::shared_ptr<NotificationDeinterlacerList> event);
     virtual void process(boost::shared_ptr<NotificationVideoAttribute> event);
     virtual void process(boost::shared_ptr<NotificationNewStream> event);
+    virtual void process(boost::shared_ptr<NotificationTrickPlayEnded> event);
     virtual void process(boost::shared_ptr<CloseFileResp> event);
 
     virtual bool on_main_window_state_event(GdkEventWindowState* event);
@@ -76,6 +76,18 @@ PlayList::iterator GtkmmPlayList::insert(int n, std::string elem)
     return it;
 }
 
+void GtkmmPlayList::changed(std::string file)
+{
+    int n = 0;
+    for (iterator it = begin(); it != end(); it++, n++)
+    {
+	if (*it == file)
+	{
+	    on_entry_changed(n, it);
+	}
+    }
+}
+
 void GtkmmPlayList::on_entry_changed(int n, iterator it)
 {
     TRACE_DEBUG(<< n);
@@ -45,6 +45,10 @@ public:
     virtual bool erase(int n);
     virtual iterator insert(int n, std::string);
 
+    // Shows changed information about file, e.g. its duration that is
+    // known after it was opened:
+    void changed(std::string file);
+
 protected:
     void on_entry_changed(int n, iterator);
 };
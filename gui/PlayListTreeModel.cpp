@@ -23,8 +23,10 @@
 #include <assert.h>
 
 #include "gui/PlayListTreeModel.hpp"
+#include "player/ProbeCache.hpp"
 #include "platform/Logging.hpp"
 
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 
@@ -32,7 +34,7 @@ PlayListTreeModel::PlayListTreeModel(GtkmmPlayList& playList)
 : Glib::ObjectBase( typeid(PlayListTreeModel) ), //register a custom GType.
   Glib::Object(), //The custom GType is actually registered here.
   m_PlayList(playList),
-  m_columns(1),
+  m_columns(2),
   m_stamp(1)  // When the model's stamp != the iterator's stamp 
               // then that iterator is invalid and should be ignored. 
               // Also, 0=invalid
@@ -300,6 +302,12 @@ void PlayListTreeModel::get_value_vfunc(const TreeModel::iterator& iter, int col
 	    int row_index = get_row_index(iter);
 	    std::string str = m_PlayList[row_index];
 
+	    if (column == 1)
+	    {
+		// Duration is known after the file was opened once:
+		str = formatDuration(ProbeCache::instance().getDuration(str));
+	    }
+
 	    // value and val contains data and type info.
 
 	    // Here type_TreeModelColumn::ValueType is Glib::Value<Glib::ustring>.
@@ -314,6 +322,21 @@ void PlayListTreeModel::get_value_vfunc(const TreeModel::iterator& iter, int col
     }
 }
 
+std::string PlayListTreeModel::formatDuration(double duration)
+{
+    if (duration <= 0)
+    {
+	return std::string();
+    }
+
+    int seconds = int(duration + 0.5);
+    std::stringstream ss;
+    ss << seconds / 3600 << ':'
+       << std::setw(2) << std::setfill('0') << (seconds / 60) % 60 << ':'
+       << std::setw(2) << std::setfill('0') << seconds % 60;
+    return ss.str();
+}
+
 #if 0
 bool PlayListTreeModel::iter_is_valid(const iterator& iter) const
 {
@@ -97,6 +97,9 @@ private:
     int get_row_index(const TreeModel::iterator& iter) const;
     void set_row_index(const TreeModel::iterator& iter, int row) const;
 
+    // Formats as h:mm:ss, empty if duration is unknown:
+    static std::string formatDuration(double duration);
+
     //  bool is_valid(const TreeModel::iterator& iter) const;
 
     typedef Gtk::TreeModelColumn<Glib::ustring> type_TreeModelColumn;
@@ -57,6 +57,7 @@ PlayListWindow::PlayListWindow(GtkmmPlayList& playList)
     pColumnName->add_attribute(m_CellRendererText.property_text(), m_Columns.m_col_name);
     pColumnName->set_cell_data_func(m_CellRendererText, slot);
     m_TreeView.append_column(*pColumnName);
+    m_TreeView.append_column("Duration", m_Columns.m_col_duration);
 
     // Allow rows to be drag and dropped within the treeview:
     m_TreeView.set_reorderable();
@@ -86,9 +86,11 @@ private:
 	ModelColumns()
 	{
 	    add(m_col_name);
+	    add(m_col_duration);
 	}
 
 	Gtk::TreeModelColumn<Glib::ustring> m_col_name;
+	Gtk::TreeModelColumn<Glib::ustring> m_col_duration;
     };
 
     ModelColumns m_Columns;
@@ -29,7 +29,9 @@ PlayerConfigWidget::PlayerConfigWidget()
       m_EnableDeinterlacer("Enable deinterlacer"),
       m_FramePixelFormat("Pixel Format"),
       m_UseOptimalPixelFormat("Use optimal pixel format"),
-      m_UseXvClipping("Use Xv clipping")
+      m_UseXvClipping("Use Xv clipping"),
+      m_FrameSeek("Seek"),
+      m_AccurateSeek("Continue exactly at the seek position")
 {
     set_spacing(4);
     set_border_width(4);
@@ -51,11 +53,18 @@ PlayerConfigWidget::PlayerConfigWidget()
     m_VBoxPixelFormat.pack_start(m_UseOptimalPixelFormat, Gtk::PACK_SHRINK);
     m_VBoxPixelFormat.pack_start(m_UseXvClipping, Gtk::PACK_SHRINK);
 
+    pack_start(m_FrameSeek, Gtk::PACK_SHRINK);
+    m_FrameSeek.add(m_VBoxSeek);
+    m_VBoxSeek.set_spacing(0);
+    m_VBoxSeek.set_border_width(5);
+    m_VBoxSeek.pack_start(m_AccurateSeek, Gtk::PACK_SHRINK);
+
     // Signals:
     m_EnableDeinterlacer.signal_toggled().connect(sigc::mem_fun(this, &PlayerConfigWidget::on_enableDeinterlacer_toggled) );
     m_ComboBoxDeinterlacer.signal_changed().connect(sigc::mem_fun(this, &PlayerConfigWidget::on_deinterlacer_changed) );
     m_UseOptimalPixelFormat.signal_toggled().connect(sigc::mem_fun(this, &PlayerConfigWidget::on_useOptimalPixelFormat_toggled) );
     m_UseXvClipping.signal_toggled().connect(sigc::mem_fun(this, &PlayerConfigWidget::on_useXvClipping_toggled) );
+    m_AccurateSeek.signal_toggled().connect(sigc::mem_fun(this, &PlayerConfigWidget::on_accurateSeek_toggled) );
 }
 
 PlayerConfigWidget::~PlayerConfigWidget()
@@ -71,6 +80,7 @@ void PlayerConfigWidget::on_configuration_data_loaded(boost::shared_ptr<Configur
     m_EnableDeinterlacer.set_active(m_ConfigurationData->configPlayer.enableDeinterlacer);
     m_UseOptimalPixelFormat.set_active(m_ConfigurationData->configPlayer.useOptimalPixelFormat);
     m_UseXvClipping.set_active(m_ConfigurationData->configPlayer.useXvClipping);
+    m_AccurateSeek.set_active(m_ConfigurationData->configPlayer.accurateSeek);
 
     // Maybe NotificationDeinterlacerList is already received:
     selectConfiguredDeinterlacer();
@@ -79,6 +89,13 @@ void PlayerConfigWidget::on_configuration_data_loaded(boost::shared_ptr<Configur
     on_deinterlacer_changed();
     on_useOptimalPixelFormat_toggled();
     on_useXvClipping_toggled();
+    on_accurateSeek_toggled();
+    signalSetReadAheadSize(m_ConfigurationData->configPlayer.readAheadSize);
+
+    const ConfigurationPlayer& configPlayer = m_ConfigurationData->configPlayer;
+    signalSetPacketBufferLimits(configPlayer.bufferLowSeconds, configPlayer.bufferHighSeconds,
+				configPlayer.bufferLowSize, configPlayer.bufferHighSize);
+    signalSetDecoderThreading(configPlayer.decoderThreads, configPlayer.decoderThreadTypes);
 }
 
 void PlayerConfigWidget::on_deinterlacer_list(const NotificationDeinterlacerList& event)
@@ -211,6 +228,31 @@ void PlayerConfigWidget::on_useXvClipping_toggled()
     }
 }
 
+void PlayerConfigWidget::on_accurateSeek_toggled()
+{
+    TRACE_DEBUG();
+
+    bool active = m_AccurateSeek.get_active();
+
+    if (active)
+    {
+	signalEnableAccurateSeek();
+    }
+    else
+    {
+	signalDisableAccurateSeek();
+    }
+
+    if (m_ConfigurationData)
+    {
+	if (m_ConfigurationData->configPlayer.accurateSeek != active)
+	{
+	    m_ConfigurationData->configPlayer.accurateSeek = active;
+	    signalConfigurationDataChanged(m_ConfigurationData);
+	}
+    }
+}
+
 void PlayerConfigWidget::selectConfiguredDeinterlacer()
 {
     Gtk::TreePath path;
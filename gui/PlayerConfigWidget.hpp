@@ -41,7 +41,12 @@ public:
     sigc::signal<void> signalDisableOptimalPixelFormat;
     sigc::signal<void> signalEnableXvClipping;
     sigc::signal<void> signalDisableXvClipping;
+    sigc::signal<void> signalEnableAccurateSeek;
+    sigc::signal<void> signalDisableAccurateSeek;
     sigc::signal<void, const std::string&> signalSelectDeinterlacer;
+    sigc::signal<void, int> signalSetReadAheadSize;
+    sigc::signal<void, double, double, int, int> signalSetPacketBufferLimits;
+    sigc::signal<void, int, const std::string&> signalSetDecoderThreading;
 
     PlayerConfigWidget();
     ~PlayerConfigWidget();
@@ -54,6 +59,7 @@ private:
     void on_deinterlacer_changed();
     void on_useOptimalPixelFormat_toggled();
     void on_useXvClipping_toggled();
+    void on_accurateSeek_toggled();
 
     void selectConfiguredDeinterlacer();
 
@@ -80,6 +86,10 @@ private:
     Gtk::CheckButton m_UseOptimalPixelFormat;
     Gtk::CheckButton m_UseXvClipping;
 
+    Gtk::Frame m_FrameSeek;
+    Gtk::VBox  m_VBoxSeek;
+    Gtk::CheckButton m_AccurateSeek;
+
     boost::shared_ptr<ConfigurationData> m_ConfigurationData;
 };
 
@@ -30,6 +30,7 @@
 
 #include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <algorithm>
 #include <iostream>
 #include <list>
 #include <gtkmm/filechooserdialog.h>
@@ -50,6 +51,7 @@ SignalDispatcher::SignalDispatcher(GtkmmPlayList& playList)
       m_quit(false),
       m_timeTitlePlaybackStarted(getTimespec(0)),
       m_setTimeCounter(0),
+      m_trickPlaySpeed(0),
       m_visibleFullscreen(false,false,false),
       m_visibleWindow(true,true,true),
       m_visible(&m_visibleWindow),
@@ -193,6 +195,10 @@ SignalDispatcher::SignalDispatcher(GtkmmPlayList& playList)
 			   sigc::mem_fun(*this, &SignalDispatcher::on_help_help) );
     m_refActionGroup->add( Gtk::Action::create("HelpAbout", Gtk::Stock::ABOUT),
 			   sigc::mem_fun(*this, &SignalDispatcher::on_help_about) );
+    m_refActionGroup->add( Gtk::Action::create("HelpStatistics", "_Statistics",
+					       "Print event and queue statistics"),
+			   Gtk::AccelKey("<control>d"),
+			   sigc::mem_fun(*this, &SignalDispatcher::on_help_statistics) );
 
     m_refUIManager = Gtk::UIManager::create();
     m_refUIManager->insert_action_group(m_refActionGroup);
@@ -260,6 +266,7 @@ SignalDispatcher::SignalDispatcher(GtkmmPlayList& playList)
 	"    </menu>"
         "    <menu action='HelpMenu'>"
         "      <menuitem action='HelpHelp'/>"
+        "      <menuitem action='HelpStatistics'/>"
         "      <menuitem action='HelpAbout'/>"
         "    </menu>"
         "  </menubar>"
@@ -1032,6 +1039,7 @@ void SignalDispatcher::on_view_statusbar()
 void SignalDispatcher::on_media_play()
 {
     signal_open();
+    setTrickPlaySpeed(0);
     signal_play();
 
     // Hide/show buttons and menu entries:
@@ -1041,6 +1049,7 @@ void SignalDispatcher::on_media_play()
 
 void SignalDispatcher::on_media_pause()
 {
+    setTrickPlaySpeed(0);
     signal_pause();
 
     // Hide/show buttons and menu entries:
@@ -1079,12 +1088,30 @@ void SignalDispatcher::on_media_previous()
 
 void SignalDispatcher::on_media_forward()
 {
-    signal_seek_relative(+10);
+    // 2x, 4x, ..., 64x. Rewinding is stopped first:
+    setTrickPlaySpeed(m_trickPlaySpeed < 2 ? 2 : std::min(2 * m_trickPlaySpeed, 64));
 }
 
 void SignalDispatcher::on_media_rewind()
 {
-    signal_seek_relative(-10);
+    setTrickPlaySpeed(m_trickPlaySpeed > -2 ? -2 : std::max(2 * m_trickPlaySpeed, -64));
+}
+
+void SignalDispatcher::setTrickPlaySpeed(int speed)
+{
+    if (m_trickPlaySpeed != speed)
+    {
+	TRACE_DEBUG(<< speed);
+	m_trickPlaySpeed = speed;
+	signal_trick_play(speed);
+    }
+}
+
+void SignalDispatcher::on_notification_trick_play_ended()
+{
+    // The Demuxer already continues with normal playback:
+    TRACE_DEBUG();
+    m_trickPlaySpeed = 0;
 }
 
 void SignalDispatcher::on_media_record()
@@ -1171,6 +1198,12 @@ void SignalDispatcher::on_help_about()
     showAboutDialog();
 }
 
+void SignalDispatcher::on_help_statistics()
+{
+    TRACE_DEBUG();
+    signal_dump_statistics();
+}
+
 void SignalDispatcher::on_position_changed()
 {
     // Adjustment other than the value changed.
@@ -1226,6 +1259,9 @@ void SignalDispatcher::on_notification_file_closed()
 
     // MediaPlayer finished playing a file.
 
+    // The next file starts with normal playback:
+    m_trickPlaySpeed = 0;
+
     // Not playing, show play, hide pause buttons/menues:
     m_refActionPlay->set_visible(true);
     m_refActionPause->set_visible(false);
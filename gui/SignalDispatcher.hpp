@@ -54,6 +54,7 @@ public:
 
     sigc::signal<void, double> signal_seek_absolute;
     sigc::signal<void, double> signal_seek_relative;
+    sigc::signal<void, int> signal_trick_play;
     sigc::signal<void, boost::shared_ptr<ClipVideoSrcEvent> > signal_clip;
     sigc::signal<void> signal_open;
     sigc::signal<void> signal_play;
@@ -67,6 +68,7 @@ public:
     sigc::signal<void, boost::shared_ptr<ConfigurationData> > signalConfigurationDataChanged;
     sigc::signal<void> showHelpDialog;
     sigc::signal<void> showAboutDialog;
+    sigc::signal<void> signal_dump_statistics;
 
     SignalDispatcher(GtkmmPlayList& playList);
     ~SignalDispatcher();
@@ -99,6 +101,7 @@ public:
     void on_notification_video_size(const NotificationVideoSize& event);
     void on_notification_clipping(const NotificationClipping& event);
     void on_notification_new_stream(const NotificationNewStream& event);
+    void on_notification_trick_play_ended();
     void on_notification_file_closed();
 
     void on_set_title(Glib::ustring title);
@@ -144,6 +147,7 @@ public:
     virtual void on_channel_selected(int num);
     virtual void on_help_help();
     virtual void on_help_about();
+    virtual void on_help_statistics();
     virtual void on_position_changed();
     virtual void on_position_value_changed();
     virtual void on_volume_changed();
@@ -201,6 +205,10 @@ private:
     timespec_t m_timeTitlePlaybackStarted;
     int m_setTimeCounter;
 
+    // Fast forward > 1, rewind < -1, normal playback 0:
+    int m_trickPlaySpeed;
+    void setTrickPlaySpeed(int speed);
+
     ConfigurationGuiVisible m_visibleFullscreen;
     ConfigurationGuiVisible m_visibleWindow;
     ConfigurationGuiVisible* m_visible;
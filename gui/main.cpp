@@ -114,6 +114,10 @@ int main(int argc, char *argv[])
     // Signals: MainWindow -> GtkmmMediaPlayer
     mainWindow.signal_window_state_event().connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::on_main_window_state_event));
 
+    // ---------------------------------------------------------------
+    // Signals: GtkmmMediaPlayer -> GtkmmPlayList
+    mediaPlayer.notificationFileName.connect( sigc::mem_fun(playList, &GtkmmPlayList::changed) );
+
     // ---------------------------------------------------------------
     // Signals: GtkmmMediaPlayer -> SignalDispatcher
     mediaPlayer.notificationFileName.connect( sigc::mem_fun(signalDispatcher, &SignalDispatcher::on_set_title) );
@@ -123,6 +127,7 @@ int main(int argc, char *argv[])
     mediaPlayer.notificationVideoSize.connect( sigc::mem_fun(&signalDispatcher, &SignalDispatcher::on_notification_video_size) );
     mediaPlayer.notificationClipping.connect( sigc::mem_fun(&signalDispatcher, &SignalDispatcher::on_notification_clipping) );
     mediaPlayer.notificationNewStream.connect( sigc::mem_fun(&signalDispatcher, &SignalDispatcher::on_notification_new_stream) );
+    mediaPlayer.notificationTrickPlayEnded.connect( sigc::mem_fun(&signalDispatcher, &SignalDispatcher::on_notification_trick_play_ended) );
     mediaPlayer.signal_key_press_event().connect(sigc::mem_fun(signalDispatcher, &SignalDispatcher::on_key_press_event));
     mediaPlayer.notificationFileClosed.connect( sigc::mem_fun(signalDispatcher, &SignalDispatcher::on_notification_file_closed) );
     mediaPlayer.signal_drag_data_received().connect(sigc::mem_fun(signalDispatcher, &SignalDispatcher::on_drag_data_received));
@@ -130,6 +135,8 @@ int main(int argc, char *argv[])
     // Signals: SignalDispatcher -> GtkmmMediaPlayer
     signalDispatcher.signal_seek_absolute.connect( sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::seekAbsolute) );
     signalDispatcher.signal_seek_relative.connect( sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::seekRelative) );
+    signalDispatcher.signal_trick_play.connect( sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::trickPlay) );
+    signalDispatcher.signal_dump_statistics.connect( sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::dumpStatistics) );
     signalDispatcher.signal_clip.connect( sigc::mem_fun(mediaPlayer, GtkmmMediaPlayer_ClipSrc ) );
     signalDispatcher.signal_open.connect( sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::open) );
     signalDispatcher.signal_play.connect( sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::play) );
@@ -202,7 +209,12 @@ int main(int argc, char *argv[])
     playerConfigWidget.signalDisableOptimalPixelFormat.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::disableOptimalPixelFormat) );
     playerConfigWidget.signalEnableXvClipping.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::enableXvClipping) );
     playerConfigWidget.signalDisableXvClipping.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::disableXvClipping) );
+    playerConfigWidget.signalEnableAccurateSeek.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::enableAccurateSeek) );
+    playerConfigWidget.signalDisableAccurateSeek.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::disableAccurateSeek) );
     playerConfigWidget.signalSelectDeinterlacer.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::selectDeinterlacer) );
+    playerConfigWidget.signalSetReadAheadSize.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::setReadAheadSize) );
+    playerConfigWidget.signalSetPacketBufferLimits.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::setPacketBufferLimits) );
+    playerConfigWidget.signalSetDecoderThreading.connect(sigc::mem_fun(mediaPlayer, &GtkmmMediaPlayer::setDecoderThreading) );
 
     // ---------------------------------------------------------------
     // Signals: ConfigWindow -> SignalDispatcher
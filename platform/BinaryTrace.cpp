@@ -0,0 +1,298 @@
+//
+// Binary Trace
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#include "BinaryTrace.hpp"
+#include "Logging.hpp"
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <time.h>
+
+std::atomic<int> binaryTraceState(-1);
+
+namespace
+{
+
+// Single producer, single consumer ring. Only the owning thread writes
+// records, only the BinaryTraceWriter thread reads them. When the owning
+// thread exits, the ring is released and deleted by the BinaryTraceWriter
+// after the remaining records are written.
+struct BinaryTraceRing
+{
+    static const uint64_t size = 4096;   // power of two
+
+    BinaryTraceRing()
+	: head(0),
+	  tail(0),
+	  lost(0),
+	  released(false),
+	  tid(gettid())
+    {}
+
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> lost;
+    std::atomic<bool> released;
+    uint32_t tid;
+    BinaryTraceRecord records[size];
+};
+
+__thread BinaryTraceRing* threadRing = 0;
+
+// Called when a thread with a ring exits, also for threads not created
+// by boost, e.g. those of FFmpeg:
+void releaseRing(BinaryTraceRing* ring)
+{
+    threadRing = 0;
+    ring->released.store(true, std::memory_order_release);
+}
+
+boost::thread_specific_ptr<BinaryTraceRing>& getRingOwner()
+{
+    // Never deleted, threads may exit while the process terminates:
+    static boost::thread_specific_ptr<BinaryTraceRing>* owner =
+	new boost::thread_specific_ptr<BinaryTraceRing>(releaseRing);
+    return *owner;
+}
+
+struct Site
+{
+    int line;
+    std::string file;
+    std::string function;
+    std::string text;
+};
+
+class BinaryTraceWriter
+{
+public:
+    static BinaryTraceWriter* getInstance()
+    {
+	// Created when SINEMA_BINLOG is evaluated, before any other
+	// thread is using it:
+	return instance;
+    }
+
+    static bool create()
+    {
+	const char* fileName = getenv("SINEMA_BINLOG");
+	if (fileName)
+	{
+	    instance = new BinaryTraceWriter(fileName);
+	}
+	return instance != 0;
+    }
+
+    int registerSite(const char* file, int line, const char* function, const char* text)
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	Site site;
+	site.line = line;
+	site.file = file;
+	site.function = function;
+	site.text = text;
+	m_sites.push_back(site);
+	return m_sites.size() - 1;
+    }
+
+    BinaryTraceRing* registerRing()
+    {
+	BinaryTraceRing* ring = new BinaryTraceRing();
+	getRingOwner().reset(ring);
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_rings.push_back(ring);
+	return ring;
+    }
+
+    void stop()
+    {
+	{
+	    boost::mutex::scoped_lock lock(m_mutex);
+	    m_quit = true;
+	}
+	m_thread.join();
+	drain();
+    }
+
+private:
+    BinaryTraceWriter(const char* fileName)
+	: m_file(fileName, std::ios::binary),
+	  m_writtenSites(0),
+	  m_quit(false)
+    {
+	m_file.write(binaryTraceMagic, sizeof(binaryTraceMagic));
+	m_thread = boost::thread(boost::bind(&BinaryTraceWriter::operator(), this));
+    }
+
+    void operator()()
+    {
+	while (1)
+	{
+	    {
+		boost::mutex::scoped_lock lock(m_mutex);
+		if (m_quit)
+		{
+		    return;
+		}
+	    }
+
+	    drain();
+	    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+	}
+    }
+
+    void drain()
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	// Sites are registered before records refer to them:
+	for (; m_writtenSites < m_sites.size(); m_writtenSites++)
+	{
+	    const Site& site = m_sites[m_writtenSites];
+	    write<uint32_t>(BinaryTraceSite);
+	    write<uint32_t>(m_writtenSites);
+	    write<uint32_t>(site.line);
+	    m_file.write(site.file.c_str(), site.file.size() + 1);
+	    m_file.write(site.function.c_str(), site.function.size() + 1);
+	    m_file.write(site.text.c_str(), site.text.size() + 1);
+	}
+
+	for (std::vector<BinaryTraceRing*>::iterator it = m_rings.begin(); it != m_rings.end(); )
+	{
+	    BinaryTraceRing& ring = **it;
+	    // The last records are written before the ring is released:
+	    bool released = ring.released.load(std::memory_order_acquire);
+	    uint64_t head = ring.head.load(std::memory_order_acquire);
+	    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+
+	    if (head != tail)
+	    {
+		write<uint32_t>(BinaryTraceRecords);
+		write<uint32_t>(head - tail);
+		for (; tail != head; tail++)
+		{
+		    const BinaryTraceRecord& record = ring.records[tail & (BinaryTraceRing::size - 1)];
+		    m_file.write((const char*)&record, sizeof(record));
+		}
+		ring.tail.store(tail, std::memory_order_release);
+	    }
+
+	    uint32_t lost = ring.lost.exchange(0, std::memory_order_relaxed);
+	    if (lost)
+	    {
+		write<uint32_t>(BinaryTraceLost);
+		write<uint32_t>(ring.tid);
+		write<uint32_t>(lost);
+	    }
+
+	    if (released)
+	    {
+		delete *it;
+		it = m_rings.erase(it);
+	    }
+	    else
+	    {
+		it++;
+	    }
+	}
+
+	m_file.flush();
+    }
+
+    template<typename T>
+    void write(T val)
+    {
+	m_file.write((const char*)&val, sizeof(val));
+    }
+
+    std::ofstream m_file;
+    boost::mutex m_mutex;
+    std::vector<Site> m_sites;
+    size_t m_writtenSites;
+    std::vector<BinaryTraceRing*> m_rings;
+    bool m_quit;
+    boost::thread m_thread;
+
+    static BinaryTraceWriter* instance;
+};
+
+BinaryTraceWriter* BinaryTraceWriter::instance = 0;
+
+// Writes the remaining records when the process terminates:
+struct BinaryTraceShutdown
+{
+    ~BinaryTraceShutdown()
+    {
+	BinaryTraceWriter* writer = BinaryTraceWriter::getInstance();
+	if (writer)
+	{
+	    writer->stop();
+	}
+    }
+} binaryTraceShutdown;
+
+}
+
+bool initBinaryTrace()
+{
+    static boost::mutex mutex;
+    boost::mutex::scoped_lock lock(mutex);
+
+    if (binaryTraceState < 0)
+    {
+	binaryTraceState = BinaryTraceWriter::create() ? 1 : 0;
+    }
+
+    return binaryTraceState.load() > 0;
+}
+
+int registerTraceSite(const char* file, int line, const char* function, const char* text)
+{
+    return BinaryTraceWriter::getInstance()->registerSite(file, line, function, text);
+}
+
+void writeTraceRecord(int site, int numArgs,
+		      double a0, double a1, double a2, double a3)
+{
+    BinaryTraceRing* ring = threadRing;
+    if (!ring)
+    {
+	ring = threadRing = BinaryTraceWriter::getInstance()->registerRing();
+    }
+
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= BinaryTraceRing::size)
+    {
+	ring->lost.fetch_add(1, std::memory_order_relaxed);
+	return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    BinaryTraceRecord& record = ring->records[head & (BinaryTraceRing::size - 1)];
+    record.time = uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    record.tid = ring->tid;
+    record.site = site;
+    record.numArgs = numArgs;
+    record.arg[0] = a0;
+    record.arg[1] = a1;
+    record.arg[2] = a2;
+    record.arg[3] = a3;
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
@@ -0,0 +1,109 @@
+//
+// Binary Trace
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// TRACE_RECORD writes a fixed-size record with a timestamp, the thread
+// id, a call-site id and up to four numeric arguments into a ring buffer
+// owned by the calling thread. Nothing is formatted at runtime. A
+// separate thread drains the rings into the file given by SINEMA_BINLOG.
+// The file is decoded offline with tools/tracedump.
+//
+// Usage:
+//   TRACE_RECORD("decoded frame: pts, size", pts, size);
+//
+// If a ring is full, records are dropped and counted instead of
+// blocking the calling thread.
+//
+
+#ifndef BINARY_TRACE_HPP
+#define BINARY_TRACE_HPP
+
+#include <atomic>
+#include <stdint.h>
+
+struct BinaryTraceRecord
+{
+    uint64_t time;     // CLOCK_MONOTONIC in nanoseconds
+    uint32_t tid;
+    uint16_t site;
+    uint16_t numArgs;
+    double arg[4];
+};
+
+// File format: binaryTraceMagic followed by chunks starting with a tag.
+//   BinaryTraceSite:    uint32_t id, uint32_t line and the zero-terminated
+//                       strings file, function and text.
+//   BinaryTraceRecords: uint32_t count, count * BinaryTraceRecord
+//   BinaryTraceLost:    uint32_t tid, uint32_t count
+// Sites are written before the first record referring to them.
+const char binaryTraceMagic[8] = {'S', 'N', 'M', 'T', 'R', 'C', '0', '1'};
+
+enum BinaryTraceTag
+{
+    BinaryTraceSite = 1,
+    BinaryTraceRecords = 2,
+    BinaryTraceLost = 3
+};
+
+// -------------------------------------------------------------------
+
+// 1 if SINEMA_BINLOG is set, 0 otherwise, -1 until evaluated:
+extern std::atomic<int> binaryTraceState;
+bool initBinaryTrace();
+
+inline bool binaryTraceEnabled()
+{
+    int state = binaryTraceState.load(std::memory_order_relaxed);
+    if (state < 0)
+    {
+	return initBinaryTrace();
+    }
+    return state > 0;
+}
+
+int registerTraceSite(const char* file, int line, const char* function, const char* text);
+void writeTraceRecord(int site, int numArgs,
+		      double a0, double a1, double a2, double a3);
+
+inline void traceRecord(int site)
+{
+    writeTraceRecord(site, 0, 0, 0, 0, 0);
+}
+
+inline void traceRecord(int site, double a0)
+{
+    writeTraceRecord(site, 1, a0, 0, 0, 0);
+}
+
+inline void traceRecord(int site, double a0, double a1)
+{
+    writeTraceRecord(site, 2, a0, a1, 0, 0);
+}
+
+inline void traceRecord(int site, double a0, double a1, double a2)
+{
+    writeTraceRecord(site, 3, a0, a1, a2, 0);
+}
+
+inline void traceRecord(int site, double a0, double a1, double a2, double a3)
+{
+    writeTraceRecord(site, 4, a0, a1, a2, a3);
+}
+
+// Records are removed at compile time together with TRACE_DEBUG:
+#define TRACE_RECORD(text, ...)                                         \
+{                                                                       \
+   if (TRACE_MAX_LEVEL >= TRACE_LEVEL_DEBUG && binaryTraceEnabled())    \
+   {                                                                    \
+      static const int traceSite =                                      \
+	 registerTraceSite(__FILE__, __LINE__, __PRETTY_FUNCTION__, text); \
+      traceRecord(traceSite, ##__VA_ARGS__);                            \
+   }                                                                    \
+}
+
+#endif
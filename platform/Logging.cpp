@@ -15,6 +15,35 @@
 #include <boost/make_shared.hpp>
 #include <fstream>
 #include <stdlib.h>
+#include <string.h>
+
+std::atomic<int> traceLevel(-1);
+
+int initTraceLevel()
+{
+    int level = 0;
+
+    if (getenv("SINEMA_LOG"))
+    {
+	level = TRACE_LEVEL_DEBUG;
+
+	const char* name = getenv("SINEMA_LOG_LEVEL");
+	if (name)
+	{
+	    if (strcmp(name, "error") == 0)
+		level = TRACE_LEVEL_ERROR;
+	    else if (strcmp(name, "info") == 0)
+		level = TRACE_LEVEL_INFO;
+	    else if (strcmp(name, "debug") == 0)
+		level = TRACE_LEVEL_DEBUG;
+	    else
+		level = atoi(name);
+	}
+    }
+
+    traceLevel.store(level, std::memory_order_relaxed);
+    return level;
+}
 
 class TraceReceiver : public event_receiver<TraceReceiver>
 {
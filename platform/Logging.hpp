@@ -11,6 +11,7 @@
 #ifndef LOGGING_HPP
 #define LOGGING_HPP
 
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <boost/make_shared.hpp>
@@ -28,22 +29,59 @@ inline pid_t gettid() { return (pid_t) syscall (SYS_gettid); }
 
 // -------------------------------------------------------------------
 
+// Trace levels. Traces above TRACE_MAX_LEVEL are removed at compile time,
+// see configure --with-trace-level. The remaining ones are only formatted
+// when enabled at runtime: SINEMA_LOG names the log file and
+// SINEMA_LOG_LEVEL (error, info or debug) selects the level, default debug.
+// TRACE_ERROR is always written to std::cout.
+
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_INFO  2
+#define TRACE_LEVEL_DEBUG 3
+
+#ifndef TRACE_MAX_LEVEL
+#define TRACE_MAX_LEVEL TRACE_LEVEL_DEBUG
+#endif
+
+// Runtime level, -1 until SINEMA_LOG and SINEMA_LOG_LEVEL are evaluated.
+// Read by all threads, a relaxed load is sufficient:
+extern std::atomic<int> traceLevel;
+int initTraceLevel();
+
+inline bool traceEnabled(int level)
+{
+    int l = traceLevel.load(std::memory_order_relaxed);
+    if (l < 0)
+    {
+	l = initTraceLevel();
+    }
+    return level <= l;
+}
+
 class TraceUnit : public std::stringstream
 {
 public:
     ~TraceUnit();
 };
 
-#define TRACE_INFO(s)          \
-{                        \
-   TraceUnit traceUnit;  \
-   traceUnit s;          \
+#define TRACE_INFO(s)                                                   \
+{                                                                       \
+   if (TRACE_MAX_LEVEL >= TRACE_LEVEL_INFO &&                           \
+       traceEnabled(TRACE_LEVEL_INFO))                                  \
+   {                                                                    \
+      TraceUnit traceUnit;                                              \
+      traceUnit s;                                                      \
+   }                                                                    \
 }
 
-#define TRACE_DEBUG(s)                                \
-{                                               \
-   TraceUnit traceUnit;                         \
-   traceUnit << "D: " << __PRETTY_FUNCTION__ << " " s;	\
+#define TRACE_DEBUG(s)                                                  \
+{                                                                       \
+   if (TRACE_MAX_LEVEL >= TRACE_LEVEL_DEBUG &&                          \
+       traceEnabled(TRACE_LEVEL_DEBUG))                                 \
+   {                                                                    \
+      TraceUnit traceUnit;                                              \
+      traceUnit << "D: " << __PRETTY_FUNCTION__ << " " s;               \
+   }                                                                    \
 }
 
 #define TRACE_ERROR(s)                                            \
@@ -117,4 +155,6 @@ std::basic_ostream<_CharT, _Traits>& operator<<(std::basic_ostream<_CharT, _Trai
 
 // -------------------------------------------------------------------
 
+#include "platform/BinaryTrace.hpp"
+
 #endif
@@ -0,0 +1,163 @@
+//
+// Band Pool - Processing Image Bands on Worker Threads
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// A band_pool owns a fixed number of worker threads. start(n, fct, done)
+// calls fct(0) ... fct(n-1) on these threads and returns immediately.
+// The thread finishing the last band calls done. Only one job is
+// processed at a time, start waits until the previous job is finished.
+//
+// The caller has to ensure that everything used by fct and done is
+// valid until the job is finished, see wait.
+//
+
+#ifndef BAND_POOL_HPP
+#define BAND_POOL_HPP
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+
+class band_pool : private boost::noncopyable
+{
+public:
+    typedef boost::function<void (int)> band_fct_t;
+    typedef boost::function<void ()> done_fct_t;
+
+    explicit band_pool(int num_threads)
+	: m_num_bands(0),
+	  m_next_band(0),
+	  m_pending(0),
+	  m_busy(false),
+	  m_stop(false)
+    {
+	for (int i = 0; i < num_threads; i++)
+	{
+	    m_threads.create_thread(boost::bind(&band_pool::operator(), this));
+	}
+	m_size = num_threads;
+    }
+
+    ~band_pool()
+    {
+	{
+	    boost::mutex::scoped_lock lock(m_mutex);
+	    m_stop = true;
+	}
+	m_work.notify_all();
+	m_threads.join_all();
+    }
+
+    int size() const {return m_size;}
+
+    void start(int num_bands, band_fct_t fct, done_fct_t done = done_fct_t())
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+	while (m_busy)
+	{
+	    m_finished.wait(lock);
+	}
+
+	if (num_bands <= 0)
+	{
+	    lock.unlock();
+	    if (done)
+	    {
+		done();
+	    }
+	    return;
+	}
+
+	m_band_fct = fct;
+	m_done_fct = done;
+	m_num_bands = num_bands;
+	m_next_band = 0;
+	m_pending = num_bands;
+	m_busy = true;
+
+	m_work.notify_all();
+    }
+
+    // Blocks until the current job is finished, including done:
+    void wait()
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+	while (m_busy)
+	{
+	    m_finished.wait(lock);
+	}
+    }
+
+    void run(int num_bands, band_fct_t fct)
+    {
+	start(num_bands, fct);
+	wait();
+    }
+
+private:
+    void operator()()
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+	while (1)
+	{
+	    while (!m_stop && m_next_band >= m_num_bands)
+	    {
+		m_work.wait(lock);
+	    }
+	    if (m_stop)
+	    {
+		return;
+	    }
+
+	    int band = m_next_band++;
+
+	    lock.unlock();
+	    m_band_fct(band);
+	    lock.lock();
+
+	    if (--m_pending == 0)
+	    {
+		// Last band of this job:
+		m_num_bands = 0;
+		m_next_band = 0;
+		done_fct_t done;
+		done.swap(m_done_fct);
+
+		lock.unlock();
+		if (done)
+		{
+		    done();
+		}
+		lock.lock();
+
+		m_busy = false;
+		m_finished.notify_all();
+	    }
+	}
+    }
+
+    boost::thread_group m_threads;
+    int m_size;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_work;
+    boost::condition_variable m_finished;
+
+    band_fct_t m_band_fct;
+    done_fct_t m_done_fct;
+    int m_num_bands;
+    int m_next_band;
+    int m_pending;
+    bool m_busy;
+    bool m_stop;
+};
+
+#endif
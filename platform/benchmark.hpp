@@ -0,0 +1,53 @@
+//
+// Benchmark - Helpers for Benchmark and Test Programs
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// The test programs run by make check print a last line
+// "errors: <n>, ok" or "errors: <n>, failed" and return 0 only if
+// there are no errors.
+//
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include "platform/timer.hpp"
+
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+// Average seconds of one call of f:
+template<class F>
+double measure(int iterations, F f)
+{
+    timespec_t start = timer::get_current_time();
+    for (int i = 0; i < iterations; i++)
+    {
+	f();
+    }
+    return getSeconds(timer::get_current_time() - start) / iterations;
+}
+
+// The same sequence in each run, rand is not seeded:
+template<class T>
+void fill_random(std::vector<T>& buffer)
+{
+    for (size_t i = 0; i < buffer.size(); i++)
+    {
+	buffer[i] = rand();
+    }
+}
+
+// Prints the last line and returns the exit code:
+inline int test_result(int errors)
+{
+    std::cout << "errors: " << errors << (errors ? ", failed" : ", ok") << std::endl;
+    return errors ? 1 : 0;
+}
+
+#endif
@@ -18,7 +18,10 @@
 #include <boost/function.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/condition_variable.hpp>
-#include <queue>
+#include <atomic>
+#include <ostream>
+#include <utility>
+#include <vector>
 
 class without_callback_function
 {
@@ -51,54 +54,176 @@ private:
 
 class NoTrigger{};
 
+// Counters of the slow paths of a queue, i.e. of the cases where a
+// thread had to wait for or to wake up another thread. The fast paths
+// don't touch them. See event_processor::dump_statistics.
+struct queue_counters
+{
+    queue_counters()
+	: contended(0),
+	  sleeps(0),
+	  wakeups(0),
+	  overflows(0)
+    {}
+
+    std::atomic<unsigned long> contended;  // lock taken or CAS lost
+    std::atomic<unsigned long> sleeps;     // consumer waited for an element
+    std::atomic<unsigned long> wakeups;    // producer woke up a waiting consumer
+    std::atomic<unsigned long> overflows;  // ring full, see mpsc_ring_queue
+
+    void count(std::atomic<unsigned long>& counter)
+    {
+	counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void dump(std::ostream& strm) const
+    {
+	strm << "contended=" << contended.load(std::memory_order_relaxed)
+	     << ", sleeps=" << sleeps.load(std::memory_order_relaxed)
+	     << ", wakeups=" << wakeups.load(std::memory_order_relaxed)
+	     << ", overflows=" << overflows.load(std::memory_order_relaxed);
+    }
+};
+
+// The elements are stored in a vector, that is only cleared when it
+// is empty. Its capacity is kept, thus a queue that is emptied regularly
+// needs no allocations. A deque would allocate a new chunk for every
+// few elements.
 template<typename T, class base_type = without_callback_function>
 class concurrent_queue : public base_type
 {
 private:
-    std::queue<T> m_queue;
+    std::vector<T> m_queue;
+    size_t m_front;   // index of the first queued element
+    int m_waiting;    // consumers waiting for m_condition_variable
     mutable boost::mutex m_mutex;
     boost::condition_variable m_condition_variable;
+    queue_counters m_counters;
 
-public:
-    void push(T const& data)
+    void acquire(boost::mutex::scoped_lock& lock)
+    {
+	if (!lock.try_lock())
+	{
+	    m_counters.count(m_counters.contended);
+	    lock.lock();
+	}
+    }
+
+    void wait(boost::mutex::scoped_lock& lock)
+    {
+	m_counters.count(m_counters.sleeps);
+	m_waiting++;
+	m_condition_variable.wait(lock);
+	m_waiting--;
+    }
+
+    // Called with the lock held, the notification is sent without it:
+    void wakeup(boost::mutex::scoped_lock& lock)
     {
-	boost::mutex::scoped_lock lock(m_mutex);
-	m_queue.push(data);
+	bool waiting = m_waiting > 0;
 	lock.unlock();
-        m_condition_variable.notify_one();
+	if (waiting)
+	{
+	    m_counters.count(m_counters.wakeups);
+	    m_condition_variable.notify_one();
+	}
 	this->notify();
     }
 
+    void pop_front(T& popped_value)
+    {
+	popped_value=std::move(m_queue[m_front++]);
+	if (m_front == m_queue.size())
+	{
+	    m_queue.clear();
+	    m_front = 0;
+	}
+	else if (m_front > 64 && 2 * m_front > m_queue.size())
+	{
+	    // Never emptied, the popped elements are removed now and then:
+	    m_queue.erase(m_queue.begin(), m_queue.begin() + m_front);
+	    m_front = 0;
+	}
+    }
+
+public:
+    concurrent_queue() : m_front(0), m_waiting(0) {}
+
+    void push(T const& data)
+    {
+	boost::mutex::scoped_lock lock(m_mutex, boost::defer_lock);
+	acquire(lock);
+	m_queue.push_back(data);
+	wakeup(lock);
+    }
+
+    void push(T&& data)
+    {
+	boost::mutex::scoped_lock lock(m_mutex, boost::defer_lock);
+	acquire(lock);
+	m_queue.push_back(std::move(data));
+	wakeup(lock);
+    }
+
     bool empty() const
     {
         boost::mutex::scoped_lock lock(m_mutex);
-        return m_queue.empty();
+        return m_front == m_queue.size();
     }
 
     bool try_pop(T& popped_value)
     {
-        boost::mutex::scoped_lock lock(m_mutex);
-        if(m_queue.empty())
+        boost::mutex::scoped_lock lock(m_mutex, boost::defer_lock);
+        acquire(lock);
+        if(m_front == m_queue.size())
         {
             return false;
         }
         
-        popped_value=m_queue.front();
-        m_queue.pop();
+        pop_front(popped_value);
         return true;
     }
 
     void wait_and_pop(T& popped_value)
     {
-        boost::mutex::scoped_lock lock(m_mutex);
-        while(m_queue.empty())
+        boost::mutex::scoped_lock lock(m_mutex, boost::defer_lock);
+        acquire(lock);
+        while(m_front == m_queue.size())
         {
-            m_condition_variable.wait(lock);
+            wait(lock);
         }
         
-        popped_value=m_queue.front();
-        m_queue.pop();
+        pop_front(popped_value);
+    }
+
+    // Moves all queued elements into the empty vector popped_values
+    // while holding the lock only once. The capacity of popped_values
+    // is handed over to the queue, i.e. passing the same cleared vector
+    // each time needs no allocations.
+    void wait_and_pop_all(std::vector<T>& popped_values)
+    {
+        boost::mutex::scoped_lock lock(m_mutex, boost::defer_lock);
+        acquire(lock);
+        while(m_front == m_queue.size())
+        {
+            wait(lock);
+        }
+
+        if (m_front == 0)
+        {
+            m_queue.swap(popped_values);
+        }
+        else
+        {
+            popped_values.insert(popped_values.end(),
+                                 std::make_move_iterator(m_queue.begin() + m_front),
+                                 std::make_move_iterator(m_queue.end()));
+            m_queue.clear();
+            m_front = 0;
+        }
     }
+
+    const queue_counters& counters() const {return m_counters;}
 };
 
 #endif
@@ -0,0 +1,37 @@
+//
+// Inter Thread Communication - Pooled Events
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// make_pooled_event<Event>(args...) is a replacement for
+// boost::make_shared<Event>(args...) for events sent at a high rate,
+// e.g. one per packet or frame. Event and reference count are allocated
+// in one block taken from a free list of blocks with the same size.
+// Released blocks are returned to the free list instead of the heap.
+// Thus after the first few events no heap allocation is done anymore.
+//
+// The free list is protected by a mutex, i.e. events may be created in
+// one thread and released in another one. The memory is kept until the
+// process terminates.
+//
+
+#ifndef EVENT_POOL_HPP
+#define EVENT_POOL_HPP
+
+#include <boost/make_shared.hpp>
+#include <boost/pool/pool_alloc.hpp>
+#include <boost/shared_ptr.hpp>
+#include <utility>
+
+template<class Event, class... Args>
+boost::shared_ptr<Event> make_pooled_event(Args&&... args)
+{
+    return boost::allocate_shared<Event>(boost::fast_pool_allocator<Event>(),
+					 std::forward<Args>(args)...);
+}
+
+#endif
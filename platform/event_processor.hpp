@@ -12,45 +12,227 @@
 #define EVENT_PROCESSOR_HPP
 
 #include "platform/concurrent_queue.hpp"
+#include "platform/unique_function.hpp"
+#include "platform/event_trace.hpp"
 #include "platform/timer.hpp"
 #include "platform/Logging.hpp"
+#ifdef EVENT_STATISTICS_ENABLED
+#include "platform/event_statistics.hpp"
+#endif
 
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
+#include <map>
 #include <memory>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 struct QuitEvent
 {
 };
 
-template<class Event, class EventReceiver>
-void unique_dispatch(void (EventReceiver::*process_fct)(std::unique_ptr<Event>),
-		     EventReceiver* obj,
-		     Event* data_ptr)
+// Function object queued for each event. It owns the event, i.e. a
+// boost::shared_ptr or a std::unique_ptr, until the process method is
+// called. Its size fits into the in-place buffer of unique_function.
+template<class EventPtr, class EventReceiver>
+class process_call
+{
+public:
+    typedef void (EventReceiver::*process_fct_t)(EventPtr);
+    typedef typename EventPtr::element_type event_type;
+
+#ifndef EVENT_STATISTICS_ENABLED
+    process_call(process_fct_t process_fct, EventReceiver* obj, EventPtr&& event)
+	: m_process_fct(process_fct),
+	  m_obj(obj),
+	  m_event(std::move(event)),
+	  m_flow_id(event_trace::enabled() ? event_trace::instance().flow_start(typeid(event_type)) : 0)
+    {}
+#else
+    process_call(process_fct_t process_fct, EventReceiver* obj, EventPtr&& event,
+		 event_statistics* statistics)
+	: m_process_fct(process_fct),
+	  m_obj(obj),
+	  m_event(std::move(event)),
+	  m_flow_id(event_trace::enabled() ? event_trace::instance().flow_start(typeid(event_type)) : 0),
+	  m_statistics(statistics),
+	  m_queue_time(statistics->queued())
+    {}
+#endif
+
+    process_call(process_call&& other)
+	: m_process_fct(other.m_process_fct),
+	  m_obj(other.m_obj),
+	  m_event(std::move(other.m_event)),
+	  m_flow_id(other.m_flow_id)
+#ifdef EVENT_STATISTICS_ENABLED
+	, m_statistics(other.m_statistics),
+	  m_queue_time(other.m_queue_time)
+#endif
+    {}
+
+    void operator()()
+    {
+#ifdef EVENT_STATISTICS_ENABLED
+	int type_id = event_type_registry::id<EventReceiver, event_type>();
+	uint64_t dispatch_time = m_statistics->dispatching(type_id, m_queue_time);
+#endif
+
+	if (m_flow_id)
+	{
+	    traced_process();
+	}
+	else
+	{
+	    ((*m_obj).*(m_process_fct))(std::move(m_event));
+	}
+
+#ifdef EVENT_STATISTICS_ENABLED
+	m_statistics->processed(type_id, dispatch_time);
+#endif
+    }
+
+private:
+    void traced_process()
+    {
+	double pts = 0;
+	bool has_pts = m_event && event_trace_pts<event_type>::get(*m_event, pts);
+	uint64_t start = event_trace::now();
+	((*m_obj).*(m_process_fct))(std::move(m_event));
+	event_trace::instance().slice(typeid(event_type), typeid(EventReceiver), m_flow_id,
+				      start, event_trace::now(), has_pts, pts);
+    }
+
+    process_fct_t m_process_fct;
+    EventReceiver* m_obj;
+    EventPtr m_event;
+    // Non-zero if the event is traced, see event_trace.hpp:
+    uint64_t m_flow_id;
+#ifdef EVENT_STATISTICS_ENABLED
+    event_statistics* m_statistics;
+    uint64_t m_queue_time;
+#endif
+};
+
+// Events of the control lane overtake all events already queued in the
+// normal lane. The order of the events within a lane is kept. Event
+// types are moved into the control lane with CONTROL_LANE_EVENT, the
+// process methods of the event receivers are not affected.
+enum event_lane_t
+{
+    normal_lane,
+    control_lane
+};
+
+template<class Event>
+struct event_lane
+{
+    static const event_lane_t value = normal_lane;
+};
+
+#define CONTROL_LANE_EVENT(Event)                       \
+template<>                                              \
+struct event_lane<Event>                                \
+{                                                       \
+    static const event_lane_t value = control_lane;     \
+};
+
+// Function object queued into the control lane:
+template<class EventPtr, class EventReceiver, class EventProcessor>
+class control_call
+{
+public:
+    control_call(process_call<EventPtr, EventReceiver>&& call, EventProcessor* processor,
+		 EventReceiver* obj)
+	: m_call(std::move(call)),
+	  m_processor(processor),
+	  m_obj(obj)
+    {}
+
+    control_call(control_call&& other)
+	: m_call(std::move(other.m_call)),
+	  m_processor(other.m_processor),
+	  m_obj(other.m_obj)
+    {}
+
+    void operator()()
+    {
+	typedef typename EventPtr::element_type event_type;
+	m_processor->template overtaking<event_type>(m_obj)++;
+	m_call();
+    }
+
+private:
+    process_call<EventPtr, EventReceiver> m_call;
+    EventProcessor* m_processor;
+    EventReceiver* m_obj;
+};
+
+// Function object queued into the normal lane at the position the
+// control event would have had without overtaking:
+template<class Event, class EventProcessor>
+class control_mark
 {
-    std::unique_ptr<Event> event(data_ptr);
-    ((*obj).*(process_fct))(std::move(event));
-}
+public:
+    control_mark(EventProcessor* processor, const void* obj)
+	: m_processor(processor),
+	  m_obj(obj)
+    {}
+
+    void operator()()
+    {
+	m_processor->template overtaken<Event>(m_obj);
+    }
+
+private:
+    EventProcessor* m_processor;
+    const void* m_obj;
+};
 
-typedef boost::function<void ()> receive_fct_t;
+typedef unique_function receive_fct_t;
 
 template<class concurrent_queue = concurrent_queue<receive_fct_t> >
 class event_processor
 {
     friend class timer;
+    template<class, class, class> friend class control_call;
+    template<class, class> friend class control_mark;
 
-    typedef boost::function<void ()> receive_fct_t;
+    typedef unique_function receive_fct_t;
     typedef boost::function<void ()> timeout_fct_t;
     typedef boost::function<void ()> main_loop_fct_t;
     typedef concurrent_queue events_queue_t;
 
     events_queue_t m_events_queue;
+    events_queue_t m_control_events_queue;
     events_queue_t m_deferred_events_queue;
     bool m_quit;
 
+    // Number of control events per receiver and type that are
+    // processed, but whose control_mark is not yet reached. Receivers
+    // sharing the event_processor don't see each other's control events,
+    // e.g. a control event forwarded to another receiver, whose mark is
+    // queued behind newer data events of the forwarding receiver.
+    typedef std::pair<const void*, std::type_index> overtaking_key_t;
+    std::map<overtaking_key_t, int> m_overtaking;
+
+    // Events taken from m_events_queue with a single lock operation.
+    // The events from m_batch_pos on are not yet processed. The vector
+    // is cleared, but never shrunk, see concurrent_queue:
+    std::vector<receive_fct_t> m_batch;
+    size_t m_batch_pos;
+
+#ifdef EVENT_STATISTICS_ENABLED
+    event_statistics m_statistics;
+#endif
+
 public:
-    event_processor() : m_quit(false) {}
+    event_processor() : m_quit(false), m_batch_pos(0) {}
     ~event_processor() {}
 
     // Simple main loop to be executed within an own thread:
@@ -90,14 +272,31 @@ public:
     void dequeue_and_process()
     {
 	receive_fct_t func;
-	m_events_queue.wait_and_pop(func);
+	if (!m_control_events_queue.try_pop(func))
+	{
+	    if (m_batch_pos == m_batch.size())
+	    {
+		// Take all pending events at once. They are processed in
+		// FIFO order before the queue is accessed again:
+		m_batch.clear();
+		m_batch_pos = 0;
+		m_events_queue.wait_and_pop_all(m_batch);
+	    }
+
+	    // Woken up by the control_mark of a control event:
+	    if (!m_control_events_queue.try_pop(func))
+	    {
+		func = std::move(m_batch[m_batch_pos++]);
+	    }
+	}
+
 	func();
     }
 
     // Process all queued events and return. GUI main loops are using this function:
     void dequeue_and_process_until_empty()
     {
-	while(!empty())
+	while(!empty() && !terminating())
 	{
 	    dequeue_and_process();
 	}
@@ -105,7 +304,17 @@ public:
 
     // Callbacks needed to implement a custom main loop:
     bool terminating() {return m_quit;}
-    bool empty() {return m_events_queue.empty();}
+    bool empty() {return m_batch_pos == m_batch.size() && m_events_queue.empty() && m_control_events_queue.empty();}
+
+    // Returns true while an event is processed that was queued before an
+    // already processed control event of type Event for the same
+    // receiver obj. The receiver of a FlushReq uses this to discard
+    // data events from before the flush.
+    template<class Event>
+    bool overtaken_by(const void* obj)
+    {
+	return m_overtaking.find(overtaking_key<Event>(obj)) != m_overtaking.end();
+    }
 
     void terminate() {m_quit = true;}
 
@@ -113,36 +322,20 @@ public:
     template<class Event, class EventReceiver>
     void queue_event(boost::shared_ptr<Event> event, EventReceiver* obj)
     {
-	typedef void (EventReceiver::*process_fct_t)(boost::shared_ptr<Event>);
-	// tmp variable avoids a static_cast<>
-	process_fct_t tmp = &EventReceiver::process;
-	receive_fct_t fct = boost::bind(tmp, obj, event);
-	m_events_queue.push(fct);
+	queue_in_lane<Event>(std::move(event), obj);
     }
 
     template<class Event, class EventReceiver>
     void queue_event(std::unique_ptr<Event> event, EventReceiver* obj)
     {
-	typedef void (EventReceiver::*process_fct_t)(std::unique_ptr<Event>);
-	process_fct_t tmp = &EventReceiver::process;
-
-	// Binding a unique_ptr parameter is not possible:
-	Event* ptr = event.release();
-	receive_fct_t fct = std::bind(unique_dispatch<Event, EventReceiver>, tmp, obj, ptr);
-	
-	// Here the function object is copied, this would not work,
-	// if the function object contains a unique_ptr:
-	m_events_queue.push(fct);
+	queue_in_lane<Event>(std::move(event), obj);
     }
 
+    // Deferred events are always queued into the normal lane:
     template<class Event, class EventReceiver>
     void defer_event(boost::shared_ptr<Event> event, EventReceiver* obj)
     {
-	typedef void (EventReceiver::*process_fct_t)(boost::shared_ptr<Event>);
-	// tmp variable avoids a static_cast<>
-	process_fct_t tmp = &EventReceiver::process;
-	receive_fct_t fct = boost::bind(tmp, obj, event);
-	m_deferred_events_queue.push(fct);
+	m_deferred_events_queue.push(receive_fct_t(make_process_call(std::move(event), obj)));
     }
 
     void queue_deferred_events()
@@ -150,19 +343,20 @@ public:
 	receive_fct_t fct;
 	while(m_deferred_events_queue.try_pop(fct))
 	{
-	    m_events_queue.push(fct);
+	    m_events_queue.push(std::move(fct));
 	}
     }
 
     template<class Event, class EventReceiver>
     void start_timer(boost::shared_ptr<Event> event, EventReceiver* obj, timer& tmr)
     {
-	typedef void (EventReceiver::*process_fct_t)(boost::shared_ptr<Event>);
+	// The timeout function may be called more than once, e.g. for
+	// periodic timers. It creates a new function object each time:
+	typedef void (event_processor::*queue_fct_t)(boost::shared_ptr<Event>, EventReceiver*);
 	// tmp variable avoids a static_cast<>
-	process_fct_t tmp = &EventReceiver::process;
-	receive_fct_t fct = boost::bind(tmp, obj, event);
-	timeout_fct_t fct2 = boost::bind(&event_processor::timeout, this, fct);
-	tmr.start_timer(fct2);
+	queue_fct_t tmp = &event_processor::queue_event;
+	timeout_fct_t fct = boost::bind(tmp, this, event, obj);
+	tmr.start_timer(fct);
     }
 
     void stop_timer(timer& tmr)
@@ -182,6 +376,21 @@ public:
 	m_events_queue.attach(fct);
     }
 
+    // Writes a snapshot of the event statistics. May be called by any thread.
+    // Deferred events are counted as queued until they are processed.
+    void dump_statistics(std::ostream& strm, const std::string& name)
+    {
+#ifdef EVENT_STATISTICS_ENABLED
+	m_statistics.dump(strm, name);
+#else
+	strm << "Event statistics " << name << ": not enabled" << std::endl;
+#endif
+	// Always counted, only the slow paths update them:
+	strm << "Queue statistics " << name << ": ";
+	m_events_queue.counters().dump(strm);
+	strm << std::endl;
+    }
+
 private:
     void process(boost::shared_ptr<QuitEvent>)
     {
@@ -189,9 +398,58 @@ private:
 	terminate();
     }
 
-    void timeout(receive_fct_t fct)
+    template<class Event, class EventPtr, class EventReceiver>
+    void queue_in_lane(EventPtr&& event, EventReceiver* obj)
+    {
+	if (event_lane<Event>::value == normal_lane)
+	{
+	    m_events_queue.push(receive_fct_t(make_process_call(std::move(event), obj)));
+	}
+	else
+	{
+	    typedef control_call<EventPtr, EventReceiver, event_processor> control_call_t;
+	    typedef control_mark<Event, event_processor> control_mark_t;
+	    m_control_events_queue.push(receive_fct_t(control_call_t(make_process_call(std::move(event), obj), this, obj)));
+	    // Also wakes up the thread waiting for m_events_queue:
+	    m_events_queue.push(receive_fct_t(control_mark_t(this, obj)));
+	}
+    }
+
+    template<class EventPtr, class EventReceiver>
+    process_call<EventPtr, EventReceiver> make_process_call(EventPtr&& event, EventReceiver* obj)
+    {
+	typedef process_call<EventPtr, EventReceiver> process_call_t;
+	// tmp variable avoids a static_cast<>
+	typename process_call_t::process_fct_t tmp = &EventReceiver::process;
+#ifndef EVENT_STATISTICS_ENABLED
+	return process_call_t(tmp, obj, std::move(event));
+#else
+	return process_call_t(tmp, obj, std::move(event), &m_statistics);
+#endif
+    }
+
+    template<class Event>
+    static overtaking_key_t overtaking_key(const void* obj)
+    {
+	return overtaking_key_t(obj, std::type_index(typeid(Event)));
+    }
+
+    template<class Event>
+    int& overtaking(const void* obj)
+    {
+	return m_overtaking[overtaking_key<Event>(obj)];
+    }
+
+    // Entries are removed when reaching 0, see overtaken_by():
+    template<class Event>
+    void overtaken(const void* obj)
     {
-	m_events_queue.push(fct);
+	typename std::map<overtaking_key_t, int>::iterator it =
+	    m_overtaking.find(overtaking_key<Event>(obj));
+	if (--it->second == 0)
+	{
+	    m_overtaking.erase(it);
+	}
     }
 };
 
@@ -63,6 +63,12 @@ public:
 	m_event_processor->stop_timer(t);
     }
 
+    template<class Event>
+    bool overtaken_by()
+    {
+	return m_event_processor->template overtaken_by<Event>(static_cast<most_derived*>(this));
+    }
+
 protected:
     event_receiver(event_processor_ptr_type evt_proc)
 	: m_event_processor(evt_proc)
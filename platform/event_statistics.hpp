@@ -0,0 +1,285 @@
+//
+// Inter Thread Communication - Event Statistics
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// Each event_processor records per receiver and event type the time
+// from queueing an event until its process method is called (latency),
+// the execution time of the process method and the high-water mark of
+// its queue. Receivers sharing an event_processor, e.g. VideoDecoder
+// and Deinterlacer, get separate rows for the same event type.
+//
+// Statistics are only collected when compiled with
+// EVENT_STATISTICS_ENABLED, see configure --enable-event-statistics.
+// Otherwise event_processor does not contain any instrumentation code.
+//
+// All histograms of an event_processor are only written by the thread
+// executing it. Relaxed atomic loads and stores are sufficient, they
+// allow to read a snapshot from any other thread without locking.
+//
+
+#ifndef EVENT_STATISTICS_HPP
+#define EVENT_STATISTICS_HPP
+
+#include <atomic>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+#include <cxxabi.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+// -------------------------------------------------------------------
+// Dense ids for pairs of receiver and event type, assigned when the
+// receiver processes the event type first:
+
+class event_type_registry
+{
+public:
+    static const int max_event_types = 256;
+
+    template<class EventReceiver, class Event>
+    static int id()
+    {
+	static const int s_id = register_type(typeid(EventReceiver), typeid(Event));
+	return s_id;
+    }
+
+    static int size()
+    {
+	int n = counter().load(std::memory_order_acquire);
+	return n < max_event_types ? n : max_event_types;
+    }
+
+    // E.g. "Deinterlacer: std::unique_ptr<XFVideoImage>":
+    static std::string name(int id)
+    {
+	const std::type_info* receiver = receivers()[id].load(std::memory_order_acquire);
+	const std::type_info* event = types()[id].load(std::memory_order_acquire);
+	if (!receiver || !event)
+	{
+	    return std::string("?");
+	}
+
+	// The template arguments of a receiver are only the queue type:
+	std::string receiver_name = demangle(*receiver);
+	return receiver_name.substr(0, receiver_name.find('<')) + ": " + demangle(*event);
+    }
+
+private:
+    static int register_type(const std::type_info& receiver, const std::type_info& event)
+    {
+	int id = counter().fetch_add(1);
+	if (id >= max_event_types)
+	{
+	    // Table is full, all further types share the last entry:
+	    return max_event_types - 1;
+	}
+	receivers()[id].store(&receiver, std::memory_order_release);
+	types()[id].store(&event, std::memory_order_release);
+	return id;
+    }
+
+    static std::string demangle(const std::type_info& ti)
+    {
+	int status;
+	char* demangled = abi::__cxa_demangle(ti.name(), 0, 0, &status);
+	std::string result(status == 0 ? demangled : ti.name());
+	free(demangled);
+	return result;
+    }
+
+    static std::atomic<int>& counter()
+    {
+	static std::atomic<int> s_counter(0);
+	return s_counter;
+    }
+
+    static std::atomic<const std::type_info*>* receivers()
+    {
+	static std::atomic<const std::type_info*> s_receivers[max_event_types];
+	return s_receivers;
+    }
+
+    static std::atomic<const std::type_info*>* types()
+    {
+	static std::atomic<const std::type_info*> s_types[max_event_types];
+	return s_types;
+    }
+};
+
+// -------------------------------------------------------------------
+
+inline uint64_t get_monotonic_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Histogram with logarithmic buckets. Bucket i counts values
+// in the range [2^(i-1), 2^i) microseconds.
+class event_histogram
+{
+public:
+    static const int num_buckets = 26;
+
+    event_histogram()
+    {
+	for (int i = 0; i < num_buckets; i++)
+	{
+	    m_buckets[i].store(0, std::memory_order_relaxed);
+	}
+	m_count.store(0, std::memory_order_relaxed);
+	m_sum_ns.store(0, std::memory_order_relaxed);
+	m_max_ns.store(0, std::memory_order_relaxed);
+    }
+
+    // Must only be called by the owning thread:
+    void add(uint64_t ns)
+    {
+	uint64_t us = ns / 1000;
+	int bucket = 0;
+	while (us && bucket < num_buckets - 1)
+	{
+	    us >>= 1;
+	    bucket++;
+	}
+
+	increment(m_buckets[bucket], 1);
+	increment(m_count, 1);
+	increment(m_sum_ns, ns);
+	if (ns > m_max_ns.load(std::memory_order_relaxed))
+	{
+	    m_max_ns.store(ns, std::memory_order_relaxed);
+	}
+    }
+
+    uint64_t count() const {return m_count.load(std::memory_order_relaxed);}
+    uint64_t max_ns() const {return m_max_ns.load(std::memory_order_relaxed);}
+
+    uint64_t average_ns() const
+    {
+	uint64_t n = count();
+	return n ? m_sum_ns.load(std::memory_order_relaxed) / n : 0;
+    }
+
+    // Upper bound of the bucket containing the given percentile,
+    // but not more than the maximum value:
+    uint64_t percentile_us(int percent) const
+    {
+	uint64_t n = count();
+	uint64_t limit = (n * percent + 99) / 100;
+	uint64_t max_us = max_ns() / 1000;
+	uint64_t sum = 0;
+	for (int i = 0; i < num_buckets; i++)
+	{
+	    sum += m_buckets[i].load(std::memory_order_relaxed);
+	    if (sum >= limit)
+	    {
+		uint64_t bound = uint64_t(1) << i;
+		return bound < max_us ? bound : max_us;
+	    }
+	}
+	return max_us;
+    }
+
+private:
+    static void increment(std::atomic<uint64_t>& var, uint64_t val)
+    {
+	// Single writer, a locked read-modify-write operation is not needed:
+	var.store(var.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_buckets[num_buckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum_ns;
+    std::atomic<uint64_t> m_max_ns;
+};
+
+// -------------------------------------------------------------------
+
+class event_statistics
+{
+public:
+    event_statistics()
+	: m_queued(0),
+	  m_high_water_mark(0)
+    {}
+
+    // Called by the thread queueing an event:
+    uint64_t queued()
+    {
+	int queued = m_queued.fetch_add(1, std::memory_order_relaxed) + 1;
+	int hwm = m_high_water_mark.load(std::memory_order_relaxed);
+	while (queued > hwm &&
+	       !m_high_water_mark.compare_exchange_weak(hwm, queued,
+							std::memory_order_relaxed))
+	{}
+	return get_monotonic_time_ns();
+    }
+
+    // Called by the thread processing the event:
+    uint64_t dispatching(int type_id, uint64_t queue_time)
+    {
+	m_queued.fetch_sub(1, std::memory_order_relaxed);
+	uint64_t now = get_monotonic_time_ns();
+	m_entries[type_id].latency.add(now - queue_time);
+	return now;
+    }
+
+    void processed(int type_id, uint64_t dispatch_time)
+    {
+	m_entries[type_id].execution.add(get_monotonic_time_ns() - dispatch_time);
+    }
+
+    void dump(std::ostream& strm, const std::string& name) const
+    {
+	strm << "Event statistics " << name
+	     << ": queued=" << m_queued.load(std::memory_order_relaxed)
+	     << ", high-water mark=" << m_high_water_mark.load(std::memory_order_relaxed)
+	     << std::endl;
+
+	strm << "  " << std::setw(10) << "count"
+	     << " | latency[us]: " << std::setw(8) << "avg" << std::setw(8) << "p99" << std::setw(8) << "max"
+	     << " | execution[us]: " << std::setw(8) << "avg" << std::setw(8) << "p99" << std::setw(8) << "max"
+	     << " | receiver: event" << std::endl;
+
+	for (int i = 0; i < event_type_registry::size(); i++)
+	{
+	    const entry_type& e = m_entries[i];
+	    if (e.latency.count() == 0)
+	    {
+		continue;
+	    }
+
+	    strm << "  " << std::setw(10) << e.latency.count()
+		 << " |              " << std::setw(8) << e.latency.average_ns() / 1000
+		 << std::setw(8) << e.latency.percentile_us(99)
+		 << std::setw(8) << e.latency.max_ns() / 1000
+		 << " |                " << std::setw(8) << e.execution.average_ns() / 1000
+		 << std::setw(8) << e.execution.percentile_us(99)
+		 << std::setw(8) << e.execution.max_ns() / 1000
+		 << " | " << event_type_registry::name(i) << std::endl;
+	}
+    }
+
+private:
+    struct entry_type
+    {
+	event_histogram latency;
+	event_histogram execution;
+    };
+
+    entry_type m_entries[event_type_registry::max_event_types];
+    std::atomic<int> m_queued;
+    std::atomic<int> m_high_water_mark;
+};
+
+#endif
@@ -0,0 +1,342 @@
+//
+// Inter Thread Communication - Event Trace
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// Records the event flow between event_processors and writes it in the
+// Trace Event Format used by chrome://tracing and Perfetto. Each process
+// method call is a slice on the track of the executing thread, named
+// after the event type. Flow arrows connect the point where an event is
+// queued with the slice processing it.
+//
+// Tracing is enabled by setting SINEMA_TRACE to the name of the output
+// file, which is written when the process terminates. Memory is bounded:
+// only the last SINEMA_TRACE_EVENTS records (default 262144) are kept.
+//
+// Specialize event_trace_pts to show the presentation timestamp of an
+// event type as argument of its slices.
+//
+// Each thread track is named after the event receivers whose process
+// methods were called in it, e.g. "VideoDecoder, AudioDecoder". Threads
+// only queueing events are named with set_thread_name, see
+// thread_name.hpp.
+//
+
+#ifndef EVENT_TRACE_HPP
+#define EVENT_TRACE_HPP
+
+#include "platform/Logging.hpp"
+#include "platform/thread_name.hpp"
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include <cxxabi.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+template<class Event>
+struct event_trace_pts
+{
+    static bool get(const Event&, double&)
+    {
+	return false;
+    }
+};
+
+class event_trace : private boost::noncopyable
+{
+public:
+    static bool enabled()
+    {
+	static const bool s_enabled = getenv("SINEMA_TRACE") != 0;
+	return s_enabled;
+    }
+
+    static event_trace& instance()
+    {
+	// Never deleted, other threads may still queue events while
+	// the process terminates:
+	static event_trace* s_instance = new event_trace();
+	static exit_writer s_exit_writer(s_instance);
+	return *s_instance;
+    }
+
+    static uint64_t now()
+    {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    // Called by the thread queueing an event. Returns the flow id:
+    uint64_t flow_start(const std::type_info& type)
+    {
+	uint64_t flow_id = m_next_flow_id.fetch_add(1, std::memory_order_relaxed);
+	record_type& r = allocate();
+	r.phase = 's';
+	r.time = now();
+	r.duration = 0;
+	r.flow_id = flow_id;
+	r.type = &type;
+	r.has_pts = false;
+	r.pts = 0;
+	publish(r);
+	return flow_id;
+    }
+
+    // Called by the thread processing the event:
+    void slice(const std::type_info& type, const std::type_info& receiver,
+	       uint64_t flow_id, uint64_t start, uint64_t end, bool has_pts, double pts)
+    {
+	add_receiver(receiver);
+	record_type& r = allocate();
+	r.phase = 'X';
+	r.time = start;
+	r.duration = end - start;
+	r.flow_id = flow_id;
+	r.type = &type;
+	r.has_pts = has_pts;
+	r.pts = pts;
+	publish(r);
+    }
+
+private:
+    struct thread_info
+    {
+	std::vector<std::string> receivers;
+    };
+
+    struct record_type
+    {
+	// Index + 1 of the record when completely written, 0 otherwise:
+	std::atomic<uint64_t> seq;
+	uint64_t index;
+	char phase;
+	pid_t tid;
+	uint64_t time;
+	uint64_t duration;
+	uint64_t flow_id;
+	const std::type_info* type;
+	bool has_pts;
+	double pts;
+    };
+
+    struct exit_writer
+    {
+	exit_writer(event_trace* trace) : m_trace(trace) {}
+	~exit_writer() {m_trace->write();}
+	event_trace* m_trace;
+    };
+
+    event_trace()
+	: m_capacity(262144),
+	  m_next_index(0),
+	  m_next_flow_id(1)
+    {
+	const char* events = getenv("SINEMA_TRACE_EVENTS");
+	if (events && atol(events) > 0)
+	{
+	    m_capacity = atol(events);
+	}
+
+	m_records = new record_type[m_capacity];
+	for (uint64_t i = 0; i < m_capacity; i++)
+	{
+	    m_records[i].seq.store(0, std::memory_order_relaxed);
+	}
+    }
+
+    // The records are used as a ring buffer. Writing the same record
+    // concurrently would need m_capacity other records to be written
+    // meanwhile, which does not happen for any sensible capacity.
+    record_type& allocate()
+    {
+	uint64_t index = m_next_index.fetch_add(1, std::memory_order_relaxed);
+	record_type& r = m_records[index % m_capacity];
+	r.seq.store(0, std::memory_order_relaxed);
+	r.index = index;
+	r.tid = thread_id();
+	return r;
+    }
+
+    // Each receiver type is looked up only once per thread:
+    void add_receiver(const std::type_info& receiver)
+    {
+	static const int max_cached = 8;
+	static __thread const std::type_info* s_receivers[max_cached];
+	static __thread int s_num_receivers = 0;
+
+	for (int i = 0; i < s_num_receivers; i++)
+	{
+	    if (s_receivers[i] == &receiver)
+	    {
+		return;
+	    }
+	}
+	if (s_num_receivers < max_cached)
+	{
+	    s_receivers[s_num_receivers++] = &receiver;
+	}
+
+	// Without template arguments:
+	std::string receiver_name = name(&receiver);
+	receiver_name = receiver_name.substr(0, receiver_name.find('<'));
+
+	pid_t tid = thread_id();
+	boost::mutex::scoped_lock lock(m_threads_mutex);
+	std::vector<std::string>& receivers = m_threads[tid].receivers;
+	for (std::vector<std::string>::iterator it = receivers.begin(); it != receivers.end(); it++)
+	{
+	    if (*it == receiver_name)
+	    {
+		return;
+	    }
+	}
+	receivers.push_back(receiver_name);
+    }
+
+    void publish(record_type& r)
+    {
+	r.seq.store(r.index + 1, std::memory_order_release);
+    }
+
+    // Also registers the thread when called the first time:
+    pid_t thread_id()
+    {
+	static __thread pid_t s_tid = 0;
+	if (!s_tid)
+	{
+	    s_tid = gettid();
+	    boost::mutex::scoped_lock lock(m_threads_mutex);
+	    m_threads[s_tid];
+	}
+	return s_tid;
+    }
+
+    std::string thread_name(pid_t tid, const thread_info& info)
+    {
+	std::string explicit_name = thread_names::get(tid);
+	if (!explicit_name.empty())
+	{
+	    return explicit_name;
+	}
+	if (info.receivers.empty())
+	{
+	    std::stringstream name;
+	    name << "thread " << tid;
+	    return name.str();
+	}
+	std::string name = info.receivers[0];
+	for (size_t i = 1; i < info.receivers.size(); i++)
+	{
+	    name += ", " + info.receivers[i];
+	}
+	return name;
+    }
+
+    static std::string name(const std::type_info* type)
+    {
+	int status;
+	char* demangled = abi::__cxa_demangle(type->name(), 0, 0, &status);
+	std::string result(status == 0 ? demangled : type->name());
+	free(demangled);
+	return result;
+    }
+
+    void write()
+    {
+	const char* fileName = getenv("SINEMA_TRACE");
+	std::ofstream file(fileName);
+	if (!file.is_open())
+	{
+	    return;
+	}
+
+	pid_t pid = getpid();
+	bool first = true;
+
+	file << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+
+	// One metadata record per thread naming its track:
+	{
+	    boost::mutex::scoped_lock lock(m_threads_mutex);
+	    for (std::map<pid_t, thread_info>::iterator it = m_threads.begin(); it != m_threads.end(); it++)
+	    {
+		file << (first ? "\n" : ",\n");
+		first = false;
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\""
+		     << ",\"pid\":" << pid << ",\"tid\":" << it->first
+		     << ",\"args\":{\"name\":\"" << thread_name(it->first, it->second) << "\"}}";
+	    }
+	}
+
+	for (uint64_t i = 0; i < m_capacity; i++)
+	{
+	    const record_type& r = m_records[i];
+	    uint64_t seq = r.seq.load(std::memory_order_acquire);
+	    if (seq == 0)
+	    {
+		continue;
+	    }
+
+	    std::string event_name = name(r.type);
+	    double ts = double(r.time) / 1000;
+
+	    file << (first ? "\n" : ",\n");
+	    first = false;
+
+	    if (r.phase == 's')
+	    {
+		file << "{\"name\":\"" << event_name << "\",\"cat\":\"event\",\"ph\":\"s\""
+		     << ",\"id\":" << r.flow_id
+		     << ",\"pid\":" << pid << ",\"tid\":" << r.tid
+		     << ",\"ts\":" << ts << "}";
+	    }
+	    else
+	    {
+		file << "{\"name\":\"" << event_name << "\",\"cat\":\"event\",\"ph\":\"X\""
+		     << ",\"pid\":" << pid << ",\"tid\":" << r.tid
+		     << ",\"ts\":" << ts
+		     << ",\"dur\":" << double(r.duration) / 1000;
+		if (r.has_pts)
+		{
+		    file << ",\"args\":{\"pts\":" << r.pts << "}";
+		}
+		file << "},\n";
+
+		// Flow arrow ends at the enclosing slice:
+		file << "{\"name\":\"" << event_name << "\",\"cat\":\"event\",\"ph\":\"f\",\"bp\":\"e\""
+		     << ",\"id\":" << r.flow_id
+		     << ",\"pid\":" << pid << ",\"tid\":" << r.tid
+		     << ",\"ts\":" << ts << "}";
+	    }
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    }
+
+    uint64_t m_capacity;
+    record_type* m_records;
+    std::atomic<uint64_t> m_next_index;
+    std::atomic<uint64_t> m_next_flow_id;
+
+    // Threads that wrote records:
+    boost::mutex m_threads_mutex;
+    std::map<pid_t, thread_info> m_threads;
+};
+
+#endif
@@ -23,6 +23,11 @@
 #include <boost/mpl/empty.hpp>
 #include <boost/mpl/remove_if.hpp>
 #include <boost/mpl/find_if.hpp>
+#include <boost/mpl/eval_if.hpp>
+#include <boost/mpl/identity.hpp>
+#include <boost/mpl/apply.hpp>
+#include <boost/mpl/deref.hpp>
+#include <boost/mpl/size.hpp>
 #include <boost/type_traits/is_same.hpp>
 
 namespace itf {
@@ -297,6 +302,69 @@ struct get_message_id
 	
 };
 
+// has_message_id<Id>::apply<Message>::type
+//     A metafunction class returning true when Message has the unique id Id.
+
+template<int Id>
+struct has_message_id
+{
+    template<typename Message>
+    struct apply
+    {
+	typedef boost::mpl::bool_<Message::msg_id::value == Id> type;
+    };
+};
+
+// get_event_by_id<Id, MessageList>::type
+//     A metafunction returning the Event with the unique id Id, or none if
+//     MessageList contains no such Event. Proxy template classes are using
+//     this to map the id received from the peer back to the Event type.
+
+template<int Id,
+	 typename MessageList>
+struct get_event_by_id
+{
+    typedef typename boost::mpl::find_if<
+	MessageList,
+	has_message_id<Id>
+    >::type iter;
+
+    typedef typename boost::mpl::eval_if<
+	boost::is_same<iter, typename boost::mpl::end<MessageList>::type>,
+	boost::mpl::identity<none>,
+	boost::mpl::apply1<get_event, typename boost::mpl::deref<iter>::type>
+    >::type type;
+};
+
+// num_message_ids<Interface>::value
+//     The unique ids assigned to the Procedures of Interface are in the 
+//     range 1 ... num_message_ids<Interface>::value - 1.
+
+template<typename Interface>
+struct num_message_ids
+{
+    static const int value = boost::mpl::size<typename Interface::type>::value + 1;
+};
+
+// make_indices<N>::type
+//     Returns indices<0, 1, ..., N-1>. Used to expand a parameter pack
+//     over all unique ids, e.g. to initialize a dispatch table.
+
+template<int... Indices>
+struct indices
+{};
+
+template<int N, int... Indices>
+struct make_indices
+    : make_indices<N-1, N-1, Indices...>
+{};
+
+template<int... Indices>
+struct make_indices<0, Indices...>
+{
+    typedef indices<Indices...> type;
+};
+
 // -------------------------------------------------------------------
 
 }
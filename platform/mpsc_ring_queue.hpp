@@ -0,0 +1,306 @@
+//
+// Lock-Free bounded multiple Producer, single Consumer Queue
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// The ring buffer uses a sequence number per cell as described by
+// Dmitry Vyukov, see
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+// Only the consumer may call try_pop and wait_and_pop. This is always
+// the case for an event_processor, it is executed by a single thread.
+// The consumer sleeps on a futex when the queue is empty. Producers
+// only issue a system call when the consumer is sleeping.
+//
+// When the ring is full, elements are appended to a mutex protected
+// overflow list until the consumer has emptied it. Events are never
+// dropped and a producer never waits for the consumer. This matters
+// for receivers sharing an event_processor, e.g. the VideoDecoder
+// sending frames to the Deinterlacer on the same thread.
+//
+
+#ifndef MPSC_RING_QUEUE_HPP
+#define MPSC_RING_QUEUE_HPP
+
+#include "platform/concurrent_queue.hpp"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <atomic>
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+template<typename T,
+	 class base_type = without_callback_function,
+	 size_t capacity = 1024>
+class mpsc_ring_queue : public base_type,
+			private boost::noncopyable
+{
+    static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+		  "capacity must be a power of two");
+
+    static const size_t mask = capacity - 1;
+
+    struct cell_t
+    {
+	std::atomic<size_t> sequence;
+	T data;
+    };
+
+    cell_t m_buffer[capacity];
+
+    // Each member is written by a different party. Keep them in
+    // separate cache lines to avoid false sharing:
+    char m_pad0[64];
+    std::atomic<size_t> m_enqueue_pos;
+    char m_pad1[64];
+    std::atomic<size_t> m_dequeue_pos;
+    char m_pad2[64];
+    std::atomic<int> m_wakeup;
+    std::atomic<bool> m_sleeping;
+
+    // Number of elements in m_overflow from m_overflow_front on. While
+    // it is not zero, all producers append to m_overflow to keep their
+    // elements in order. The vector keeps its capacity, see
+    // concurrent_queue:
+    std::atomic<size_t> m_overflow_size;
+    boost::mutex m_overflow_mutex;
+    std::vector<T> m_overflow;
+    size_t m_overflow_front;
+
+    queue_counters m_counters;
+
+public:
+    mpsc_ring_queue()
+	: m_enqueue_pos(0),
+	  m_dequeue_pos(0),
+	  m_wakeup(0),
+	  m_sleeping(false),
+	  m_overflow_size(0),
+	  m_overflow_front(0)
+    {
+	for (size_t i = 0; i < capacity; i++)
+	{
+	    m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+	}
+    }
+
+    void push(T const& data)
+    {
+	T tmp(data);
+	push(std::move(tmp));
+    }
+
+    void push(T&& data)
+    {
+	size_t pos;
+	cell_t* cell = 0;
+	if (m_overflow_size.load(std::memory_order_acquire) == 0)
+	{
+	    cell = reserve(pos);
+	}
+
+	if (cell)
+	{
+	    cell->data = std::move(data);
+	    cell->sequence.store(pos + 1, std::memory_order_release);
+	}
+	else
+	{
+	    m_counters.count(m_counters.overflows);
+	    boost::mutex::scoped_lock lock(m_overflow_mutex, boost::defer_lock);
+	    acquire(lock);
+	    m_overflow.push_back(std::move(data));
+	    m_overflow_size.fetch_add(1, std::memory_order_release);
+	}
+
+	wakeup_consumer();
+	this->notify();
+    }
+
+    bool empty() const
+    {
+	return !ready() && m_overflow_size.load(std::memory_order_acquire) == 0;
+    }
+
+    bool try_pop(T& popped_value)
+    {
+	if (pop_ring(popped_value))
+	{
+	    return true;
+	}
+
+	if (!overflow_ready())
+	{
+	    return false;
+	}
+
+	boost::mutex::scoped_lock lock(m_overflow_mutex, boost::defer_lock);
+	acquire(lock);
+	popped_value = std::move(m_overflow[m_overflow_front++]);
+	if (m_overflow_front == m_overflow.size())
+	{
+	    m_overflow.clear();
+	    m_overflow_front = 0;
+	}
+	m_overflow_size.fetch_sub(1, std::memory_order_release);
+	return true;
+    }
+
+    void wait_and_pop(T& popped_value)
+    {
+	while (!try_pop(popped_value))
+	{
+	    sleep();
+	}
+    }
+
+    // Moves all queued elements into the vector popped_values:
+    void wait_and_pop_all(std::vector<T>& popped_values)
+    {
+	T value;
+	while (!pop_ring(value))
+	{
+	    if (overflow_ready())
+	    {
+		boost::mutex::scoped_lock lock(m_overflow_mutex, boost::defer_lock);
+		acquire(lock);
+		popped_values.insert(popped_values.end(),
+				     std::make_move_iterator(m_overflow.begin() + m_overflow_front),
+				     std::make_move_iterator(m_overflow.end()));
+		m_overflow_size.fetch_sub(m_overflow.size() - m_overflow_front,
+					  std::memory_order_release);
+		m_overflow.clear();
+		m_overflow_front = 0;
+		return;
+	    }
+	    sleep();
+	}
+
+	do
+	{
+	    popped_values.push_back(std::move(value));
+	}
+	while (pop_ring(value));
+    }
+
+    const queue_counters& counters() const {return m_counters;}
+
+private:
+    bool ready() const
+    {
+	size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+	const cell_t& cell = m_buffer[pos & mask];
+	size_t seq = cell.sequence.load(std::memory_order_acquire);
+	return seq == pos + 1;
+    }
+
+    bool pop_ring(T& popped_value)
+    {
+	size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+	cell_t& cell = m_buffer[pos & mask];
+	size_t seq = cell.sequence.load(std::memory_order_acquire);
+	if (seq != pos + 1)
+	{
+	    return false;
+	}
+
+	m_dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+	popped_value = std::move(cell.data);
+	// Release resources owned by the element now, not when the
+	// cell is reused:
+	cell.data = T();
+	cell.sequence.store(pos + capacity, std::memory_order_release);
+	return true;
+    }
+
+    // The overflow elements follow all cells reserved before. These
+    // have to be popped first, even if they are not yet written:
+    bool overflow_ready()
+    {
+	return m_overflow_size.load(std::memory_order_acquire) != 0 &&
+	    m_enqueue_pos.load(std::memory_order_acquire) ==
+	    m_dequeue_pos.load(std::memory_order_relaxed);
+    }
+
+    void sleep()
+    {
+	int wakeup = m_wakeup.load(std::memory_order_acquire);
+	m_sleeping.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (!ready() && !overflow_ready())
+	{
+	    // Returns immediately if a producer already incremented m_wakeup:
+	    m_counters.count(m_counters.sleeps);
+	    futex(FUTEX_WAIT_PRIVATE, wakeup);
+	}
+
+	m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    void acquire(boost::mutex::scoped_lock& lock)
+    {
+	if (!lock.try_lock())
+	{
+	    m_counters.count(m_counters.contended);
+	    lock.lock();
+	}
+    }
+
+    // Returns 0 if the ring is full:
+    cell_t* reserve(size_t& pos)
+    {
+	pos = m_enqueue_pos.load(std::memory_order_relaxed);
+	while (1)
+	{
+	    cell_t* cell = &m_buffer[pos & mask];
+	    size_t seq = cell->sequence.load(std::memory_order_acquire);
+	    ptrdiff_t dif = ptrdiff_t(seq) - ptrdiff_t(pos);
+	    if (dif == 0)
+	    {
+		if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+							std::memory_order_relaxed))
+		{
+		    return cell;
+		}
+		m_counters.count(m_counters.contended);
+	    }
+	    else if (dif < 0)
+	    {
+		return 0;
+	    }
+	    else
+	    {
+		pos = m_enqueue_pos.load(std::memory_order_relaxed);
+	    }
+	}
+    }
+
+    void wakeup_consumer()
+    {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	// Only one producer has to issue the system call:
+	if (m_sleeping.exchange(false, std::memory_order_relaxed))
+	{
+	    m_counters.count(m_counters.wakeups);
+	    m_wakeup.fetch_add(1, std::memory_order_release);
+	    futex(FUTEX_WAKE_PRIVATE, 1);
+	}
+    }
+
+    long futex(int op, int val)
+    {
+	return syscall(SYS_futex, reinterpret_cast<int*>(&m_wakeup), op, val, NULL, NULL, 0);
+    }
+};
+
+#endif
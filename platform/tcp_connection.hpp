@@ -15,6 +15,7 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <string.h>
 
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
@@ -26,15 +27,11 @@
 #include <boost/mpl/contains.hpp>
 #include <boost/mpl/for_each.hpp>
 #include <boost/mpl/if.hpp>
-#include <boost/archive/text_oarchive.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/iostreams/device/array.hpp>
-#include <boost/iostreams/stream.hpp>
+#include <boost/make_shared.hpp>
 
 #include "platform/Logging.hpp"
 #include "platform/interface.hpp"
-
-typedef boost::array<boost::asio::const_buffer, 2> buffer_list_type;
+#include "platform/wire_format.hpp"
 
 template<int pos>
 inline char get_byte(unsigned int i)
@@ -44,6 +41,8 @@ inline char get_byte(unsigned int i)
 
 struct Header
 {
+    static const unsigned int max_length = 0xffff;
+
     Header() {}
     Header(unsigned int type, unsigned int length)
     {
@@ -59,62 +58,6 @@ struct Header
     unsigned char header[4];
 };
 
-inline buffer_list_type make_buffer_list(const Header& header,
-					 const std::string& body)
-{
-    // Using braces in the initializer list is not possible.
-    // The "return value optimization" should eliminate the 
-    // temporary value to hold this function's return value.
-    buffer_list_type buffers = {{ boost::asio::buffer(&header,sizeof(Header)),
-				  boost::asio::buffer(body)  }};
-    return buffers;
-}
-
-class message
-{
-public:
-    typedef boost::asio::const_buffer value_type;
-    typedef boost::array<boost::asio::const_buffer, 2> buffer_list_type;
-    typedef buffer_list_type::const_iterator const_iterator;
-
-    message(const Header& header,
-	    const std::string& body)
-	: m_header(header),
-	  m_body(body),
-	  m_buffers(make_buffer_list(m_header, m_body))
-    {
-	// TRACE_DEBUG();
-    }
-
-    message(const message& other)
-	: m_header(other.m_header),
-	  m_body(other.m_body),
-	  m_buffers(other.m_buffers)
-    {
-	// TRACE_DEBUG();
-    }
-
-    ~message()
-    {
-	// TRACE_DEBUG();
-    }
-
-    const_iterator begin() const
-    {
-	return m_buffers.begin();
-    }
-
-    const_iterator end() const
-    {
-	return m_buffers.end();
-    }
-
-private:
-    Header m_header;
-    std::string m_body;
-    buffer_list_type m_buffers;
-};
-
 inline std::ostream& operator<<(std::ostream& strm,
 				const Header& header)
 {
@@ -200,7 +143,10 @@ class tcp_connection
     typedef typename itf::get_message_list<Interface, Side, itf::Rx>::type RxMessageList;
     typedef typename itf::get_message_list<Interface, Side, itf::Tx>::type TxMessageList;
 
-    typedef boost::function<void (int)> fct_t;
+    typedef typename itf::wire_format<Interface>::type wire_format_type;
+
+    // Member function reading the message body for one unique id:
+    typedef void (type::*read_body_fct_t)(int);
 
 public:
     template<class Event>
@@ -216,31 +162,39 @@ private:
 	  m_receiver(receiver)
     {
 	TRACE_DEBUG();
-	boost::mpl::for_each<RxMessageList>(add_rx_callback(this));
     }
 
-    struct add_rx_callback
+    // rx_table_entry<Id>::get() returns the start_read_body method for the
+    // Event with the unique id Id, or 0 if Id is not received on this side:
+    template<int Id,
+	     typename Event = typename itf::get_event_by_id<Id, RxMessageList>::type>
+    struct rx_table_entry
     {
-	add_rx_callback(type* parent)
-	    : parent(parent)
-	{}
-
-	template<typename Message>
-	void operator()(Message)
+	static constexpr read_body_fct_t get()
 	{
-	    TRACE_DEBUG();
-
-	    typedef void (type::*member_fct_t)(int);
-	    member_fct_t tmp = &type::start_read_body<typename Message::type>;
-	    fct_t fct = boost::bind(tmp, parent, _1);
-
-	    typedef typename Message::msg_id msg_id;
-	    parent->m_rx_map.insert(std::make_pair(msg_id::value, fct));
+	    return &type::template start_read_body<Event>;
 	}
+    };
 
-	type* parent;
+    template<int Id>
+    struct rx_table_entry<Id, itf::none>
+    {
+	static constexpr read_body_fct_t get()
+	{
+	    return 0;
+	}
     };
 
+    // The table is indexed with the unique id received in the header.
+    // It is a constant expression, i.e. there is no initialization at
+    // runtime:
+    template<int... Ids>
+    static read_body_fct_t get_read_body_fct(unsigned int id, itf::indices<Ids...>)
+    {
+	static constexpr read_body_fct_t rx_table[] = {rx_table_entry<Ids>::get()...};
+	return id < sizeof...(Ids) ? rx_table[id] : 0;
+    }
+
     boost::asio::ip::tcp::socket& socket()
     {
 	return m_socket;
@@ -272,13 +226,14 @@ private:
 	{
 	    TRACE_DEBUG( << "Header = "<< m_rx_header);
 
-	    std::map<int, fct_t>::iterator pos = m_rx_map.find(m_rx_header.type());
+	    typedef typename itf::make_indices<itf::num_message_ids<Interface>::value>::type ids;
+	    read_body_fct_t read_body = get_read_body_fct(m_rx_header.type(), ids());
 
-	    if (pos != m_rx_map.end())
+	    if (read_body)
 	    {
 		// Calling start_read_body template method
 		// for the received message type:
-		pos->second(m_rx_header.length());
+		(this->*read_body)(m_rx_header.length());
 	    }
 	    else
 	    {
@@ -304,34 +259,34 @@ private:
     start_read_body(int length)
     {
 	TRACE_DEBUG();
-	boost::shared_ptr<std::vector<char> > body(new std::vector<char>());
-	body->resize(length);
+	// Only one read is pending at any time. The buffer is
+	// reused for all received messages:
+	m_rx_body.resize(length);
 	boost::asio::async_read(m_socket,
-				boost::asio::buffer(*body),
+				boost::asio::buffer(m_rx_body),
 				boost::bind(&tcp_connection::handle_read_body<Event>,
 					    this->shared_from_this(),
-					    boost::asio::placeholders::error,
-					    body));
+					    boost::asio::placeholders::error));
     }
 
     template<class Event>
     typename itf::enable_if_msg_in_list<Event, RxMessageList, void>::type
-    handle_read_body(const boost::system::error_code& err,
-		     const boost::shared_ptr<std::vector<char> > body)
+    handle_read_body(const boost::system::error_code& err)
     {
 	TRACE_DEBUG();
 	if (!err)
 	{
-	    // Create a stream reading from std::vector<char>:
-	    std::vector<char>& b = *body;
-	    boost::iostreams::stream<boost::iostreams::array_source> archive_stream(&b[0], b.size());
-	    boost::archive::text_iarchive archive(archive_stream);
-
+	    const char* data = m_rx_body.empty() ? 0 : &m_rx_body[0];
 	    boost::shared_ptr<Event> event(new Event());
-	    archive >> *event;
-
-	    TRACE_DEBUG("rx: " << *event);
-	    m_receiver->queue_event(event);
+	    if (wire_format_type::load(data, m_rx_body.size(), *event))
+	    {
+		TRACE_DEBUG("rx: " << *event);
+		m_receiver->queue_event(event);
+	    }
+	    else
+	    {
+		TRACE_ERROR(<< "Invalid message body: " << m_rx_header);
+	    }
 	    start_read_header();
 	}
 	else if (err == boost::asio::error::eof)
@@ -355,27 +310,36 @@ private:
 	TRACE_DEBUG();
 	if (m_socket.is_open())
 	{
-	    // Serialize event:
-	    std::ostringstream archive_stream;
-	    boost::archive::text_oarchive archive(archive_stream);
-	    archive << *event;
-	    std::string body = archive_stream.str();
+	    // Serialize event behind the space reserved for the header.
+	    // Header and body are sent from the same buffer:
+	    boost::shared_ptr<std::vector<char> > buffer =
+		boost::make_shared<std::vector<char> >(sizeof(Header));
+	    wire_format_type::save(*event, *buffer);
+
+	    const unsigned int body_size = buffer->size() - sizeof(Header);
+	    if (body_size > Header::max_length)
+	    {
+		TRACE_ERROR(<< "Message too long: " << body_size);
+		return;
+	    }
 
 	    // Serialize header:
 	    const int msg_id = itf::get_message_id<Event, TxMessageList>::type::value;
-	    const int body_size = body.size();
 	    Header header(msg_id, body_size);
+	    memcpy(&(*buffer)[0], &header, sizeof(Header));
 
-	    // Asynchronously send message:
-	    message msg(header, body);
-	    boost::asio::async_write(m_socket, msg,
+	    // Asynchronously send message. The buffer is released
+	    // when the write is completed:
+	    boost::asio::async_write(m_socket, boost::asio::buffer(*buffer),
 				     boost::bind(&tcp_connection::handle_write,
 						 this->shared_from_this(),
-						 boost::asio::placeholders::error));
+						 boost::asio::placeholders::error,
+						 buffer));
 	}
     }
 
-    void handle_write(const boost::system::error_code& err)
+    void handle_write(const boost::system::error_code& err,
+		      boost::shared_ptr<std::vector<char> >)
     {
 	TRACE_DEBUG();
 	if (!err)
@@ -426,8 +390,7 @@ private:
     boost::asio::ip::tcp::socket m_socket;
     boost::shared_ptr<Receiver> m_receiver;
     Header m_rx_header;
-
-    std::map<int, fct_t> m_rx_map;
+    std::vector<char> m_rx_body;
 };
 
 #endif
@@ -0,0 +1,94 @@
+//
+// Band Pool Test
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// Many jobs with a varying number of bands are started one after the
+// other, without waiting in between. Each band has to be processed
+// exactly once and done has to be called once per job, after all bands
+// of the job are processed.
+//
+
+#include "platform/band_pool.hpp"
+#include "platform/benchmark.hpp"
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+const int numJobs = 10000;
+const int maxBands = 17;
+
+std::vector<std::atomic<int> > counts(maxBands);
+std::atomic<int> doneCalls(0);
+std::atomic<int> errors(0);
+int currentBands = 0;
+
+void processBand(int band)
+{
+    if (band < 0 || band >= currentBands)
+    {
+	errors++;
+	return;
+    }
+    counts[band]++;
+}
+
+void done()
+{
+    for (int i = 0; i < maxBands; i++)
+    {
+	if (counts[i] != (i < currentBands ? 1 : 0))
+	{
+	    errors++;
+	}
+    }
+    doneCalls++;
+}
+
+int main()
+{
+    band_pool pool(4);
+
+    for (int job = 0; job < numJobs; job++)
+    {
+	// start waits for the previous job, thus it is safe to modify
+	// the data used by it afterwards:
+	pool.wait();
+	for (int i = 0; i < maxBands; i++)
+	{
+	    counts[i] = 0;
+	}
+	currentBands = job % maxBands;
+	pool.start(currentBands, processBand, done);
+    }
+    pool.wait();
+
+    // Synchronous use:
+    int sum = 0;
+    std::vector<int> values(8, 0);
+    pool.run(8, [&values](int band) {values[band] = band + 1;});
+    for (int i = 0; i < 8; i++)
+    {
+	sum += values[i];
+    }
+
+    std::cout << "jobs: " << numJobs
+	      << ", done called: " << doneCalls
+	      << ", sum: " << sum << std::endl;
+
+    if (doneCalls != numJobs)
+    {
+	errors++;
+    }
+    if (sum != 36)
+    {
+	errors++;
+    }
+
+    return test_result(errors);
+}
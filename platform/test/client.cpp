@@ -24,9 +24,24 @@
 #include <ostream>
 #include <string>
 #include <boost/bind.hpp>
+#include <stdlib.h>
+#include <sys/time.h>
+
+// SINEMA_BENCHMARK=<n> sends n Indications to the server, each after the
+// reply for the previous one is received, and reports the round trips
+// per second. Client and server output is suppressed meanwhile.
+static const int benchmarkMessages =
+    getenv("SINEMA_BENCHMARK") ? atoi(getenv("SINEMA_BENCHMARK")) : 0;
 
 #undef TRACE_DEBUG
-#define TRACE_DEBUG(s) std::cout << __PRETTY_FUNCTION__ << " " s << std::endl;
+#define TRACE_DEBUG(s) { if (!benchmarkMessages) std::cout << __PRETTY_FUNCTION__ << " " s << std::endl; }
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
 
 struct InitEvent
 {
@@ -61,7 +76,9 @@ public :
     Client(event_processor_ptr_type evt_proc)
 	: base_type(evt_proc),
 	  eventProcessor(evt_proc),
-	  serverAutoStartEnabled(true)
+	  serverAutoStartEnabled(true),
+	  benchmarkRemaining(benchmarkMessages),
+	  benchmarkStart(0)
     {}
 
     ~Client()
@@ -133,6 +150,13 @@ private:
 	TRACE_DEBUG( << "ConnectionEstablished");
 	proxy = event->proxy;
 
+	if (benchmarkRemaining > 0)
+	{
+	    benchmarkStart = now();
+	    proxy->queue_event(boost::make_shared<csif::Indication>(benchmarkRemaining, -1, 0));
+	    return;
+	}
+
 	boost::shared_ptr<csif::Indication> ind1(new csif::Indication(10,20,30));
 	proxy->queue_event(ind1);
 
@@ -188,6 +212,24 @@ private:
     void process(boost::shared_ptr<csif::Indication> event)
     {
 	TRACE_DEBUG( << "csif::Indication" << *event);
+
+	// The server replies with doubled values:
+	if (benchmarkRemaining > 0 && event->b == -2 && proxy)
+	{
+	    if (--benchmarkRemaining > 0)
+	    {
+		proxy->queue_event(boost::make_shared<csif::Indication>(benchmarkRemaining, -1, 0));
+	    }
+	    else
+	    {
+		double duration = now() - benchmarkStart;
+		std::cout << benchmarkMessages << " round trips: "
+			  << benchmarkMessages / duration << " round trips/sec" << std::endl;
+
+		boost::shared_ptr<csif::CreateReq> req(new csif::CreateReq(51,52,53, std::string("ping")));
+		proxy->queue_event(req);
+	    }
+	}
     }
 
     void process(boost::shared_ptr<csif::UpLinkMsg> event)
@@ -210,6 +252,8 @@ private:
     boost::shared_ptr<process_starter> m_processStarter;
     timer retryTimer;
     bool serverAutoStartEnabled;
+    int benchmarkRemaining;
+    double benchmarkStart;
 };
 
 class Appl
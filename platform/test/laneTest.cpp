@@ -0,0 +1,159 @@
+//
+// Inter Thread Communication - Event Lane Test
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// Data events are queued, then a control event and further data
+// events. The control event has to be processed first. The data events
+// queued before it have to be reported as overtaken, the others not.
+//
+// Then a second receiver on the same event_processor forwards the
+// control event to the first one, like the VideoDecoder forwards a
+// FlushReq to the Deinterlacer. The data events of the second receiver
+// queued after the control event must not be reported as overtaken.
+//
+
+#include "platform/Logging.hpp"
+#include "platform/event_receiver.hpp"
+#include "platform/mpsc_ring_queue.hpp"
+
+#include <boost/make_shared.hpp>
+#include <string>
+
+struct Data
+{
+    Data(int n) : n(n) {}
+    int n;
+};
+
+struct Flush {};
+
+CONTROL_LANE_EVENT(Flush)
+
+template<class Queue>
+class Receiver : public event_receiver<Receiver<Queue>, Queue>
+{
+    friend class event_processor<Queue>;
+
+    typedef event_receiver<Receiver<Queue>, Queue> base;
+
+public:
+    Receiver(typename base::event_processor_ptr_type evt_proc)
+	: base(evt_proc)
+    {}
+
+    std::string log;
+
+private:
+    void process(boost::shared_ptr<Data> event)
+    {
+	log += std::to_string(event->n);
+	log += this->template overtaken_by<Flush>() ? "o " : " ";
+    }
+
+    void process(boost::shared_ptr<Flush>)
+    {
+	log += "F ";
+    }
+};
+
+template<class Queue>
+class Forwarder : public event_receiver<Forwarder<Queue>, Queue>
+{
+    friend class event_processor<Queue>;
+
+    typedef event_receiver<Forwarder<Queue>, Queue> base;
+
+public:
+    Forwarder(typename base::event_processor_ptr_type evt_proc,
+	      boost::shared_ptr<Receiver<Queue> > receiver)
+	: base(evt_proc),
+	  receiver(receiver)
+    {}
+
+    std::string log;
+
+private:
+    void process(boost::shared_ptr<Data> event)
+    {
+	log += std::to_string(event->n);
+	log += this->template overtaken_by<Flush>() ? "o " : " ";
+    }
+
+    void process(boost::shared_ptr<Flush> event)
+    {
+	log += "F ";
+	receiver->queue_event(event);
+    }
+
+    boost::shared_ptr<Receiver<Queue> > receiver;
+};
+
+template<class Queue>
+bool run(const char* name)
+{
+    boost::shared_ptr<event_processor<Queue> > eventProcessor =
+	boost::make_shared<event_processor<Queue> >();
+    boost::shared_ptr<Receiver<Queue> > receiver =
+	boost::make_shared<Receiver<Queue> >(eventProcessor);
+
+    receiver->queue_event(boost::make_shared<Data>(1));
+    receiver->queue_event(boost::make_shared<Data>(2));
+    receiver->queue_event(boost::make_shared<Flush>());
+    receiver->queue_event(boost::make_shared<Data>(3));
+
+    eventProcessor->dequeue_and_process_until_empty();
+
+    const std::string expected = "F 1o 2o 3 ";
+    bool ok = receiver->log == expected;
+
+    std::cout << name << ": " << receiver->log
+	      << (ok ? "ok" : "failed") << std::endl;
+
+    return ok;
+}
+
+template<class Queue>
+bool runForwarded(const char* name)
+{
+    boost::shared_ptr<event_processor<Queue> > eventProcessor =
+	boost::make_shared<event_processor<Queue> >();
+    boost::shared_ptr<Receiver<Queue> > receiver =
+	boost::make_shared<Receiver<Queue> >(eventProcessor);
+    boost::shared_ptr<Forwarder<Queue> > forwarder =
+	boost::make_shared<Forwarder<Queue> >(eventProcessor, receiver);
+
+    receiver->queue_event(boost::make_shared<Data>(1));
+    forwarder->queue_event(boost::make_shared<Data>(2));
+    forwarder->queue_event(boost::make_shared<Flush>());
+    forwarder->queue_event(boost::make_shared<Data>(3));
+    receiver->queue_event(boost::make_shared<Data>(4));
+
+    eventProcessor->dequeue_and_process_until_empty();
+
+    // The forwarded Flush is processed before Data 1. Its control_mark
+    // is queued behind Data 4, thus Data 4 is still overtaken:
+    const std::string expectedForwarder = "F 2o 3 ";
+    const std::string expectedReceiver = "F 1o 4o ";
+    bool ok = forwarder->log == expectedForwarder && receiver->log == expectedReceiver;
+
+    std::cout << name << ", forwarded: " << forwarder->log << "/ " << receiver->log
+	      << (ok ? "ok" : "failed") << std::endl;
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+
+    ok &= run<concurrent_queue<receive_fct_t> >("concurrent_queue");
+    ok &= run<mpsc_ring_queue<receive_fct_t> >("mpsc_ring_queue");
+    ok &= runForwarded<concurrent_queue<receive_fct_t> >("concurrent_queue");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,342 @@
+//
+// Inter Thread Communication - Queue Test
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// Several producer threads send numbered events to one consumer.
+// The consumer checks that no event is lost and that the events of
+// each producer are received in order. This is done for the mutex
+// based concurrent_queue and for the lock-free mpsc_ring_queue.
+// The number of heap allocations needed per event is also reported,
+// with events allocated by make_shared and by make_pooled_event.
+//
+// The second part runs the decoder -> deinterlacer -> output chain of
+// the player with both queue types and reports the lock contention and
+// wakeups of the decoder and output queue.
+//
+
+#include "platform/Logging.hpp"
+#include "platform/event_pool.hpp"
+#include "platform/event_receiver.hpp"
+#include "platform/mpsc_ring_queue.hpp"
+
+#include <boost/make_shared.hpp>
+#include <atomic>
+#include <new>
+#include <vector>
+#include <stdlib.h>
+
+std::atomic<long> allocations(0);
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+// All deallocation functions have to match the replaced allocation
+// functions, including the sized ones used by C++14:
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+const int numProducers = 4;
+const int numEvents = 200000;
+
+struct Number
+{
+    Number(int producer, int n)
+	: producer(producer),
+	  n(n)
+    {}
+    int producer;
+    int n;
+};
+
+template<class Queue>
+class Consumer : public event_receiver<Consumer<Queue>, Queue>
+{
+    friend class event_processor<Queue>;
+
+    typedef event_receiver<Consumer<Queue>, Queue> base;
+
+public:
+    Consumer(typename base::event_processor_ptr_type evt_proc)
+	: base(evt_proc),
+	  m_expected(numProducers, 0),
+	  m_received(0),
+	  m_errors(0)
+    {}
+
+    bool finished() {return m_received == numProducers * numEvents;}
+    int errors() {return m_errors;}
+
+private:
+    void process(boost::shared_ptr<Number> event)
+    {
+	if (m_expected[event->producer] != event->n)
+	{
+	    m_errors++;
+	}
+	m_expected[event->producer] = event->n + 1;
+	m_received++;
+    }
+
+    std::vector<int> m_expected;
+    int m_received;
+    int m_errors;
+};
+
+template<class Queue, bool pooled>
+void producer(boost::shared_ptr<Consumer<Queue> > consumer, int id)
+{
+    for (int i = 0; i < numEvents; i++)
+    {
+	if (pooled)
+	{
+	    consumer->queue_event(make_pooled_event<Number>(id, i));
+	}
+	else
+	{
+	    consumer->queue_event(boost::make_shared<Number>(id, i));
+	}
+    }
+}
+
+template<class Queue, bool pooled>
+bool run(const char* name)
+{
+    boost::shared_ptr<event_processor<Queue> > eventProcessor =
+	boost::make_shared<event_processor<Queue> >();
+    boost::shared_ptr<Consumer<Queue> > consumer =
+	boost::make_shared<Consumer<Queue> >(eventProcessor);
+
+    timespec_t start = timer::get_current_time();
+    long startAllocations = allocations;
+
+    boost::thread_group producers;
+    for (int i = 0; i < numProducers; i++)
+    {
+	producers.create_thread(boost::bind(producer<Queue, pooled>, consumer, i));
+    }
+
+    while (!consumer->finished())
+    {
+	eventProcessor->dequeue_and_process();
+    }
+
+    producers.join_all();
+
+    timespec_t duration = timer::get_current_time() - start;
+    double events = numProducers * numEvents;
+    double allocationsPerEvent = (allocations - startAllocations) / events;
+
+    std::cout << name << ": " << getSeconds(duration) << " sec, "
+	      << events / getSeconds(duration) << " events/sec, "
+	      << allocationsPerEvent << " allocations/event, "
+	      << consumer->errors() << " errors" << std::endl;
+    eventProcessor->dump_statistics(std::cout, name);
+
+    return consumer->errors() == 0;
+}
+
+// ===================================================================
+
+// Like the player, the decoder thread passes each frame to the
+// deinterlacer on the same thread, which sends it to the output thread.
+// The output returns the frame to the decoder, like the XFVideoImages.
+
+const int numPackets = 20000;
+const int burstSize = 4;        // packets read at once by the demuxer
+const int burstPeriod = 100;    // us
+
+struct Packet
+{
+    Packet(int n) : n(n) {}
+    int n;
+};
+
+struct Frame
+{
+    Frame(int n) : n(n) {}
+    int n;
+};
+
+struct Release
+{
+    Release(int n) : n(n) {}
+    int n;
+};
+
+template<class Queue> class ChainDecoder;
+template<class Queue> class ChainDeinterlacer;
+template<class Queue> class ChainOutput;
+
+template<class Queue>
+struct Chain
+{
+    boost::shared_ptr<ChainDecoder<Queue> > decoder;
+    boost::shared_ptr<ChainDeinterlacer<Queue> > deinterlacer;
+    boost::shared_ptr<ChainOutput<Queue> > output;
+    std::atomic<int> released;
+    std::atomic<int> errors;
+
+    Chain() : released(0), errors(0) {}
+};
+
+template<class Queue>
+class ChainDecoder : public event_receiver<ChainDecoder<Queue>, Queue>
+{
+    friend class event_processor<Queue>;
+    typedef event_receiver<ChainDecoder<Queue>, Queue> base;
+
+public:
+    ChainDecoder(typename base::event_processor_ptr_type evt_proc, Chain<Queue>& chain)
+	: base(evt_proc), m_chain(chain), m_packet(0), m_release(0)
+    {}
+
+private:
+    void process(boost::shared_ptr<Packet> event)
+    {
+	if (event->n != m_packet++) m_chain.errors++;
+	m_chain.deinterlacer->queue_event(boost::make_shared<Frame>(event->n));
+    }
+
+    void process(boost::shared_ptr<Release> event)
+    {
+	if (event->n != m_release++) m_chain.errors++;
+	m_chain.released++;
+    }
+
+    Chain<Queue>& m_chain;
+    int m_packet;
+    int m_release;
+};
+
+template<class Queue>
+class ChainDeinterlacer : public event_receiver<ChainDeinterlacer<Queue>, Queue>
+{
+    friend class event_processor<Queue>;
+    typedef event_receiver<ChainDeinterlacer<Queue>, Queue> base;
+
+public:
+    ChainDeinterlacer(typename base::event_processor_ptr_type evt_proc, Chain<Queue>& chain)
+	: base(evt_proc), m_chain(chain)
+    {}
+
+private:
+    void process(boost::shared_ptr<Frame> event)
+    {
+	m_chain.output->queue_event(event);
+    }
+
+    Chain<Queue>& m_chain;
+};
+
+template<class Queue>
+class ChainOutput : public event_receiver<ChainOutput<Queue>, Queue>
+{
+    friend class event_processor<Queue>;
+    typedef event_receiver<ChainOutput<Queue>, Queue> base;
+
+public:
+    ChainOutput(typename base::event_processor_ptr_type evt_proc, Chain<Queue>& chain)
+	: base(evt_proc), m_chain(chain), m_frame(0)
+    {}
+
+private:
+    void process(boost::shared_ptr<Frame> event)
+    {
+	if (event->n != m_frame++) m_chain.errors++;
+	m_chain.decoder->queue_event(boost::make_shared<Release>(event->n));
+    }
+
+    Chain<Queue>& m_chain;
+    int m_frame;
+};
+
+template<class Queue>
+bool runChain(const char* name)
+{
+    typedef event_processor<Queue> processor_t;
+    boost::shared_ptr<processor_t> decoderProcessor = boost::make_shared<processor_t>();
+    boost::shared_ptr<processor_t> outputProcessor = boost::make_shared<processor_t>();
+
+    Chain<Queue> chain;
+    chain.decoder = boost::make_shared<ChainDecoder<Queue> >(decoderProcessor, boost::ref(chain));
+    chain.deinterlacer = boost::make_shared<ChainDeinterlacer<Queue> >(decoderProcessor, boost::ref(chain));
+    chain.output = boost::make_shared<ChainOutput<Queue> >(outputProcessor, boost::ref(chain));
+
+    boost::thread decoderThread(decoderProcessor->get_callable());
+    boost::thread outputThread(outputProcessor->get_callable());
+
+    // This thread is the demuxer:
+    timespec_t start = timer::get_current_time();
+    for (int i = 0; i < numPackets; i++)
+    {
+	chain.decoder->queue_event(boost::make_shared<Packet>(i));
+	if (i % burstSize == burstSize - 1)
+	{
+	    boost::this_thread::sleep(boost::posix_time::microseconds(burstPeriod));
+	}
+    }
+    while (chain.released != numPackets)
+    {
+	boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+    timespec_t duration = timer::get_current_time() - start;
+
+    decoderProcessor->queue_event(boost::make_shared<QuitEvent>());
+    outputProcessor->queue_event(boost::make_shared<QuitEvent>());
+    decoderThread.join();
+    outputThread.join();
+
+    std::cout << name << ", chain: " << getSeconds(duration) << " sec, "
+	      << chain.errors << " errors" << std::endl;
+    decoderProcessor->dump_statistics(std::cout, "decoder");
+    outputProcessor->dump_statistics(std::cout, "output");
+
+    return chain.errors == 0;
+}
+
+int main()
+{
+    bool ok = true;
+
+    ok &= run<concurrent_queue<receive_fct_t>, false>("concurrent_queue");
+    ok &= run<concurrent_queue<receive_fct_t>, true>("concurrent_queue, pooled events");
+    ok &= run<mpsc_ring_queue<receive_fct_t>, false>("mpsc_ring_queue");
+    ok &= run<mpsc_ring_queue<receive_fct_t>, true>("mpsc_ring_queue, pooled events");
+
+    ok &= runChain<concurrent_queue<receive_fct_t> >("concurrent_queue");
+    ok &= runChain<mpsc_ring_queue<receive_fct_t> >("mpsc_ring_queue");
+
+    return ok ? 0 : 1;
+}
@@ -31,8 +31,13 @@
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
+#include <stdlib.h>
+
+// Output is suppressed while the client is running a benchmark:
+static const bool benchmark = getenv("SINEMA_BENCHMARK") != 0;
+
 #undef TRACE_DEBUG
-#define TRACE_DEBUG(s) std::cout << __PRETTY_FUNCTION__ << " " s << std::endl;
+#define TRACE_DEBUG(s) { if (!benchmark) std::cout << __PRETTY_FUNCTION__ << " " s << std::endl; }
 
 struct InitEvent
 {
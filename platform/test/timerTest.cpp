@@ -0,0 +1,242 @@
+//
+// Inter Thread Communication - Timer Test
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// A receiver restarts an absolute one-shot timer for each expiry like
+// VideoOutput does for each frame. The delay between the requested
+// expiry time and the time the timeout event is processed (jitter) and
+// the CPU time used by the whole process per expiry are reported. This
+// is done for the timer_service and, as reference, for a POSIX timer
+// with SIGEV_THREAD notification, which timer used before.
+//
+// Finally a timer is started while the timeout function of another
+// timer is blocked. This must not wait for the timeout function.
+//
+
+#include "platform/Logging.hpp"
+#include "platform/event_receiver.hpp"
+
+#include <boost/make_shared.hpp>
+#include <algorithm>
+#include <signal.h>
+#include <vector>
+
+const int numExpiries = 500;
+const double interval = 0.005;
+
+struct Timeout
+{
+};
+
+// One-shot absolute timer with SIGEV_THREAD notification:
+class sigev_timer
+{
+public:
+    typedef boost::function<void ()> timeout_fct_t;
+
+    sigev_timer(timeout_fct_t fct)
+	: m_timeout_fct(fct)
+    {
+	sigevent_t event;
+	bzero((char*)&event, sizeof(event));
+	event.sigev_notify = SIGEV_THREAD;
+	event.sigev_notify_function = timeout_handler;
+	event.sigev_value.sival_ptr = (void*)this;
+	if (timer_create(CLOCK_REALTIME, &event, &m_timerid) != 0)
+	{
+	    perror("timer_create failed");
+	    exit(-1);
+	}
+    }
+
+    ~sigev_timer()
+    {
+	timer_delete(m_timerid);
+    }
+
+    void start(timespec_t abs)
+    {
+	struct itimerspec ts;
+	bzero((char*)&ts, sizeof(ts));
+	ts.it_value = abs;
+	if (timer_settime(m_timerid, TIMER_ABSTIME, &ts, NULL) != 0)
+	{
+	    perror("timer_settime failed");
+	    exit(-1);
+	}
+    }
+
+private:
+    static void timeout_handler(sigval_t sigval)
+    {
+	((sigev_timer*)sigval.sival_ptr)->m_timeout_fct();
+    }
+
+    timer_t m_timerid;
+    timeout_fct_t m_timeout_fct;
+};
+
+class Receiver : public event_receiver<Receiver>
+{
+    friend class event_processor<>;
+
+public:
+    Receiver(event_processor_ptr_type evt_proc, bool sigev)
+	: event_receiver<Receiver>(evt_proc),
+	  m_sigev(sigev),
+	  m_sigevTimer(boost::bind(&Receiver::queueTimeout, this))
+    {}
+
+    void start()
+    {
+	m_expiry = timer::get_current_time() + getTimespec(interval);
+	if (m_sigev)
+	{
+	    m_sigevTimer.start(m_expiry);
+	}
+	else
+	{
+	    m_timer.absolute(m_expiry);
+	    start_timer(boost::make_shared<Timeout>(), m_timer);
+	}
+    }
+
+    bool finished() {return int(m_jitter.size()) == numExpiries;}
+
+    void report(const char* name, double cpuTime)
+    {
+	std::sort(m_jitter.begin(), m_jitter.end());
+	double sum = 0;
+	for (std::vector<double>::iterator it = m_jitter.begin(); it != m_jitter.end(); it++)
+	{
+	    sum += *it;
+	}
+
+	std::cout << name << ": jitter [us]: avg=" << 1e6 * sum / numExpiries
+		  << ", p50=" << 1e6 * m_jitter[numExpiries / 2]
+		  << ", p99=" << 1e6 * m_jitter[numExpiries * 99 / 100]
+		  << ", max=" << 1e6 * m_jitter.back()
+		  << "; cpu time per expiry [us]: " << 1e6 * cpuTime / numExpiries
+		  << std::endl;
+    }
+
+private:
+    void queueTimeout()
+    {
+	queue_event(boost::make_shared<Timeout>());
+    }
+
+    void process(boost::shared_ptr<Timeout>)
+    {
+	m_jitter.push_back(getSeconds(timer::get_current_time() - m_expiry));
+	if (!finished())
+	{
+	    start();
+	}
+    }
+
+    bool m_sigev;
+    timer m_timer;
+    sigev_timer m_sigevTimer;
+    timespec_t m_expiry;
+    std::vector<double> m_jitter;
+};
+
+static double getCpuTime()
+{
+    timespec_t t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return getSeconds(t);
+}
+
+static void measureJitter(const char* name, bool sigev)
+{
+    boost::shared_ptr<event_processor<> > eventProcessor =
+	boost::make_shared<event_processor<> >();
+    boost::shared_ptr<Receiver> receiver =
+	boost::make_shared<Receiver>(eventProcessor, sigev);
+
+    double cpuStart = getCpuTime();
+
+    receiver->start();
+    while (!receiver->finished())
+    {
+	eventProcessor->dequeue_and_process();
+    }
+
+    receiver->report(name, getCpuTime() - cpuStart);
+}
+
+// The queue of this receiver blocks the timer_service thread while
+// queueing the timeout event:
+typedef concurrent_queue<receive_fct_t, with_callback_function> slow_queue_t;
+
+const int blockTime = 50;  // ms
+
+class SlowReceiver : public event_receiver<SlowReceiver, slow_queue_t>
+{
+    friend class event_processor<slow_queue_t>;
+
+public:
+    SlowReceiver(event_processor_ptr_type evt_proc)
+	: event_receiver<SlowReceiver, slow_queue_t>(evt_proc)
+    {}
+
+    void start()
+    {
+	m_timer.relative(getTimespec(0.001));
+	start_timer(boost::make_shared<Timeout>(), m_timer);
+    }
+
+private:
+    void process(boost::shared_ptr<Timeout>) {}
+
+    timer m_timer;
+};
+
+static void block()
+{
+    boost::this_thread::sleep(boost::posix_time::milliseconds(blockTime));
+}
+
+static bool measureBlocking()
+{
+    boost::shared_ptr<event_processor<slow_queue_t> > slowProcessor =
+	boost::make_shared<event_processor<slow_queue_t> >();
+    slowProcessor->attach(block);
+    boost::shared_ptr<SlowReceiver> slowReceiver =
+	boost::make_shared<SlowReceiver>(slowProcessor);
+
+    boost::shared_ptr<event_processor<> > eventProcessor =
+	boost::make_shared<event_processor<> >();
+    boost::shared_ptr<Receiver> receiver =
+	boost::make_shared<Receiver>(eventProcessor, false);
+
+    slowReceiver->start();
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+
+    timespec_t start = timer::get_current_time();
+    receiver->start();
+    double seconds = getSeconds(timer::get_current_time() - start);
+
+    bool ok = 1e3 * seconds < blockTime / 2;
+    std::cout << "start_timer while a timeout function blocks [us]: " << 1e6 * seconds
+	      << (ok ? ", ok" : ", failed") << std::endl;
+
+    // Wait until the blocked timeout function returned:
+    boost::this_thread::sleep(boost::posix_time::milliseconds(blockTime));
+    return ok;
+}
+
+int main()
+{
+    measureJitter("SIGEV_THREAD", true);
+    measureJitter("timer_service", false);
+
+    return measureBlocking() ? 0 : 1;
+}
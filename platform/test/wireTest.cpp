@@ -0,0 +1,89 @@
+//
+// Inter Task Communication - Wire Format Test
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// Serializes and deserializes the messages of the client server test
+// interface with text_format and binary_format, checks that the
+// received values are equal to the sent ones and reports messages/s
+// and bytes per message for both formats.
+//
+
+#include <iostream>
+#include <vector>
+#include <sys/time.h>
+
+#include "ClientServerEvents.hpp"
+#include "platform/wire_format.hpp"
+
+const int numMessages = 200000;
+
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static bool operator==(const csif::CreateReq& a, const csif::CreateReq& b)
+{
+    return a.x == b.x && a.y == b.y && a.z == b.z && a.s == b.s;
+}
+
+static bool operator==(const csif::Indication& a, const csif::Indication& b)
+{
+    return a.a == b.a && a.b == b.b && a.c == b.c;
+}
+
+template<class Format, class Event>
+static void test(const char* name, const Event& event)
+{
+    std::vector<char> buffer;
+    size_t bytes = 0;
+    int errors = 0;
+
+    double start = now();
+    for (int i = 0; i < numMessages; i++)
+    {
+	buffer.clear();
+	Format::save(event, buffer);
+	bytes += buffer.size();
+
+	Event received;
+	if (!Format::load(&buffer[0], buffer.size(), received) ||
+	    !(received == event))
+	{
+	    errors++;
+	}
+    }
+    double duration = now() - start;
+
+    std::cout << name << " " << csif::getMsgName(event) << ": "
+	      << numMessages / duration << " messages/sec, "
+	      << double(bytes) / numMessages << " bytes/message, "
+	      << errors << " errors" << std::endl;
+}
+
+int main()
+{
+    csif::CreateReq createReq(1, -70000, 0x12345678, "create request");
+    csif::Indication indication(-1, 2, 3);
+
+    test<itf::text_format>("text_format", createReq);
+    test<itf::binary_format>("binary_format", createReq);
+    test<itf::text_format>("text_format", indication);
+    test<itf::binary_format>("binary_format", indication);
+
+    // A truncated message must be rejected:
+    std::vector<char> buffer;
+    itf::binary_format::save(createReq, buffer);
+    csif::CreateReq received;
+    bool truncated = !itf::binary_format::load(&buffer[0], buffer.size() - 1, received);
+    std::cout << "truncated message " << (truncated ? "rejected" : "accepted") << std::endl;
+
+    return truncated ? 0 : 1;
+}
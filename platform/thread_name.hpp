@@ -0,0 +1,64 @@
+//
+// Thread Names
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// Names the calling thread. The name is shown by top and gdb and is
+// used for the thread's track in the event trace, see event_trace.hpp.
+//
+
+#ifndef THREAD_NAME_HPP
+#define THREAD_NAME_HPP
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+
+class thread_names
+{
+public:
+    static void set(const std::string& name)
+    {
+	// The kernel truncates it to 15 characters:
+	prctl(PR_SET_NAME, name.c_str(), 0, 0, 0);
+
+	pid_t tid = (pid_t) syscall(SYS_gettid);
+	boost::mutex::scoped_lock lock(mutex());
+	names()[tid] = name;
+    }
+
+    // Returns an empty string for threads without name:
+    static std::string get(pid_t tid)
+    {
+	boost::mutex::scoped_lock lock(mutex());
+	std::map<pid_t, std::string>::const_iterator it = names().find(tid);
+	return it != names().end() ? it->second : std::string();
+    }
+
+private:
+    static boost::mutex& mutex()
+    {
+	static boost::mutex s_mutex;
+	return s_mutex;
+    }
+
+    static std::map<pid_t, std::string>& names()
+    {
+	static std::map<pid_t, std::string> s_names;
+	return s_names;
+    }
+};
+
+inline void set_thread_name(const std::string& name)
+{
+    thread_names::set(name);
+}
+
+#endif
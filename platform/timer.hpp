@@ -11,12 +11,22 @@
 #ifndef TIMER_HPP
 #define TIMER_HPP
 
+#include "platform/thread_name.hpp"
+
+#include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <set>
 #include <strings.h>
 #include <stdlib.h>
-#include <signal.h>
+#include <stdint.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 #include <stdio.h>   // perror
 #include <iostream>
 
@@ -25,10 +35,108 @@ class event_processor;
 
 typedef struct timespec timespec_t;
 
+class timer;
+
+// All timers are served by a single thread waiting with epoll for the
+// timerfd of each timer. The timeout functions are called within this
+// thread. They only queue an event, i.e. they return quickly.
+//
+// m_mutex is held while an expiration is read and while a timer is
+// started, stopped or destroyed, but not while the timeout function is
+// called. Starting, stopping or destroying the timer, whose timeout
+// function is currently called, waits until it returned. Thus a timeout
+// function is never called after stop_timer returned or for a previous
+// start_timer call, and a slow timeout function only delays the other
+// timeouts, but no thread using other timers.
+class timer_service : private boost::noncopyable
+{
+    friend class timer;
+
+public:
+    static timer_service& instance()
+    {
+	// Never deleted, the thread may still wait for timers of
+	// static objects while the process terminates:
+	static timer_service* s_instance = new timer_service();
+	return *s_instance;
+    }
+
+private:
+    timer_service()
+	: m_calling(0)
+    {
+	m_epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (m_epfd < 0)
+	{
+	    perror("epoll_create1 failed");
+	    exit(-1);
+	}
+
+	m_thread = boost::thread(boost::bind(&timer_service::operator(), this));
+    }
+
+    void add(timer* tmr, int fd)
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	struct epoll_event event;
+	bzero((char*)&event, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = (void*)tmr;
+
+	int ret = epoll_ctl(m_epfd, EPOLL_CTL_ADD, fd, &event);
+	if (ret != 0)
+	{
+	    perror("epoll_ctl EPOLL_CTL_ADD failed");
+	    exit(-1);
+	}
+
+	m_timers.insert(tmr);
+    }
+
+    void remove(timer* tmr, int fd)
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	int ret = epoll_ctl(m_epfd, EPOLL_CTL_DEL, fd, NULL);
+	if (ret != 0)
+	{
+	    perror("epoll_ctl EPOLL_CTL_DEL failed");
+	    exit(-1);
+	}
+
+	wait_until_called(tmr, lock);
+	m_timers.erase(tmr);
+    }
+
+    // Called with m_mutex locked:
+    void wait_until_called(timer* tmr, boost::mutex::scoped_lock& lock)
+    {
+	// A timeout function restarting its own timer must not wait:
+	while (m_calling == tmr && boost::this_thread::get_id() != m_thread.get_id())
+	{
+	    m_called.wait(lock);
+	}
+    }
+
+    void operator()();
+
+    int m_epfd;
+    boost::mutex m_mutex;
+    // Timer whose timeout function is called without m_mutex:
+    timer* m_calling;
+    boost::condition_variable m_called;
+    // Timers currently registered. Events returned by epoll_wait
+    // for a meanwhile deleted timer are ignored:
+    std::set<timer*> m_timers;
+    boost::thread m_thread;
+};
+
 class timer : private boost::noncopyable
 {
     template<class concurrent_queue>
     friend class event_processor;
+    friend class timer_service;
 
     typedef boost::function<void ()> timeout_fct_t;
     typedef struct timespec timespec_t;
@@ -36,40 +144,38 @@ class timer : private boost::noncopyable
 
 public:
     timer()
-	: m_timeout_fct()
+	: m_timeout_fct(),
+	  m_overrun(0),
+	  m_service(timer_service::instance())
     {
-	sigevent_t event;
-	bzero((char*)&event, sizeof(event));
-	event.sigev_notify = SIGEV_THREAD;
-	event._sigev_un._sigev_thread._function = timeout_handler;
-	event._sigev_un._sigev_thread._attribute = NULL;
-	event.sigev_value.sival_ptr = (void*)this;
-
-	int ret = timer_create(m_clockid, &event, &m_timerid);
-
-	if (ret != 0)
+	m_fd = timerfd_create(m_clockid, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (m_fd < 0)
 	{
-	    perror("timer_create failed");
+	    perror("timerfd_create failed");
 	    exit(-1);
 	}
 
 	m_flags = 0;
 	bzero((char*)&m_timerspec, sizeof(m_timerspec));
+
+	m_service.add(this, m_fd);
     }
 
     ~timer()
     {
-	int ret = timer_delete(m_timerid);
+	m_service.remove(this, m_fd);
+
+	int ret = close(m_fd);
 	if (ret != 0)
 	{
-	    perror("timer_delete failed");
+	    perror("close timerfd failed");
 	    exit(-1);
 	}
     }
 
     timer& absolute(timespec_t abs)
     {
-	m_flags = TIMER_ABSTIME;
+	m_flags = TFD_TIMER_ABSTIME;
 	m_timerspec.it_value = abs;
 	return *this;
     }
@@ -87,25 +193,22 @@ public:
 	return *this;
     }
 
+    // Number of additional expirations when the timeout function
+    // was called the last time:
     int get_overrun()
     {
-	int ret = timer_getoverrun(m_timerid);
-	if (ret < 0)
-	{
-	    perror("timer_getoverrun failed");
-	    exit(-1);
-	}
-	return ret;
+	boost::mutex::scoped_lock lock(m_service.m_mutex);
+	return m_overrun;
     }
 
     // Returns amount of time until the timer expires:
     timespec_t get_remaining_time()
     {
 	struct itimerspec ts;
-	int ret = timer_gettime(m_timerid, &ts);
+	int ret = timerfd_gettime(m_fd, &ts);
 	if (ret != 0)
 	{
-	    perror("timer_gettime failed");
+	    perror("timerfd_gettime failed");
 	    exit(-1);
 	}
 	return ts.it_value;
@@ -126,49 +229,98 @@ public:
 
 private:
     static const clockid_t m_clockid = CLOCK_REALTIME;
-    timer_t m_timerid;
+    int m_fd;
     int m_flags;
     itimerspec_t m_timerspec;
     timeout_fct_t m_timeout_fct;
+    int m_overrun;
+    timer_service& m_service;
 
     void start_timer(timeout_fct_t& fct)
     {
+	boost::mutex::scoped_lock lock(m_service.m_mutex);
+	m_service.wait_until_called(this, lock);
+
 	m_timeout_fct = fct;
-	int ret = timer_settime(m_timerid, m_flags, &m_timerspec, NULL);
+	// Also discards a pending expiration of a previous start_timer call:
+	int ret = timerfd_settime(m_fd, m_flags, &m_timerspec, NULL);
 	if (ret != 0)
 	{
-	    perror("timer_settime failed");
+	    perror("timerfd_settime failed");
 	    exit(-1);
 	}
-
     }
 
     void stop_timer()
     {
+	boost::mutex::scoped_lock lock(m_service.m_mutex);
+	m_service.wait_until_called(this, lock);
+
 	itimerspec_t ts;
 	bzero((char*)&ts, sizeof(ts));
-	int ret = timer_settime(m_timerid, 0, &ts, NULL);
+	int ret = timerfd_settime(m_fd, 0, &ts, NULL);
 	if (ret != 0)
 	{
-	    perror("stop_timer: timer_settime failed");
+	    perror("stop_timer: timerfd_settime failed");
 	    exit(-1);
 	}
-
-	// man timer_settime: The effect of disarming or resetting a 
-	// timer with pending expiration notifications is unspecified.
     }
 
-    static void timeout_handler(sigval_t sigval)
+    // Called by timer_service with m_mutex locked. Returns true if the
+    // timeout function has to be called:
+    bool expired()
     {
-	timer* obj = (timer*)sigval.sival_ptr;
-	obj->timeout();
+	uint64_t expirations;
+	if (read(m_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+	{
+	    // Timer was stopped or restarted after epoll_wait returned.
+	    return false;
+	}
+
+	m_overrun = expirations - 1;
+	return bool(m_timeout_fct);
     }
+};
 
-    inline void timeout()
+inline void timer_service::operator()()
+{
+    const int max_events = 16;
+    struct epoll_event events[max_events];
+
+    set_thread_name("timer_service");
+
+    while (1)
     {
-	m_timeout_fct();
+	int num = epoll_wait(m_epfd, events, max_events, -1);
+	if (num < 0)
+	{
+	    // EINTR: Signal received.
+	    continue;
+	}
+
+	for (int i = 0; i < num; i++)
+	{
+	    timer* tmr = (timer*)events[i].data.ptr;
+
+	    boost::mutex::scoped_lock lock(m_mutex);
+	    if (m_timers.find(tmr) == m_timers.end() || !tmr->expired())
+	    {
+		continue;
+	    }
+
+	    // The timer is neither changed nor deleted until m_calling is reset:
+	    m_calling = tmr;
+	    lock.unlock();
+
+	    tmr->m_timeout_fct();
+
+	    lock.lock();
+	    m_calling = 0;
+	    lock.unlock();
+	    m_called.notify_all();
+	}
     }
-};
+}
 
 inline double getSeconds(const timespec_t& t)
 {
@@ -0,0 +1,209 @@
+//
+// Inter Thread Communication - Move-Only Function Object
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+// unique_function is a type-erased callable without arguments like
+// boost::function<void ()>, but it is move-only. Function objects up to
+// buffer_size bytes are stored in-place, i.e. creating, queueing and
+// calling them needs no heap allocation. Since copying is never needed,
+// the stored function object may own a std::unique_ptr.
+//
+
+#ifndef UNIQUE_FUNCTION_HPP
+#define UNIQUE_FUNCTION_HPP
+
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <stddef.h>
+
+class unique_function
+{
+public:
+    // Enough for a pointer to member function, two object pointers,
+    // a boost::shared_ptr, a trace id and two words of event statistics:
+    static const size_t buffer_size = 10 * sizeof(void*);
+
+    unique_function()
+	: m_vtable(0)
+    {}
+
+    template<class F>
+    unique_function(F&& f,
+		    typename std::enable_if<!std::is_same<typename std::decay<F>::type,
+							  unique_function>::value>::type* = 0)
+	: m_vtable(0)
+    {
+	typedef typename std::decay<F>::type functor_type;
+	typedef manager<functor_type, fits_in_place<functor_type>::value> manager_type;
+	manager_type::create(&m_storage, std::forward<F>(f));
+	m_vtable = &manager_type::vtable;
+    }
+
+    unique_function(unique_function&& other)
+	: m_vtable(other.m_vtable)
+    {
+	if (m_vtable)
+	{
+	    m_vtable->move(&m_storage, &other.m_storage);
+	    other.m_vtable = 0;
+	}
+    }
+
+    unique_function& operator=(unique_function&& other)
+    {
+	if (this != &other)
+	{
+	    reset();
+	    if (other.m_vtable)
+	    {
+		other.m_vtable->move(&m_storage, &other.m_storage);
+		m_vtable = other.m_vtable;
+		other.m_vtable = 0;
+	    }
+	}
+	return *this;
+    }
+
+    ~unique_function()
+    {
+	reset();
+    }
+
+    void operator()()
+    {
+	m_vtable->invoke(&m_storage);
+    }
+
+    bool empty() const
+    {
+	return m_vtable == 0;
+    }
+
+    void reset()
+    {
+	if (m_vtable)
+	{
+	    m_vtable->destroy(&m_storage);
+	    m_vtable = 0;
+	}
+    }
+
+private:
+    unique_function(const unique_function&);
+    unique_function& operator=(const unique_function&);
+
+    typedef std::aligned_storage<buffer_size>::type storage_type;
+
+    struct vtable_type
+    {
+	void (*invoke)(storage_type*);
+	void (*move)(storage_type* dst, storage_type* src);
+	void (*destroy)(storage_type*);
+    };
+
+    template<class F>
+    struct fits_in_place
+    {
+	static const bool value =
+	    sizeof(F) <= sizeof(storage_type) &&
+	    std::alignment_of<storage_type>::value % std::alignment_of<F>::value == 0;
+    };
+
+    template<class F, bool in_place>
+    struct manager;
+
+    // Function object is stored within m_storage:
+    template<class F>
+    struct manager<F, true>
+    {
+	template<class G>
+	static void create(storage_type* s, G&& g)
+	{
+	    new (s) F(std::forward<G>(g));
+	}
+
+	static F* get(storage_type* s)
+	{
+	    return static_cast<F*>(static_cast<void*>(s));
+	}
+
+	static void invoke(storage_type* s)
+	{
+	    (*get(s))();
+	}
+
+	static void move(storage_type* dst, storage_type* src)
+	{
+	    new (dst) F(std::move(*get(src)));
+	    get(src)->~F();
+	}
+
+	static void destroy(storage_type* s)
+	{
+	    get(s)->~F();
+	}
+
+	static const vtable_type vtable;
+    };
+
+    // Function object is too big, m_storage holds a pointer to it:
+    template<class F>
+    struct manager<F, false>
+    {
+	template<class G>
+	static void create(storage_type* s, G&& g)
+	{
+	    get(s) = new F(std::forward<G>(g));
+	}
+
+	static F*& get(storage_type* s)
+	{
+	    return *static_cast<F**>(static_cast<void*>(s));
+	}
+
+	static void invoke(storage_type* s)
+	{
+	    (*get(s))();
+	}
+
+	static void move(storage_type* dst, storage_type* src)
+	{
+	    get(dst) = get(src);
+	    get(src) = 0;
+	}
+
+	static void destroy(storage_type* s)
+	{
+	    delete get(s);
+	}
+
+	static const vtable_type vtable;
+    };
+
+    storage_type m_storage;
+    const vtable_type* m_vtable;
+};
+
+template<class F>
+const unique_function::vtable_type unique_function::manager<F, true>::vtable =
+{
+    &unique_function::manager<F, true>::invoke,
+    &unique_function::manager<F, true>::move,
+    &unique_function::manager<F, true>::destroy
+};
+
+template<class F>
+const unique_function::vtable_type unique_function::manager<F, false>::vtable =
+{
+    &unique_function::manager<F, false>::invoke,
+    &unique_function::manager<F, false>::move,
+    &unique_function::manager<F, false>::destroy
+};
+
+#endif
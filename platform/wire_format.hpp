@@ -0,0 +1,352 @@
+//
+// Inter Task Communication - wire_format
+//
+// Copyright (C) Joachim Erbs, 2012
+//
+//    Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//    http://www.boost.org/LICENSE_1_0.txt)
+//
+
+#ifndef PLATFORM_WIRE_FORMAT_HPP
+#define PLATFORM_WIRE_FORMAT_HPP
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include <boost/archive/archive_exception.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/mpl/or.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/utility/enable_if.hpp>
+
+namespace itf {
+
+// -------------------------------------------------------------------
+//
+// A wire format converts the Events of an Interface into the body of a
+// message and back. Proxy implementations like tcp_connection use
+// wire_format<Interface>::type to select it:
+//
+//   text_format:   boost::archive::text_oarchive and text_iarchive.
+//                  This is the default.
+//
+//   binary_format: Fields are written one after another without any
+//                  padding or type information. Integral types and
+//                  floating point types are written with their size in
+//                  little endian byte order, enums as int32_t, strings
+//                  and vectors as uint32_t length followed by the
+//                  elements.
+//
+// Both formats use the serialize member function of the Events, i.e.
+// an Event supporting boost serialization also supports binary_format:
+//
+//    template<class Archive>
+//    void serialize(Archive& ar, const unsigned int)
+//    {
+//        ar & member;
+//    }
+//
+// To select the binary format for an interface:
+//
+//    namespace itf {
+//    template<> struct wire_format<MyInterface> {typedef binary_format type;};
+//    }
+//
+// Both sides of a connection have to use the same format.
+//
+// -------------------------------------------------------------------
+
+class binary_oarchive
+{
+public:
+    // Appends to buffer. Data already contained in buffer, e.g. space
+    // reserved for a message header, is kept:
+    binary_oarchive(std::vector<char>& buffer)
+	: m_buffer(buffer)
+    {}
+
+    template<typename T>
+    binary_oarchive& operator<<(const T& t)
+    {
+	save(t);
+	return *this;
+    }
+
+    template<typename T>
+    binary_oarchive& operator&(const T& t)
+    {
+	save(t);
+	return *this;
+    }
+
+private:
+    template<typename T>
+    typename boost::enable_if<boost::is_integral<T> >::type
+    save(const T& t)
+    {
+	char bytes[sizeof(T)];
+	uint64_t value = t;
+	for (unsigned int i = 0; i < sizeof(T); i++)
+	{
+	    bytes[i] = char(value >> (8*i));
+	}
+	append(bytes, sizeof(T));
+    }
+
+    template<typename T>
+    typename boost::enable_if<boost::is_floating_point<T> >::type
+    save(const T& t)
+    {
+	typedef typename boost::mpl::if_c<sizeof(T) == 4, uint32_t, uint64_t>::type bits_type;
+	BOOST_STATIC_ASSERT(sizeof(T) == sizeof(bits_type));
+	bits_type bits;
+	memcpy(&bits, &t, sizeof(bits));
+	save(bits);
+    }
+
+    template<typename T>
+    typename boost::enable_if<boost::is_enum<T> >::type
+    save(const T& t)
+    {
+	save(int32_t(t));
+    }
+
+    void save(const std::string& s)
+    {
+	save(uint32_t(s.size()));
+	append(s.data(), s.size());
+    }
+
+    template<typename T>
+    void save(const std::vector<T>& v)
+    {
+	save(uint32_t(v.size()));
+	for (typename std::vector<T>::const_iterator it = v.begin(); it != v.end(); it++)
+	{
+	    save(*it);
+	}
+    }
+
+    template<typename T>
+    typename boost::disable_if<boost::mpl::or_<boost::is_integral<T>,
+					       boost::is_floating_point<T>,
+					       boost::is_enum<T> > >::type
+    save(const T& t)
+    {
+	// As boost serialization, serialize is a non-const member function
+	// used for saving and loading:
+	const_cast<T&>(t).serialize(*this, 0);
+    }
+
+    void append(const char* data, size_t size)
+    {
+	m_buffer.insert(m_buffer.end(), data, data + size);
+    }
+
+    std::vector<char>& m_buffer;
+};
+
+class binary_iarchive
+{
+public:
+    binary_iarchive(const char* begin, const char* end)
+	: m_pos(begin),
+	  m_end(end),
+	  m_failed(false)
+    {}
+
+    template<typename T>
+    binary_iarchive& operator>>(T& t)
+    {
+	load(t);
+	return *this;
+    }
+
+    template<typename T>
+    binary_iarchive& operator&(T& t)
+    {
+	load(t);
+	return *this;
+    }
+
+    // False if the data was truncated or had trailing bytes:
+    bool complete() const
+    {
+	return !m_failed && m_pos == m_end;
+    }
+
+private:
+    template<typename T>
+    typename boost::enable_if<boost::is_integral<T> >::type
+    load(T& t)
+    {
+	const unsigned char* bytes = (const unsigned char*)consume(sizeof(T));
+	uint64_t value = 0;
+	if (bytes)
+	{
+	    for (unsigned int i = 0; i < sizeof(T); i++)
+	    {
+		value |= uint64_t(bytes[i]) << (8*i);
+	    }
+	}
+	t = T(value);
+    }
+
+    template<typename T>
+    typename boost::enable_if<boost::is_floating_point<T> >::type
+    load(T& t)
+    {
+	typedef typename boost::mpl::if_c<sizeof(T) == 4, uint32_t, uint64_t>::type bits_type;
+	BOOST_STATIC_ASSERT(sizeof(T) == sizeof(bits_type));
+	bits_type bits;
+	load(bits);
+	memcpy(&t, &bits, sizeof(t));
+    }
+
+    template<typename T>
+    typename boost::enable_if<boost::is_enum<T> >::type
+    load(T& t)
+    {
+	int32_t value;
+	load(value);
+	t = T(value);
+    }
+
+    void load(std::string& s)
+    {
+	uint32_t size;
+	load(size);
+	const char* data = consume(size);
+	if (data)
+	{
+	    s.assign(data, size);
+	}
+	else
+	{
+	    s.clear();
+	}
+    }
+
+    template<typename T>
+    void load(std::vector<T>& v)
+    {
+	uint32_t size;
+	load(size);
+	v.clear();
+	// Each element has at least one byte. Don't allocate memory for
+	// a size exceeding the remaining data:
+	if (size > size_t(m_end - m_pos))
+	{
+	    m_failed = true;
+	    return;
+	}
+	v.resize(size);
+	for (typename std::vector<T>::iterator it = v.begin(); it != v.end(); it++)
+	{
+	    load(*it);
+	}
+    }
+
+    template<typename T>
+    typename boost::disable_if<boost::mpl::or_<boost::is_integral<T>,
+					       boost::is_floating_point<T>,
+					       boost::is_enum<T> > >::type
+    load(T& t)
+    {
+	t.serialize(*this, 0);
+    }
+
+    // Returns 0 if less than size bytes are remaining:
+    const char* consume(size_t size)
+    {
+	if (m_failed || size > size_t(m_end - m_pos))
+	{
+	    m_failed = true;
+	    return 0;
+	}
+	const char* data = m_pos;
+	m_pos += size;
+	return data;
+    }
+
+    const char* m_pos;
+    const char* m_end;
+    bool m_failed;
+};
+
+// -------------------------------------------------------------------
+
+struct text_format
+{
+    template<class Event>
+    static void save(const Event& event, std::vector<char>& buffer)
+    {
+	typedef boost::iostreams::back_insert_device<std::vector<char> > device_type;
+	boost::iostreams::stream<device_type> archive_stream(buffer);
+	{
+	    boost::archive::text_oarchive archive(archive_stream);
+	    archive << event;
+	}
+	archive_stream.flush();
+    }
+
+    template<class Event>
+    static bool load(const char* data, size_t size, Event& event)
+    {
+	try
+	{
+	    boost::iostreams::stream<boost::iostreams::array_source> archive_stream(data, size);
+	    boost::archive::text_iarchive archive(archive_stream);
+	    archive >> event;
+	    return true;
+	}
+	catch(boost::archive::archive_exception&)
+	{
+	    return false;
+	}
+    }
+};
+
+struct binary_format
+{
+    template<class Event>
+    static void save(const Event& event, std::vector<char>& buffer)
+    {
+	binary_oarchive archive(buffer);
+	archive << event;
+    }
+
+    template<class Event>
+    static bool load(const char* data, size_t size, Event& event)
+    {
+	binary_iarchive archive(data, data + size);
+	archive >> event;
+	return archive.complete();
+    }
+};
+
+// wire_format<Interface>::type
+//     A metafunction returning the wire format used for Interface.
+
+template<typename Interface>
+struct wire_format
+{
+    typedef text_format type;
+};
+
+// -------------------------------------------------------------------
+
+}
+
+#endif
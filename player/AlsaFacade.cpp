@@ -226,6 +226,14 @@ void AFPCMDigitalAudioInterface::setSendAudioSyncInfo(send_audio_sync_info_fct_t
     sendAudioSyncInfo = fct;
 }
 
+bool AFPCMDigitalAudioInterface::matches(const OpenAudioOutputReq& req) const
+{
+    return ( sampleRate == req.sample_rate &&
+	     channels == req.channels &&
+	     frameSize == req.frame_size &&
+	     format == convert(req.sample_format) );
+}
+
 void AFPCMDigitalAudioInterface::setPcmHwParams()
 {
     int ret;
@@ -47,6 +47,9 @@ public:
 
     void setSendAudioSyncInfo(send_audio_sync_info_fct_t fct);
 
+    // True if the device is configured for the requested format:
+    bool matches(const OpenAudioOutputReq& req) const;
+
     bool play(boost::shared_ptr<AudioFrame> frame);
     bool getOverallLatency(snd_pcm_sframes_t& delay);
     snd_pcm_sframes_t getBufferFillLevel();
@@ -24,6 +24,7 @@
 #include "player/AudioFrame.hpp"
 #include "player/Demuxer.hpp"
 #include "player/JpegWriter.hpp"
+#include "platform/event_pool.hpp"
 
 #include <boost/make_shared.hpp>
 #include <iomanip>
@@ -42,6 +43,7 @@ AudioDecoder::AudioDecoder(event_processor_ptr_type evt_proc)
       avFrame(avcodec_alloc_frame()),
       avFrameIsFree(true),
       pts(0),
+      seekTarget(-1),
       avFrameBytesTransmittedPerLine(0),
       outputAvSampleFormat(AV_SAMPLE_FMT_NONE),
       sampleSize(0),
@@ -198,7 +200,7 @@ void AudioDecoder::process(boost::shared_ptr<OpenAudioOutputFail>)
     }
 }
 
-void AudioDecoder::process(boost::shared_ptr<CloseAudioStreamReq>)
+void AudioDecoder::process(boost::shared_ptr<CloseAudioStreamReq> event)
 {
     if (state != Closed)
     {
@@ -222,7 +224,7 @@ void AudioDecoder::process(boost::shared_ptr<CloseAudioStreamReq>)
 	}
 	avFrameIsFree = true;
 
-	audioOutput->queue_event(boost::make_shared<CloseAudioOutputReq>());
+	audioOutput->queue_event(boost::make_shared<CloseAudioOutputReq>(event->keepOutput));
 
 	state = Closing;
     }
@@ -241,6 +243,7 @@ void AudioDecoder::process(boost::shared_ptr<CloseAudioOutputResp>)
 	audioStreamIndex = -1;
 	outputAvSampleFormat = AV_SAMPLE_FMT_NONE;
 	sampleSize = 0;
+	seekTarget = -1;
 
 	demuxer->queue_event(boost::make_shared<CloseAudioStreamResp>());
 
@@ -250,6 +253,13 @@ void AudioDecoder::process(boost::shared_ptr<CloseAudioOutputResp>)
 
 void AudioDecoder::process(boost::shared_ptr<AudioPacketEvent> event)
 {
+    if (overtaken_by<FlushReq>())
+    {
+	// Packet was sent before the FlushReq:
+	demuxer->queue_event(make_pooled_event<ConfirmAudioPacketEvent>(*event));
+	return;
+    }
+
     if (state == Opened)
     {
 	TRACE_DEBUG();
@@ -282,14 +292,14 @@ void AudioDecoder::process(boost::shared_ptr<FlushReq> event)
 	avcodec_flush_buffers(avCodecContext);
 
 	// Throw away everything received from the Demuxer:
-	boost::shared_ptr<ConfirmAudioPacketEvent> confirm(new ConfirmAudioPacketEvent());
 	while (!packetQueue.empty())
 	{
+	    demuxer->queue_event(make_pooled_event<ConfirmAudioPacketEvent>(*packetQueue.front()));
 	    packetQueue.pop();
-	    demuxer->queue_event(confirm);
 	}
 
 	avFrameIsFree = true;
+	seekTarget = event->seekTarget;
 
 	// Forward event to AudioOutput:
 	audioOutput->queue_event(event);
@@ -341,10 +351,10 @@ void AudioDecoder::decode()
 	if (avPacket.size == 0)
 	{
 	    // Decoded complete packet.
+	    TRACE_DEBUG(<< "Queueing ConfirmAudioPacketEvent");
+	    demuxer->queue_event(make_pooled_event<ConfirmAudioPacketEvent>(*packetQueue.front()));
 	    packetQueue.pop();
 	    avPacketIsFree = true;
-	    TRACE_DEBUG(<< "Queueing ConfirmAudioPacketEvent");
-	    demuxer->queue_event(boost::make_shared<ConfirmAudioPacketEvent>());
 	    continue;
 	}
 
@@ -365,6 +375,18 @@ void AudioDecoder::decode()
 		int64_t int_pts = avFrame->pkt_pts;
 #endif
 
+		if (int_pts != AV_NOPTS_VALUE && seekTarget >= 0)
+		{
+		    double framePts = int_pts * av_q2d(avStream->time_base);
+		    double duration = double(avFrame->nb_samples) / avCodecContext->sample_rate;
+		    if (framePts + duration <= seekTarget)
+		    {
+			// Completely before the seek target:
+			continue;
+		    }
+		    seekTarget = -1;
+		}
+
 		if (int_pts != AV_NOPTS_VALUE)
 		{
 		    pts = int_pts;
@@ -27,9 +27,9 @@
 
 class AudioFrame;
 
-class AudioDecoder : public event_receiver<AudioDecoder>
+class AudioDecoder : public event_receiver<AudioDecoder, player_queue_t>
 {
-    friend class event_processor<>;
+    friend class event_processor<player_queue_t>;
 
     enum state_t {
 	Closed,
@@ -52,6 +52,7 @@ class AudioDecoder : public event_receiver<AudioDecoder>
     AVFrame* avFrame;
     bool avFrameIsFree;
     double pts;
+    double seekTarget;  // seconds, negative if not seeking, see FlushReq
     int avFrameBytesTransmittedPerLine;
 
     AVSampleFormat outputAvSampleFormat;
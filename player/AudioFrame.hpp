@@ -54,7 +54,7 @@ public:
     }
 
     void setPTS(double pts_) {pts = pts_;}
-    double getPTS() {return pts;}
+    double getPTS() const {return pts;}
 
     void setNextPTS(double pts_) {nextPts = pts_;}
     double getNextPTS() {return nextPts;}
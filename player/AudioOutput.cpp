@@ -30,6 +30,12 @@
 #include <boost/make_shared.hpp>
 #include <sys/types.h>
 
+bool event_trace_pts<AudioFrame>::get(const AudioFrame& frame, double& pts)
+{
+    pts = frame.getPTS();
+    return true;
+}
+
 AudioOutput::AudioOutput(event_processor_ptr_type evt_proc)
     : base_type(evt_proc),
       mediaPlayer(0),
@@ -74,7 +80,19 @@ void AudioOutput::process(boost::shared_ptr<OpenAudioOutputReq> event)
 
 	TRACE_DEBUG(<< "sampleRate=" << sampleRate << ", channels=" << channels << ", frameSize=" << frameSize);
 
-	alsa = boost::make_shared<AFPCMDigitalAudioInterface>(event);
+	stop_timer(idleTimer);
+	if (idleAlsa && idleAlsa->matches(*event))
+	{
+	    TRACE_DEBUG(<< "reusing audio device");
+	    alsa = idleAlsa;
+	}
+	else
+	{
+	    // Close the idle device before opening it again:
+	    idleAlsa.reset();
+	    alsa = boost::make_shared<AFPCMDigitalAudioInterface>(event);
+	}
+	idleAlsa.reset();
 
 	// Make AudioOutput::sendAudioSyncInfo accessable for AFPCMDigitalAudioInterface: 
 	typedef void (AudioOutput::*fct_t)();
@@ -92,7 +110,7 @@ void AudioOutput::process(boost::shared_ptr<OpenAudioOutputReq> event)
     }
 }
 
-void AudioOutput::process(boost::shared_ptr<CloseAudioOutputReq>)
+void AudioOutput::process(boost::shared_ptr<CloseAudioOutputReq> event)
 {
     if (isOpen())
     {
@@ -100,6 +118,14 @@ void AudioOutput::process(boost::shared_ptr<CloseAudioOutputReq>)
 
 	alsa->stop();
 
+	if (event->keepOutput)
+	{
+	    // Other applications can't use the device meanwhile:
+	    idleAlsa = alsa;
+	    idleTimer.relative(getTimespec(2));
+	    start_timer(boost::make_shared<ReleaseAudioOutputReq>(), idleTimer);
+	}
+
 	// Throw away all queued frames:
 	frameQueue.clear();
 	currentFrame = frameQueue.end();
@@ -117,8 +143,27 @@ void AudioOutput::process(boost::shared_ptr<CloseAudioOutputReq>)
     }
 }
 
+void AudioOutput::process(boost::shared_ptr<ReleaseAudioOutputReq>)
+{
+    if (idleAlsa)
+    {
+	TRACE_DEBUG();
+	stop_timer(idleTimer);
+	idleAlsa.reset();
+    }
+}
+
 void AudioOutput::process(boost::shared_ptr<AudioFrame> event)
 {
+    if (isOpen() && overtaken_by<FlushReq>())
+    {
+	// Frame was sent before the FlushReq. Send it back to
+	// AudioDecoder without playing it:
+	event->reset();
+	audioDecoder->queue_event(event);
+	return;
+    }
+
     if (isOpen())
     {
 	TRACE_DEBUG();
@@ -332,6 +377,7 @@ void AudioOutput::playNextChunk()
 	}
 
 	bool finished = alsa->play(frame);
+	TRACE_RECORD("play chunk: pts, finished", frame->getPTS(), finished);
 
 	if (finished)
 	{
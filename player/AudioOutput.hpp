@@ -36,9 +36,9 @@ class AlsaMixerElemEvent;
 
 struct PlayNextChunk{};
 
-class AudioOutput : public event_receiver<AudioOutput>
+class AudioOutput : public event_receiver<AudioOutput, player_queue_t>
 {
-    friend class event_processor<>;
+    friend class event_processor<player_queue_t>;
 
 public:
     AudioOutput(event_processor_ptr_type evt_proc);
@@ -50,8 +50,13 @@ private:
     MediaPlayer* mediaPlayer;
 
     timer chunkTimer;
+    timer idleTimer;
 
     boost::shared_ptr<AFPCMDigitalAudioInterface> alsa;
+    // Audio device kept open by CloseAudioOutputReq::keepOutput. It is
+    // reused if the next file has the same audio format. Otherwise it is
+    // closed by ReleaseAudioOutputReq, at the latest by idleTimer:
+    boost::shared_ptr<AFPCMDigitalAudioInterface> idleAlsa;
     boost::shared_ptr<AFMixer> alsaMixer;
     typedef std::list<boost::shared_ptr<AudioFrame> > FrameQueue_t;
     FrameQueue_t frameQueue;
@@ -86,6 +91,7 @@ private:
     void process(boost::shared_ptr<InitEvent> event);
     void process(boost::shared_ptr<OpenAudioOutputReq> event);
     void process(boost::shared_ptr<CloseAudioOutputReq> event);
+    void process(boost::shared_ptr<ReleaseAudioOutputReq> event);
     void process(boost::shared_ptr<AudioFrame> event);
     void process(boost::shared_ptr<PlayNextChunk> event);
     void process(boost::shared_ptr<FlushReq> event);
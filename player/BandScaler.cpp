@@ -0,0 +1,225 @@
+//
+// Band Scaler
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "player/BandScaler.hpp"
+#include "player/YuvConversion.hpp"
+#include "platform/Logging.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <string>
+
+extern "C"
+{
+#include <libavutil/pixdesc.h>
+}
+
+// Bands start at multiples of this, which is a multiple of the vertical
+// chroma subsampling of all formats:
+static const int bandAlignment = 16;
+
+// Smaller bands are not worth a thread switch:
+static const int minBandHeight = 64;
+
+static int getNumThreads()
+{
+    int cores = boost::thread::hardware_concurrency();
+    return std::min(std::max(cores, 1), 4);
+}
+
+static int getChromaShift(enum PixelFormat format)
+{
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+    return desc ? desc->log2_chroma_h : 0;
+}
+
+static bool isPaletted(enum PixelFormat format)
+{
+    // The second plane is the palette, which isn't split:
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+    return desc && (desc->flags & PIX_FMT_PAL);
+}
+
+BandScaler::BandScaler()
+    : pool(getNumThreads()),
+      converter(Swscale),
+      numBands(0),
+      width(0),
+      height(0),
+      interlaced(false),
+      srcChromaShift(0),
+      dstChromaShift(0)
+{
+}
+
+BandScaler::~BandScaler()
+{
+    reset();
+}
+
+void BandScaler::init(int srcWidth, int srcHeight, enum PixelFormat srcFormat,
+		      int dstWidth, int dstHeight, enum PixelFormat dstFormat,
+		      int flags)
+{
+    reset();
+
+    converter = Swscale;
+    if (srcWidth == dstWidth && srcHeight == dstHeight && srcFormat == PIX_FMT_YUV420P)
+    {
+	if (dstFormat == PIX_FMT_YUV420P)
+	{
+	    converter = CopyYuv420p;
+	}
+	else if (dstFormat == PIX_FMT_YUYV422)
+	{
+	    converter = Yuv420pToYuy2;
+	}
+    }
+    width = srcWidth;
+    height = srcHeight;
+
+    srcChromaShift = getChromaShift(srcFormat);
+    dstChromaShift = getChromaShift(dstFormat);
+
+    // Swscale clamps at the slice edges when it resamples vertically,
+    // e.g. the chroma planes of YUV420P to YUY2. Bands would show seams
+    // then. The own converters only copy whole chroma lines:
+    bool split = (converter != Swscale) ||
+	(srcHeight == dstHeight && srcChromaShift == dstChromaShift);
+
+    numBands = 1;
+    if (split && !isPaletted(srcFormat))
+    {
+	numBands = std::max(std::min(pool.size(), srcHeight / minBandHeight), 1);
+    }
+
+    int bandHeight = (srcHeight / numBands + bandAlignment - 1) & ~(bandAlignment - 1);
+    for (int i = 0; i < numBands; i++)
+    {
+	srcLines.push_back(std::min(i * bandHeight, srcHeight));
+	dstLines.push_back(std::min(i * bandHeight, dstHeight));
+    }
+    srcLines.push_back(srcHeight);
+    dstLines.push_back(dstHeight);
+
+    if (converter != Swscale)
+    {
+	TRACE_INFO(<< srcWidth << "*" << srcHeight << ", no scaling, "
+		   << (converter == CopyYuv420p ? "copy" : "yuy2")
+		   << " (" << YuvConversion::getName(YuvConversion::getImplementation())
+		   << "), bands = " << numBands);
+	return;
+    }
+
+    for (int i = 0; i < numBands; i++)
+    {
+	int srcBandHeight = srcLines[i+1] - srcLines[i];
+	int dstBandHeight = dstLines[i+1] - dstLines[i];
+
+	struct SwsContext* context =
+	    sws_getContext(srcWidth, srcBandHeight, srcFormat,  // Source
+			   dstWidth, dstBandHeight, dstFormat,  // Destination
+			   flags,                               // Flags
+			   NULL, NULL, NULL);                   // SwsFilter*
+	if (!context)
+	{
+	    reset();
+	    TRACE_THROW(std::string, << "sws_getContext failed");
+	}
+	contexts.push_back(context);
+    }
+
+    TRACE_DEBUG(<< srcWidth << "*" << srcHeight << " -> " << dstWidth << "*" << dstHeight
+		<< ", bands = " << numBands);
+}
+
+void BandScaler::reset()
+{
+    pool.wait();
+
+    for (std::vector<struct SwsContext*>::iterator it = contexts.begin(); it != contexts.end(); it++)
+    {
+	sws_freeContext(*it);
+    }
+    contexts.clear();
+    numBands = 0;
+    srcLines.clear();
+    dstLines.clear();
+}
+
+void BandScaler::start(uint8_t* const srcData_[], const int srcStride_[],
+		       uint8_t* const dstData_[], const int dstStride_[],
+		       bool interlaced_, done_fct_t done)
+{
+    pool.wait();
+
+    // Interlaced chroma lines are used in groups of 4 luma lines:
+    interlaced = interlaced_ && height % 4 == 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+	srcData[i] = srcData_[i];
+	srcStride[i] = srcStride_[i];
+	dstData[i] = dstData_[i];
+	dstStride[i] = dstStride_[i];
+    }
+
+    pool.start(numBands, boost::bind(&BandScaler::scaleBand, this, _1), done);
+}
+
+void BandScaler::wait()
+{
+    pool.wait();
+}
+
+void BandScaler::scaleBand(int band)
+{
+    switch (converter)
+    {
+    case CopyYuv420p:
+	YuvConversion::copyYuv420p(srcData, srcStride, dstData, dstStride,
+				   width, srcLines[band], srcLines[band+1]);
+	return;
+    case Yuv420pToYuy2:
+	YuvConversion::yuv420pToYuy2(srcData, srcStride, dstData[0], dstStride[0],
+				     width, srcLines[band], srcLines[band+1], interlaced);
+	return;
+    case Swscale:
+	break;
+    }
+
+    // Plane 1 and 2 are the chroma planes of planar formats:
+    const uint8_t* src[4];
+    uint8_t* dst[4];
+    for (int i = 0; i < 4; i++)
+    {
+	int srcLine = (i == 1 || i == 2) ? srcLines[band] >> srcChromaShift : srcLines[band];
+	int dstLine = (i == 1 || i == 2) ? dstLines[band] >> dstChromaShift : dstLines[band];
+	src[i] = srcData[i] ? srcData[i] + srcLine * srcStride[i] : 0;
+	dst[i] = dstData[i] ? dstData[i] + dstLine * dstStride[i] : 0;
+    }
+
+    sws_scale(contexts[band],
+	      src, srcStride,                         // Source planes and strides
+	      0, srcLines[band+1] - srcLines[band],   // Slice position and height
+	      dst, dstStride);                        // Destination planes and strides
+}
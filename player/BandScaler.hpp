@@ -0,0 +1,103 @@
+//
+// Band Scaler
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef BAND_SCALER_HPP
+#define BAND_SCALER_HPP
+
+#include "platform/band_pool.hpp"
+
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+#include <vector>
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavutil/avutil.h>
+#include <libswscale/swscale.h>
+}
+
+// Converts images with sws_scale on a band_pool. The image is split into
+// horizontal bands, each converted by its own SwsContext. This needs no
+// synchronization between the bands, but a band can't use lines of its
+// neighbours. Thus images are only split if the height is not scaled.
+//
+// Same size conversions of YUV420P into YV12 or YUY2 don't use
+// sws_scale, see YuvConversion.
+//
+// The VideoDecoder only waits for the scaler before it queues the next
+// frame, i.e. the next frame is decoded while the current one is
+// converted.
+
+class BandScaler : private boost::noncopyable
+{
+public:
+    typedef boost::function<void ()> done_fct_t;
+
+    BandScaler();
+    ~BandScaler();
+
+    // Throws if sws_getContext fails:
+    void init(int srcWidth, int srcHeight, enum PixelFormat srcFormat,
+	      int dstWidth, int dstHeight, enum PixelFormat dstFormat,
+	      int flags);
+    void reset();
+    bool isInitialized() const {return numBands > 0;}
+
+    // Returns immediately. done is called by a worker thread when the
+    // complete image is converted. The planes must be valid until then.
+    // interlaced selects the chroma lines of the YUY2 conversion:
+    void start(uint8_t* const srcData[], const int srcStride[],
+	       uint8_t* const dstData[], const int dstStride[],
+	       bool interlaced, done_fct_t done);
+    void wait();
+
+private:
+    enum Converter
+    {
+	Swscale,
+	CopyYuv420p,
+	Yuv420pToYuy2
+    };
+
+    void scaleBand(int band);
+
+    band_pool pool;
+
+    Converter converter;
+    int numBands;
+    int width;
+    int height;
+    bool interlaced;
+
+    std::vector<struct SwsContext*> contexts;
+    std::vector<int> srcLines;  // first line of each band, plus height
+    std::vector<int> dstLines;
+    int srcChromaShift;         // log2 of vertical chroma subsampling
+    int dstChromaShift;
+
+    uint8_t* srcData[4];
+    int srcStride[4];
+    uint8_t* dstData[4];
+    int dstStride[4];
+};
+
+#endif
@@ -0,0 +1,175 @@
+//
+// YUV Conversion Benchmark
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Compares the same size conversions of YUV420P into YV12 and YUY2 used
+// by the BandScaler with sws_scale. All implementations of the YUY2
+// conversion have to produce the same image as the generic one.
+//
+
+#include "player/YuvConversion.hpp"
+#include "platform/benchmark.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+extern "C"
+{
+#include <libswscale/swscale.h>
+}
+
+const int numFrames = 200;
+
+struct Image
+{
+    Image(int width, int height, bool packed)
+    {
+	if (packed)
+	{
+	    stride[0] = (2 * width + 63) & ~63;
+	    stride[1] = stride[2] = 0;
+	}
+	else
+	{
+	    stride[0] = (width + 63) & ~63;
+	    stride[1] = stride[2] = (width / 2 + 63) & ~63;
+	}
+	stride[3] = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+	    int lines = i == 0 ? height : (height + 1) / 2;
+	    planes[i].resize(stride[i] * lines + 64);
+	    data[i] = stride[i] ? &planes[i][0] : 0;
+	}
+	data[3] = 0;
+    }
+
+    void fill()
+    {
+	for (int i = 0; i < 3; i++)
+	{
+	    fill_random(planes[i]);
+	}
+    }
+
+    std::vector<uint8_t> planes[3];
+    uint8_t* data[4];
+    int stride[4];
+};
+
+static void report(const char* name, double seconds, double reference)
+{
+    std::cout << "  " << std::left << std::setw(24) << name << std::right
+	      << std::fixed << std::setprecision(3) << std::setw(8) << 1e3 * seconds << " ms"
+	      << std::setprecision(1) << std::setw(8) << reference / seconds << "x"
+	      << std::endl;
+}
+
+static double swscale(const Image& src, Image& dst, int width, int height,
+		      enum PixelFormat dstFormat)
+{
+    struct SwsContext* context =
+	sws_getContext(width, height, PIX_FMT_YUV420P,
+		       width, height, dstFormat,
+		       SWS_BICUBIC, NULL, NULL, NULL);
+    if (!context)
+    {
+	std::cout << "sws_getContext failed" << std::endl;
+	exit(1);
+    }
+
+    double seconds = measure(numFrames, [&] {
+	    sws_scale(context, src.data, src.stride, 0, height, dst.data, dst.stride);
+	});
+
+    sws_freeContext(context);
+    return seconds;
+}
+
+static int benchmark(int width, int height)
+{
+    int errors = 0;
+
+    Image src(width, height, false);
+    Image yv12(width, height, false);
+    Image yuy2(width, height, true);
+    Image reference(width, height, true);
+    src.fill();
+
+    std::cout << width << "*" << height << ", YUV420P -> YV12:" << std::endl;
+    double sws = swscale(src, yv12, width, height, PIX_FMT_YUV420P);
+    report("swscale", sws, sws);
+    report("copy", measure(numFrames, [&] {
+		YuvConversion::copyYuv420p(src.data, src.stride, yv12.data, yv12.stride,
+					   width, 0, height);
+	    }), sws);
+
+    for (int interlaced = 0; interlaced < 2; interlaced++)
+    {
+	std::cout << width << "*" << height << ", YUV420P -> YUY2"
+		  << (interlaced ? ", interlaced:" : ":") << std::endl;
+	if (!interlaced)
+	{
+	    sws = swscale(src, yuy2, width, height, PIX_FMT_YUYV422);
+	    report("swscale", sws, sws);
+	}
+
+	YuvConversion::yuv420pToYuy2(YuvConversion::Generic,
+				     src.data, src.stride, reference.data[0], reference.stride[0],
+				     width, 0, height, interlaced);
+
+	for (int i = YuvConversion::Generic; i <= YuvConversion::AVX2; i++)
+	{
+	    YuvConversion::Implementation impl = YuvConversion::Implementation(i);
+	    if (!YuvConversion::isSupported(impl))
+	    {
+		continue;
+	    }
+
+	    memset(&yuy2.planes[0][0], 0, yuy2.planes[0].size());
+	    report(YuvConversion::getName(impl), measure(numFrames, [&] {
+			YuvConversion::yuv420pToYuy2(impl, src.data, src.stride,
+						     yuy2.data[0], yuy2.stride[0],
+						     width, 0, height, interlaced);
+		    }), sws);
+
+	    if (yuy2.planes[0] != reference.planes[0])
+	    {
+		std::cout << "  " << YuvConversion::getName(impl) << " differs from generic" << std::endl;
+		errors++;
+	    }
+	}
+    }
+
+    return errors;
+}
+
+int main()
+{
+    int errors = 0;
+    errors += benchmark(720, 576);
+    errors += benchmark(1920, 1080);
+    errors += benchmark(701, 480);  // odd width, not a multiple of 16
+
+    return test_result(errors);
+}
@@ -0,0 +1,142 @@
+//
+// Deinterlacer Benchmark
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Deinterlaces 1080i fields with each scan line method, on the calling
+// thread and on band_pools with several threads. The output of the
+// pools has to be identical to the output of the calling thread.
+//
+
+#include "player/DeinterlaceJob.hpp"
+#include "platform/band_pool.hpp"
+#include "platform/benchmark.hpp"
+
+#include "deinterlacer/src/deinterlace.h"
+
+#include <boost/thread/thread.hpp>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <vector>
+
+const int width = 1920;
+const int height = 1080;
+const int numFields = 50;
+
+struct Image
+{
+    Image()
+	: buffer(2 * width * height)
+    {
+	memset(&xvImage, 0, sizeof(xvImage));
+	pitch = 2 * width;
+	offset = 0;
+	xvImage.width = width;
+	xvImage.height = height;
+	xvImage.data_size = buffer.size();
+	xvImage.num_planes = 1;
+	xvImage.pitches = &pitch;
+	xvImage.offsets = &offset;
+	xvImage.data = &buffer[0];
+    }
+
+    std::vector<char> buffer;
+    int pitch;
+    int offset;
+    XvImage xvImage;
+};
+
+// Seconds per field, alternating between top and bottom field:
+static double deinterlace(deinterlace_method_t* method, Image& output, Image* fields,
+			  band_pool* pool)
+{
+    int i = 0;
+    return measure(numFields, [&] {
+	    DeinterlaceJob job(method, &output.xvImage,
+			       &fields[0].xvImage, &fields[1].xvImage,
+			       &fields[2].xvImage, &fields[3].xvImage,
+			       i++ % 2 == 0, 0, height);
+	    if (pool)
+	    {
+		job.run(*pool);
+	    }
+	    else
+	    {
+		job.run();
+	    }
+	});
+}
+
+int main()
+{
+    DeinterlaceJob::registerMethods();
+
+    Image fields[4];
+    for (int i = 0; i < 4; i++)
+    {
+	fill_random(fields[i].buffer);
+    }
+    Image reference;
+    Image output;
+
+    std::vector<int> threads;
+    threads.push_back(2);
+    threads.push_back(4);
+    int cores = boost::thread::hardware_concurrency();
+    if (cores > 4)
+    {
+	threads.push_back(cores);
+    }
+
+    int errors = 0;
+    int i = 0;
+    while (deinterlace_method_t* method = get_deinterlace_method(i++))
+    {
+	if (!method->scanlinemode)
+	{
+	    continue;
+	}
+
+	std::cout << method->name << ", " << width << "*" << height << ":" << std::endl;
+
+	double serial = deinterlace(method, reference, fields, 0);
+	std::cout << "  1 thread:  " << std::fixed << std::setprecision(1)
+		  << std::setw(8) << 1 / serial << " fields/s" << std::endl;
+
+	for (size_t t = 0; t < threads.size(); t++)
+	{
+	    band_pool pool(threads[t]);
+	    memset(&output.buffer[0], 0, output.buffer.size());
+	    double seconds = deinterlace(method, output, fields, &pool);
+	    std::cout << "  " << threads[t] << " threads: "
+		      << std::setw(8) << 1 / seconds << " fields/s, speedup "
+		      << std::setprecision(2) << serial / seconds << std::setprecision(1);
+
+	    // Both measurements ended with the same field:
+	    if (output.buffer != reference.buffer)
+	    {
+		std::cout << ", differs from 1 thread";
+		errors++;
+	    }
+	    std::cout << std::endl;
+	}
+    }
+
+    return test_result(errors);
+}
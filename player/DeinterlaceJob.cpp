@@ -0,0 +1,287 @@
+//
+// Deinterlace Job
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "player/DeinterlaceJob.hpp"
+#include "platform/band_pool.hpp"
+
+#include "deinterlacer/plugins/plugins.h"
+#include "deinterlacer/src/deinterlace.h"
+#include "deinterlacer/src/copyfunctions.h"
+#include "deinterlacer/src/mm_accel.h"
+
+#include <boost/bind.hpp>
+#include <algorithm>
+
+// Smaller bands are not worth a thread switch:
+static const int minBandPairs = 32;
+
+static inline uint8_t* getLineAddr(XvImage* yuvImage, int line)
+{
+    char* Packed = yuvImage->data + yuvImage->offsets[0];
+    char* Line = Packed + line * yuvImage->pitches[0];
+    return (uint8_t*)Line;
+    
+}
+
+// -------------------------------------------------------------------
+// Line offsets used for the scan line mode:
+
+template<int n>
+struct LineOffsets;
+
+template<>
+struct LineOffsets<-2>   // top most line
+{
+    enum {tt =  2};
+    enum {t  =  1};
+    enum {m  =  0};
+    enum {b  =  1};
+    enum {bb =  2};
+};
+
+template<>
+struct LineOffsets<-1>   // second line
+{
+    enum {tt =  0};
+    enum {t  = -1};
+    enum {m  =  0};
+    enum {b  =  1};
+    enum {bb =  2};
+};
+
+template<>
+struct LineOffsets<0>    // all lines in the middle
+{
+    enum {tt = -2};
+    enum {t  = -1};
+    enum {m  =  0};
+    enum {b  =  1};
+    enum {bb =  2};
+};
+
+
+template<>
+struct LineOffsets<1>   // second last line
+{
+    enum {tt = -2};
+    enum {t  = -1};
+    enum {m  =  0};
+    enum {b  =  1};
+    enum {bb =  0};
+};
+
+template<>
+struct LineOffsets<2>   // bottom most line
+{
+    enum {tt = -2};
+    enum {t  = -1};
+    enum {m  =  0};
+    enum {b  = -1};
+    enum {bb = -2};
+};
+
+
+// -------------------------------------------------------------------
+// For scan line mode:
+
+template<int n>
+static inline void copyLine(deinterlace_copy_scanline_t copy, int line, XvImage* yuvImage,
+			    XvImage* field0, XvImage* field1, XvImage* field2, XvImage* field3,
+			    bool bottomField, int clippingTop, int clippingBottom)
+{
+    if (line<clippingTop) return;
+    if (line>clippingBottom) return;
+    uint8_t* out = getLineAddr(yuvImage, line);
+    uint8_t* tt0 = getLineAddr(field0, line + LineOffsets<n>::tt);
+    uint8_t* m0  = getLineAddr(field0, line);
+    uint8_t* bb0 = getLineAddr(field0, line + LineOffsets<n>::bb);
+    uint8_t* t1  = getLineAddr(field1, line + LineOffsets<n>::t);
+    uint8_t* b1  = getLineAddr(field1, line + LineOffsets<n>::b);
+    uint8_t* tt2 = getLineAddr(field2, line + LineOffsets<n>::tt);
+    uint8_t* m2  = getLineAddr(field2, line);
+    uint8_t* bb2 = getLineAddr(field2, line + LineOffsets<n>::bb);
+    uint8_t* t3  = getLineAddr(field3, line + LineOffsets<n>::t);
+    uint8_t* b3  = getLineAddr(field3, line + LineOffsets<n>::b);
+    deinterlace_scanline_data_s data = {tt0,  0, m0,  0,bb0,
+					0,   t1,  0, b1,  0,
+					tt2,  0, m2,  0,bb2,
+					0,   t3,  0, b3,  0,
+					bottomField};
+    copy(out, &data, yuvImage->width);
+}
+
+template<int n>
+static inline void intpLine(deinterlace_interp_scanline_t intp, int line, XvImage* yuvImage,
+			    XvImage* field0, XvImage* field1, XvImage* field2, XvImage* field3,
+			    bool bottomField, int clippingTop, int clippingBottom)
+{
+    if (line<clippingTop) return;
+    if (line>clippingBottom) return;
+    uint8_t* out = getLineAddr(yuvImage, line);
+    uint8_t* t0  = getLineAddr(field0, line + LineOffsets<n>::t);
+    uint8_t* b0  = getLineAddr(field0, line + LineOffsets<n>::b);
+    uint8_t* tt1 = getLineAddr(field1, line + LineOffsets<n>::tt);
+    uint8_t* m1  = getLineAddr(field1, line);
+    uint8_t* bb1 = getLineAddr(field1, line + LineOffsets<n>::bb);
+    uint8_t* t2  = getLineAddr(field2, line + LineOffsets<n>::t);
+    uint8_t* b2  = getLineAddr(field2, line + LineOffsets<n>::b);
+    uint8_t* tt3 = getLineAddr(field3, line + LineOffsets<n>::tt);
+    uint8_t* m3  = getLineAddr(field3, line);
+    uint8_t* bb3 = getLineAddr(field3, line + LineOffsets<n>::bb);
+    deinterlace_scanline_data_s data = {0,   t0,  0, b0,  0,
+					tt1,  0, m1,  0,bb1,
+					0,   t2,  0, b2,  0,
+					tt3,  0, m3,  0,bb3,
+					bottomField};
+    intp(out, &data, yuvImage->width);
+}
+
+// -------------------------------------------------------------------
+
+DeinterlaceJob::DeinterlaceJob(deinterlace_method_t* method, XvImage* output,
+			       XvImage* field0, XvImage* field1, XvImage* field2, XvImage* field3,
+			       bool topField, int clippingTop, int clippingBottom)
+    : method(method),
+      output(output),
+      field0(field0),
+      field1(field1),
+      field2(field2),
+      field3(field3),
+      topField(topField),
+      clippingTop(clippingTop),
+      clippingBottom(clippingBottom)
+{
+    // The middle lines start at line 2 and end at the first even
+    // line >= h-3:
+    int h = output->height;
+    numPairs = std::max((h - 3 - 2 + 1) / 2, 0);
+}
+
+void DeinterlaceJob::registerMethods()
+{
+    setup_copyfunctions(MM_ACCEL_X86_MMXEXT);
+
+    register_deinterlace_method(greedy_get_method());
+    // register_deinterlace_method(dscaler_greedyh_get_method());
+    // register_deinterlace_method(dscaler_tomsmocomp_get_method());
+    register_deinterlace_method(linearblend_get_method());
+    register_deinterlace_method(linear_get_method());
+    // deinterlace_method_t struct does not define interpolate and copy functions:
+    // register_deinterlace_method(scalerbob_get_method());
+    register_deinterlace_method(vfir_get_method());
+    register_deinterlace_method(weavebff_get_method());
+    register_deinterlace_method(weave_get_method());
+    register_deinterlace_method(weavetff_get_method());
+}
+
+void DeinterlaceJob::run()
+{
+    processBand(0, 1);
+}
+
+void DeinterlaceJob::run(band_pool& pool)
+{
+    int numBands = std::max(std::min(pool.size(), numPairs / minBandPairs), 1);
+    if (numBands == 1)
+    {
+	processBand(0, 1);
+	return;
+    }
+
+    pool.run(numBands, boost::bind(&DeinterlaceJob::processBand, this, _1, numBands));
+}
+
+void DeinterlaceJob::processBand(int band, int numBands)
+{
+    deinterlace_interp_scanline_t intp = method->interpolate_scanline;
+    deinterlace_copy_scanline_t   copy = method->copy_scanline;
+
+    int h = output->height;
+    int& ctop = clippingTop;
+    int& cbot = clippingBottom;
+
+    int firstLine = 2 + 2 * (band * numPairs / numBands);
+    int lastLine = 2 + 2 * ((band + 1) * numPairs / numBands);
+
+    if (topField)
+    {
+	// Field 0 is a top field:
+	if (band == 0)
+	{
+	    copyLine<-2>(copy, 0, output, field0, field1, field2, field3, false, ctop, cbot);
+	    intpLine<-1>(intp, 1, output, field0, field1, field2, field3, false, ctop, cbot);
+	}
+
+	for (int line = firstLine; line < lastLine; line += 2)
+	{
+	    copyLine<0>(copy, line, output, field0, field1, field2, field3, false, ctop, cbot);
+	    intpLine<0>(intp, line+1, output, field0, field1, field2, field3, false, ctop, cbot);
+	}
+
+	if (band == numBands - 1)
+	{
+	    int line = lastLine;
+	    if (line == h-2)
+	    {
+		copyLine<1>(copy, line, output, field0, field1, field2, field3, false, ctop, cbot);
+		intpLine<2>(intp, line, output, field0, field1, field2, field3, false, ctop, cbot);
+	    }
+	    else
+	    {
+		copyLine<0>(copy, line, output, field0, field1, field2, field3, false, ctop, cbot);
+		intpLine<1>(intp, line, output, field0, field1, field2, field3, false, ctop, cbot);
+		copyLine<2>(copy, line, output, field0, field1, field2, field3, false, ctop, cbot);
+	    }
+	}
+    }
+    else
+    {
+	// Field 0 is a bottom field:
+	if (band == 0)
+	{
+	    intpLine<-2>(intp, 0, output, field0, field1, field2, field3, true, ctop, cbot);
+	    copyLine<-1>(copy, 1, output, field0, field1, field2, field3, true, ctop, cbot);
+	}
+
+	for (int line = firstLine; line < lastLine; line += 2)
+	{
+	    intpLine<0>(intp, line, output, field0, field1, field2, field3, true, ctop, cbot);
+	    copyLine<0>(copy, line+1, output, field0, field1, field2, field3, true, ctop, cbot);
+	}
+
+	if (band == numBands - 1)
+	{
+	    int line = lastLine;
+	    if (line == h-2)
+	    {
+		intpLine<1>(intp, line, output, field0, field1, field2, field3, true, ctop, cbot);
+		copyLine<2>(copy, line, output, field0, field1, field2, field3, true, ctop, cbot);
+	    }
+	    else
+	    {
+		intpLine<0>(intp, line, output, field0, field1, field2, field3, true, ctop, cbot);
+		copyLine<1>(copy, line, output, field0, field1, field2, field3, true, ctop, cbot);
+		intpLine<2>(intp, line, output, field0, field1, field2, field3, true, ctop, cbot);
+	    }
+	}
+    }
+}
@@ -0,0 +1,74 @@
+//
+// Deinterlace Job
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef DEINTERLACE_JOB_HPP
+#define DEINTERLACE_JOB_HPP
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>  // has to be included before Xvlib.h
+#include <X11/extensions/Xvlib.h>
+
+class band_pool;
+struct deinterlace_method_s;
+typedef struct deinterlace_method_s deinterlace_method_t;
+
+// Deinterlaces one field into a packed YUY2 image in scan line mode.
+// Each output line is calculated from the input fields only. Thus the
+// lines can be split into bands, that are processed on a band_pool,
+// with exactly the same result as on one thread.
+//
+// Bands are made of line pairs, i.e. one copied and one interpolated
+// line. The first band additionally does the two top most lines, the
+// last band the bottom most lines. These need the special line offsets.
+
+class DeinterlaceJob
+{
+public:
+    DeinterlaceJob(deinterlace_method_t* method, XvImage* output,
+		   XvImage* field0, XvImage* field1, XvImage* field2, XvImage* field3,
+		   bool topField, int clippingTop, int clippingBottom);
+
+    // Processes all lines on the calling thread:
+    void run();
+    // Processes the bands on the pool, the calling thread waits:
+    void run(band_pool& pool);
+
+    // Registers the methods working in scan line mode:
+    static void registerMethods();
+
+private:
+    void processBand(int band, int numBands);
+
+    deinterlace_method_t* method;
+    XvImage* output;
+    XvImage* field0;
+    XvImage* field1;
+    XvImage* field2;
+    XvImage* field3;
+    bool topField;
+    int clippingTop;
+    int clippingBottom;
+
+    int numPairs;  // line pairs between the top and bottom most lines
+};
+
+#endif
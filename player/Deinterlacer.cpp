@@ -20,6 +20,7 @@
 //
 
 #include "player/Deinterlacer.hpp"
+#include "player/DeinterlaceJob.hpp"
 #include "player/MediaPlayer.hpp"
 #include "player/VideoOutput.hpp"
 #include "player/VideoDecoder.hpp"
@@ -28,33 +29,29 @@
 
 #include "deinterlacer/plugins/plugins.h"
 #include "deinterlacer/src/deinterlace.h"
-#include "deinterlacer/src/copyfunctions.h"
-#include "deinterlacer/src/mm_accel.h"
+
+#include <algorithm>
 
 // #undef TRACE_DEBUG
 // #define TRACE_DEBUG(s) std::cout << __PRETTY_FUNCTION__ << " " s << std::endl;
 
+static int getNumThreads()
+{
+    // The decoder thread waits while the bands are processed:
+    int cores = boost::thread::hardware_concurrency();
+    return std::min(std::max(cores, 1), 8);
+}
+
 Deinterlacer::Deinterlacer(event_processor_ptr_type evt_proc)
     : base_type(evt_proc),
       m_topFieldFirst(true),
       m_nextImageHasContent(true),
       m_topField(true),
       m_clippingTop(0),
-      m_clippingBottom(1080)
+      m_clippingBottom(1080),
+      m_pool(getNumThreads())
 {
-    setup_copyfunctions(MM_ACCEL_X86_MMXEXT);
-
-    register_deinterlace_method(greedy_get_method());
-    // register_deinterlace_method(dscaler_greedyh_get_method());
-    // register_deinterlace_method(dscaler_tomsmocomp_get_method());
-    register_deinterlace_method(linearblend_get_method());
-    register_deinterlace_method(linear_get_method());
-    // deinterlace_method_t struct does not define interpolate and copy functions:
-    // register_deinterlace_method(scalerbob_get_method());
-    register_deinterlace_method(vfir_get_method());
-    register_deinterlace_method(weavebff_get_method());
-    register_deinterlace_method(weave_get_method());
-    register_deinterlace_method(weavetff_get_method());
+    DeinterlaceJob::registerMethods();
 
     m_deinterlacer = greedy_get_method();
 }
@@ -106,6 +103,15 @@ void Deinterlacer::process(std::unique_ptr<XFVideoImage> event)
 {
     TRACE_DEBUG(<< m_interlacedImages.size() << ", " << m_emptyImages.size());
 
+    if (overtaken_by<FlushReq>())
+    {
+	// Image was decoded before the FlushReq. Send it back to
+	// VideoDecoder without showing it:
+	videoDecoder->queue_event(std::move(event));
+	m_nextImageHasContent = !m_nextImageHasContent;
+	return;
+    }
+
     if (m_deinterlacer)
     {
 	// Deinterlacer enabled:
@@ -267,129 +273,6 @@ void Deinterlacer::process(boost::shared_ptr<NotificationClipping> event)
 
 // -------------------------------------------------------------------
 
-static inline uint8_t* getLineAddr(XvImage* yuvImage, int line)
-{
-    char* Packed = yuvImage->data + yuvImage->offsets[0];
-    char* Line = Packed + line * yuvImage->pitches[0];
-    return (uint8_t*)Line;
-    
-}
-
-// -------------------------------------------------------------------
-// Line offsets used for the scan line mode:
-
-template<int n>
-struct LineOffsets;
-
-template<>
-struct LineOffsets<-2>   // top most line
-{
-    enum {tt =  2};
-    enum {t  =  1};
-    enum {m  =  0};
-    enum {b  =  1};
-    enum {bb =  2};
-};
-
-template<>
-struct LineOffsets<-1>   // second line
-{
-    enum {tt =  0};
-    enum {t  = -1};
-    enum {m  =  0};
-    enum {b  =  1};
-    enum {bb =  2};
-};
-
-template<>
-struct LineOffsets<0>    // all lines in the middle
-{
-    enum {tt = -2};
-    enum {t  = -1};
-    enum {m  =  0};
-    enum {b  =  1};
-    enum {bb =  2};
-};
-
-
-template<>
-struct LineOffsets<1>   // second last line
-{
-    enum {tt = -2};
-    enum {t  = -1};
-    enum {m  =  0};
-    enum {b  =  1};
-    enum {bb =  0};
-};
-
-template<>
-struct LineOffsets<2>   // bottom most line
-{
-    enum {tt = -2};
-    enum {t  = -1};
-    enum {m  =  0};
-    enum {b  = -1};
-    enum {bb = -2};
-};
-
-
-// -------------------------------------------------------------------
-// For scan line mode:
-
-template<int n>
-static inline void copyLine(deinterlace_copy_scanline_t copy, int line, XvImage* yuvImage,
-			    XvImage* field0, XvImage* field1, XvImage* field2, XvImage* field3,
-			    bool bottomField, int clippingTop, int clippingBottom)
-{
-    if (line<clippingTop) return;
-    if (line>clippingBottom) return;
-    uint8_t* out = getLineAddr(yuvImage, line);
-    uint8_t* tt0 = getLineAddr(field0, line + LineOffsets<n>::tt);
-    uint8_t* m0  = getLineAddr(field0, line);
-    uint8_t* bb0 = getLineAddr(field0, line + LineOffsets<n>::bb);
-    uint8_t* t1  = getLineAddr(field1, line + LineOffsets<n>::t);
-    uint8_t* b1  = getLineAddr(field1, line + LineOffsets<n>::b);
-    uint8_t* tt2 = getLineAddr(field2, line + LineOffsets<n>::tt);
-    uint8_t* m2  = getLineAddr(field2, line);
-    uint8_t* bb2 = getLineAddr(field2, line + LineOffsets<n>::bb);
-    uint8_t* t3  = getLineAddr(field3, line + LineOffsets<n>::t);
-    uint8_t* b3  = getLineAddr(field3, line + LineOffsets<n>::b);
-    deinterlace_scanline_data_s data = {tt0,  0, m0,  0,bb0,
-					0,   t1,  0, b1,  0,
-					tt2,  0, m2,  0,bb2,
-					0,   t3,  0, b3,  0,
-					bottomField};
-    copy(out, &data, yuvImage->width);
-}
-
-template<int n>
-static inline void intpLine(deinterlace_interp_scanline_t intp, int line, XvImage* yuvImage,
-			    XvImage* field0, XvImage* field1, XvImage* field2, XvImage* field3,
-			    bool bottomField, int clippingTop, int clippingBottom)
-{
-    if (line<clippingTop) return;
-    if (line>clippingBottom) return;
-    uint8_t* out = getLineAddr(yuvImage, line);
-    uint8_t* t0  = getLineAddr(field0, line + LineOffsets<n>::t);
-    uint8_t* b0  = getLineAddr(field0, line + LineOffsets<n>::b);
-    uint8_t* tt1 = getLineAddr(field1, line + LineOffsets<n>::tt);
-    uint8_t* m1  = getLineAddr(field1, line);
-    uint8_t* bb1 = getLineAddr(field1, line + LineOffsets<n>::bb);
-    uint8_t* t2  = getLineAddr(field2, line + LineOffsets<n>::t);
-    uint8_t* b2  = getLineAddr(field2, line + LineOffsets<n>::b);
-    uint8_t* tt3 = getLineAddr(field3, line + LineOffsets<n>::tt);
-    uint8_t* m3  = getLineAddr(field3, line);
-    uint8_t* bb3 = getLineAddr(field3, line + LineOffsets<n>::bb);
-    deinterlace_scanline_data_s data = {0,   t0,  0, b0,  0,
-					tt1,  0, m1,  0,bb1,
-					0,   t2,  0, b2,  0,
-					tt3,  0, m3,  0,bb3,
-					bottomField};
-    intp(out, &data, yuvImage->width);
-}
-
-// -------------------------------------------------------------------
-
 void Deinterlacer::deinterlace()
 {
     TRACE_DEBUG();
@@ -397,20 +280,12 @@ void Deinterlacer::deinterlace()
     m_emptyImages.pop();
 
     XvImage* yuvImage = image->xvImage();
-    //int w = yuvImage->width;
-    int h = yuvImage->height;
-    //char* Packed = yuvImage->data + yuvImage->offsets[0];
 
     std::list<std::unique_ptr<XFVideoImage> >::iterator it = m_interlacedImages.begin();
 
     double pts;
 
-    deinterlace_interp_scanline_t intp = m_deinterlacer->interpolate_scanline;
-    deinterlace_copy_scanline_t   copy = m_deinterlacer->copy_scanline;
-
     XvImage *field0, *field1, *field2, *field3;
-    int& ctop = m_clippingTop;
-    int& cbot = m_clippingBottom;
 
     if (m_topField == m_topFieldFirst)
     {
@@ -433,64 +308,11 @@ void Deinterlacer::deinterlace()
 	field3 = (*it)->xvImage();
     }
 
-    if (m_topField)
-    {
-	// Field 0 is a top field:
-	int line = 0;
-	copyLine<-2>(copy, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	line++;
-	intpLine<-1>(intp, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	line++;
-
-	while (line < h-3)
-	{
-	    copyLine<0>(copy, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	    line++;
-	    intpLine<0>(intp, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	    line++;
-	}
+    TRACE_RECORD("deinterlace: pts, topField", pts, m_topField);
 
-	if (line == h-2)
-	{
-	    copyLine<1>(copy, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	    intpLine<2>(intp, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	}
-	else
-	{
-	    copyLine<0>(copy, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	    intpLine<1>(intp, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	    copyLine<2>(copy, line, yuvImage, field0, field1, field2, field3, false, ctop, cbot);
-	}
-    }
-    else
-    {
-	// Field 0 is a bottom field:
-	int line = 0;
-	intpLine<-2>(intp, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	line++;
-	copyLine<-1>(copy, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	line++;
-
-	while (line < h-3)
-	{
-	    intpLine<0>(intp, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	    line++;
-	    copyLine<0>(copy, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	    line++;
-	}
-
-	if (line == h-2)
-	{
-	    intpLine<1>(intp, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	    copyLine<2>(copy, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	}
-	else
-	{
-	    intpLine<0>(intp, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	    copyLine<1>(copy, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	    intpLine<2>(intp, line, yuvImage, field0, field1, field2, field3, true, ctop, cbot);
-	}
-    }
+    DeinterlaceJob job(m_deinterlacer, yuvImage, field0, field1, field2, field3,
+		       m_topField, m_clippingTop, m_clippingBottom);
+    job.run(m_pool);
 
     if (m_topField != m_topFieldFirst)
     {
@@ -23,6 +23,7 @@
 #define DEINTERLACER_HPP
 
 #include "player/GeneralEvents.hpp"
+#include "platform/band_pool.hpp"
 #include "platform/event_receiver.hpp"
 
 #include <boost/shared_ptr.hpp>
@@ -35,9 +36,9 @@ typedef struct deinterlace_method_s deinterlace_method_t;
 struct TopFieldFirst {};
 struct BottomFieldFirst {};
 
-class Deinterlacer : public event_receiver<Deinterlacer>
+class Deinterlacer : public event_receiver<Deinterlacer, player_queue_t>
 {
-    friend class event_processor<>;
+    friend class event_processor<player_queue_t>;
 
     std::queue<std::unique_ptr<XFVideoImage> > m_emptyImages;
     std::list<std::unique_ptr<XFVideoImage> > m_interlacedImages;
@@ -49,6 +50,9 @@ class Deinterlacer : public event_receiver<Deinterlacer>
     int m_clippingTop;
     int m_clippingBottom;
 
+    // Lines are deinterlaced in bands, see DeinterlaceJob:
+    band_pool m_pool;
+
 public:
     Deinterlacer(event_processor_ptr_type evt_proc);
     ~Deinterlacer();
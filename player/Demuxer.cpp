@@ -23,9 +23,13 @@
 #include "player/AudioDecoder.hpp"
 #include "player/VideoDecoder.hpp"
 #include "player/MediaPlayer.hpp"
+#include "platform/event_pool.hpp"
 
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <errno.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 
 extern "C"
@@ -37,22 +41,34 @@ Demuxer::Demuxer(event_processor_ptr_type evt_proc)
     : base_type(evt_proc),
       m_event_processor(evt_proc),
       avFormatContext(0),
+      readAheadSize(8 * 1024 * 1024),
+      avioContext(0),
+      accurateSeek(true),
+      trickPlaySpeed(0),
+      trickPlayPosition(0),
+      trickPlayTarget(0),
+      trickPlaySearching(false),
+      preOpenedFormatContext(0),
+      preOpenedAvioContext(0),
+      preOpenId(0),
+      preOpenAborted(false),
       systemStreamStatus(SystemStreamClosed),
       systemStreamFailed(false),
       audioStreamIndex(-1),
       videoStreamIndex(-1),
       audioStreamStatus(StreamClosed),
       videoStreamStatus(StreamClosed),
-      queuedAudioPackets(0),
-      queuedVideoPackets(0),
-      targetQueuedAudioPackets(10),
-      targetQueuedVideoPackets(10),
       numAnnouncedStreams(0)
 {
     av_register_all();
 }
 
-Demuxer::~Demuxer(){}
+Demuxer::~Demuxer()
+{
+    stopPreOpen();
+    closeReadAheadFile(readAheadFile, avioContext);
+    closePreOpenedFile();
+}
 
 int Demuxer::interruptCallback(void* ptr)
 {
@@ -62,12 +78,48 @@ int Demuxer::interruptCallback(void* ptr)
     return obj->m_event_processor->terminating() || !obj->m_event_processor->empty();
 }
 
+int Demuxer::preOpenInterruptCallback(void* ptr)
+{
+    // Called by the pre-open thread. Pending events of the Demuxer are
+    // processed meanwhile and must not abort it:
+    Demuxer* obj = (Demuxer*)ptr;
+    return obj->m_event_processor->terminating() || obj->preOpenAborted;
+}
+
+int Demuxer::readPacket(void* opaque, uint8_t* buf, int size)
+{
+    int ret = ((ReadAheadFile*)opaque)->read(buf, size);
+    if (ret == 0)
+    {
+	return AVERROR_EOF;
+    }
+    if (ret < 0)
+    {
+	return AVERROR(EIO);
+    }
+    return ret;
+}
+
+int64_t Demuxer::seekPacket(void* opaque, int64_t offset, int whence)
+{
+    ReadAheadFile* file = (ReadAheadFile*)opaque;
+    whence &= ~AVSEEK_FORCE;
+    if (whence == AVSEEK_SIZE)
+    {
+	return file->size();
+    }
+    return file->seek(offset, whence);
+}
+
 void Demuxer::process(boost::shared_ptr<InitEvent> event)
 {
     TRACE_DEBUG(<< "tid = " << gettid());
     mediaPlayer = event->mediaPlayer;
     audioDecoder = event->audioDecoder;
     videoDecoder = event->videoDecoder;
+
+    // Not done by the GUI thread showing the play list:
+    ProbeCache::instance().load();
 }
 
 void Demuxer::process(boost::shared_ptr<StopEvent>)
@@ -77,38 +129,26 @@ void Demuxer::process(boost::shared_ptr<StopEvent>)
 
 void Demuxer::process(boost::shared_ptr<OpenFileReq> event)
 {
-    if (systemStreamStatus == SystemStreamClosed)
+    if (systemStreamStatus == SystemStreamClosed &&
+	preOpenThread.joinable() && preOpeningFileName == event->fileName)
+    {
+	// Continued when the pre-open thread is finished:
+	TRACE_DEBUG(<< "defer until pre-opened");
+	defer_event(event);
+    }
+    else if (systemStreamStatus == SystemStreamClosed)
     {
 	TRACE_DEBUG(<< event->fileName);
 
+	stopPreOpen();
 	fileName = event->fileName;
 
-	int ret;
-
-	// Allocate an AVFormatContext
-	avFormatContext = avformat_alloc_context();
-	avFormatContext->interrupt_callback.callback = interruptCallback;
-	avFormatContext->interrupt_callback.opaque = this;
-
-	// Open a media file as input
-	ret = avformat_open_input(&avFormatContext,
-				  fileName.c_str(),
-				  0,   // don't force any format, AVInputFormat*,
-				  0);  // AVDictionary**
-	if (ret < 0)
+	OpenFileFail::Reason reason;
+	if (!usePreOpenedFile() &&
+	    !openFormatContext(fileName, avFormatContext, readAheadFile, avioContext,
+			       interruptCallback, reason))
 	{
-	    TRACE_ERROR(<< "avformat_open_input failed: " << AvErrorCode(ret));
-	    mediaPlayer->queue_event(boost::make_shared<OpenFileFail>(OpenFileFail::OpenFileFailed));
-	    return;
-	}
-
-	// Read packets of a media file to get stream information
-	ret = avformat_find_stream_info(avFormatContext, NULL);
-	if (ret < 0)
-	{
-	    TRACE_ERROR(<< "avformat_find_stream_info failed: " << AvErrorCode(ret));
-	    avformat_close_input(&avFormatContext);
-	    mediaPlayer->queue_event(boost::make_shared<OpenFileFail>(OpenFileFail::FindStreamFailed));
+	    mediaPlayer->queue_event(boost::make_shared<OpenFileFail>(reason));
 	    return;
 	}
 
@@ -172,6 +212,233 @@ void Demuxer::process(boost::shared_ptr<OpenFileReq> event)
     }
 }
 
+void Demuxer::process(boost::shared_ptr<PreOpenFileReq> event)
+{
+    if ( (preOpenedFormatContext && preOpenedFileName == event->fileName) ||
+	 (preOpenThread.joinable() && preOpeningFileName == event->fileName) )
+    {
+	return;
+    }
+    stopPreOpen();
+    closePreOpenedFile();
+
+    // Opening a network stream may block for a long time. Meanwhile no
+    // events would be processed:
+    struct stat st;
+    std::string path = event->fileName;
+    if (path.compare(0, 5, "file:") == 0)
+    {
+	path.erase(0, 5);
+    }
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+	return;
+    }
+
+    TRACE_DEBUG(<< event->fileName);
+
+    preOpeningFileName = event->fileName;
+    preOpenAborted = false;
+    preOpenThread = boost::thread(boost::bind(&Demuxer::preOpen, this,
+					      ++preOpenId, event->fileName));
+}
+
+void Demuxer::preOpen(unsigned int id, std::string name)
+{
+    // Called by the pre-open thread:
+    AVFormatContext* formatContext = 0;
+    boost::scoped_ptr<ReadAheadFile> file;
+    AVIOContext* ioContext = 0;
+
+    OpenFileFail::Reason reason;
+    if (!openFormatContext(name, formatContext, file, ioContext,
+			   preOpenInterruptCallback, reason))
+    {
+	// Already closed:
+	formatContext = 0;
+    }
+
+    queue_event(boost::make_shared<PreOpenFileResp>(id, name, formatContext,
+						    file.release(), ioContext));
+}
+
+void Demuxer::process(boost::shared_ptr<PreOpenFileResp> event)
+{
+    boost::scoped_ptr<ReadAheadFile> file(event->readAheadFile);
+    AVIOContext* ioContext = event->avioContext;
+
+    if (event->id != preOpenId || !preOpenThread.joinable())
+    {
+	// The thread was aborted and already joined by stopPreOpen:
+	TRACE_DEBUG(<< "discard " << event->fileName);
+	if (event->formatContext)
+	{
+	    avformat_close_input(&event->formatContext);
+	}
+	closeReadAheadFile(file, ioContext);
+	return;
+    }
+
+    // The thread has nothing to do anymore after queueing the response:
+    preOpenThread.join();
+    preOpeningFileName.clear();
+
+    if (event->formatContext)
+    {
+	TRACE_DEBUG(<< "pre-opened " << event->fileName);
+	preOpenedFileName = event->fileName;
+	preOpenedFormatContext = event->formatContext;
+	preOpenedReadAheadFile.swap(file);
+	preOpenedAvioContext = ioContext;
+    }
+
+    // An OpenFileReq may wait for the file:
+    queue_deferred_events();
+}
+
+void Demuxer::stopPreOpen()
+{
+    if (preOpenThread.joinable())
+    {
+	TRACE_DEBUG(<< "abort " << preOpeningFileName);
+	preOpenAborted = true;
+	preOpenThread.join();
+	preOpeningFileName.clear();
+    }
+}
+
+bool Demuxer::openFormatContext(const std::string& name,
+				AVFormatContext*& formatContext,
+				boost::scoped_ptr<ReadAheadFile>& file,
+				AVIOContext*& ioContext,
+				int (*callback)(void*),
+				OpenFileFail::Reason& reason)
+{
+    timespec_t start = timer::get_current_time();
+
+    ProbeCache::Entry cached;
+    if (ProbeCache::instance().find(name, cached))
+    {
+	if (probeFormatContext(name, formatContext, file, ioContext, callback, &cached, reason))
+	{
+	    TRACE_INFO(<< "open with probe cache: "
+		       << getSeconds(timer::get_current_time() - start) * 1000 << " ms");
+	    return true;
+	}
+	TRACE_DEBUG(<< "probe cache mismatch for " << name);
+    }
+
+    if (!probeFormatContext(name, formatContext, file, ioContext, callback, 0, reason))
+    {
+	return false;
+    }
+
+    TRACE_INFO(<< "open without probe cache: "
+	       << getSeconds(timer::get_current_time() - start) * 1000 << " ms");
+
+    ProbeCache::instance().store(name, formatContext);
+    return true;
+}
+
+bool Demuxer::probeFormatContext(const std::string& name,
+				 AVFormatContext*& formatContext,
+				 boost::scoped_ptr<ReadAheadFile>& file,
+				 AVIOContext*& ioContext,
+				 int (*callback)(void*),
+				 const ProbeCache::Entry* cached,
+				 OpenFileFail::Reason& reason)
+{
+    int ret;
+
+    // Allocate an AVFormatContext
+    formatContext = avformat_alloc_context();
+    formatContext->interrupt_callback.callback = callback;
+    formatContext->interrupt_callback.opaque = this;
+
+    AVInputFormat* inputFormat = 0;
+    if (cached)
+    {
+	// The streams are known, skip detecting the format and
+	// read less data to get the stream information:
+	inputFormat = av_find_input_format(cached->formatName.c_str());
+	formatContext->probesize = 1024 * 1024;
+	formatContext->max_analyze_duration = AV_TIME_BASE;
+    }
+
+    openReadAheadFile(name, formatContext, file, ioContext);
+
+    // Open a media file as input
+    ret = avformat_open_input(&formatContext,
+			      name.c_str(),
+			      inputFormat,  // 0: don't force any format
+			      0);           // AVDictionary**
+    if (ret < 0)
+    {
+	TRACE_ERROR(<< "avformat_open_input failed: " << AvErrorCode(ret));
+	// formatContext is already freed here:
+	formatContext = 0;
+	closeReadAheadFile(file, ioContext);
+	reason = OpenFileFail::OpenFileFailed;
+	return false;
+    }
+
+    // Read packets of a media file to get stream information
+    ret = avformat_find_stream_info(formatContext, NULL);
+    if (ret < 0 || (cached && !cached->matches(formatContext)))
+    {
+	if (ret < 0)
+	{
+	    TRACE_ERROR(<< "avformat_find_stream_info failed: " << AvErrorCode(ret));
+	}
+	avformat_close_input(&formatContext);
+	formatContext = 0;
+	closeReadAheadFile(file, ioContext);
+	reason = OpenFileFail::FindStreamFailed;
+	return false;
+    }
+
+    if (cached &&
+	formatContext->duration == int64_t(AV_NOPTS_VALUE) &&
+	cached->duration > 0)
+    {
+	formatContext->duration = cached->duration * AV_TIME_BASE;
+    }
+
+    return true;
+}
+
+bool Demuxer::usePreOpenedFile()
+{
+    if (!preOpenedFormatContext || preOpenedFileName != fileName)
+    {
+	closePreOpenedFile();
+	return false;
+    }
+
+    TRACE_DEBUG(<< "using pre-opened " << fileName);
+
+    avFormatContext = preOpenedFormatContext;
+    avFormatContext->interrupt_callback.callback = interruptCallback;
+    preOpenedFormatContext = 0;
+    preOpenedFileName.clear();
+
+    readAheadFile.swap(preOpenedReadAheadFile);
+    std::swap(avioContext, preOpenedAvioContext);
+
+    return true;
+}
+
+void Demuxer::closePreOpenedFile()
+{
+    if (preOpenedFormatContext)
+    {
+	avformat_close_input(&preOpenedFormatContext);
+	preOpenedFormatContext = 0;
+    }
+    closeReadAheadFile(preOpenedReadAheadFile, preOpenedAvioContext);
+    preOpenedFileName.clear();
+}
+
 void Demuxer::process(boost::shared_ptr<OpenAudioStreamResp>)
 {
     if (audioStreamStatus == StreamOpening)
@@ -232,7 +499,7 @@ void Demuxer::updateSystemStreamStatusOpening()
 	     videoStreamStatus == StreamClosed )
 	{
 	    // Opening audio and video stream failed.
-	    avformat_close_input(&avFormatContext);
+	    closeInput();
 	    mediaPlayer->queue_event(boost::make_shared<OpenFileFail>(OpenFileFail::OpenStreamFailed));
 	    return;
 	}
@@ -253,16 +520,31 @@ void Demuxer::updateSystemStreamStatusOpening()
 	systemStreamStatus = SystemStreamOpened;
 	// mediaPlayer->queue_event(boost::make_shared<OpenFileResp>());
 
-	boost::shared_ptr<NotificationFileInfo> nfi(new NotificationFileInfo());
-	const double INV_AV_TIME_BASE = double(1)/AV_TIME_BASE;
-	nfi->fileName = fileName;
-	nfi->duration = double(avFormatContext->duration) * INV_AV_TIME_BASE;
-	mediaPlayer->queue_event(nfi);
+	openKeyFrameIndex();
+	sendFileInfo();
 
 	mediaPlayer->queue_event(boost::make_shared<OpenFileResp>());
     }
 }
 
+void Demuxer::sendFileInfo()
+{
+    boost::shared_ptr<NotificationFileInfo> nfi(new NotificationFileInfo());
+    const double INV_AV_TIME_BASE = double(1)/AV_TIME_BASE;
+    nfi->fileName = fileName;
+    nfi->duration = double(avFormatContext->duration) * INV_AV_TIME_BASE;
+    if (keyFrameIndex && keyFrameIndex->getDuration() > 0 &&
+	!keyFrameIndex->isOutdated(fileName))
+    {
+	// The duration of MPEG PS files is estimated from the bit rate
+	// by FFmpeg. The index contains the real one, which is needed to
+	// map the seek bar position to the time. For a growing file the
+	// index ends at the size the file had when it was scanned.
+	nfi->duration = keyFrameIndex->getDuration();
+    }
+    mediaPlayer->queue_event(nfi);
+}
+
 void Demuxer::process(boost::shared_ptr<CloseFileReq> event)
 {
     if (systemStreamStatus == SystemStreamOpened)
@@ -274,18 +556,18 @@ void Demuxer::process(boost::shared_ptr<CloseFileReq> event)
 
 	if (audioStreamStatus != StreamClosed)
 	{
-	    audioDecoder->queue_event(boost::make_shared<CloseAudioStreamReq>());
+	    audioDecoder->queue_event(boost::make_shared<CloseAudioStreamReq>(event->keepOutput));
 	    audioStreamStatus = StreamClosing;
 	    audioStreamIndex = -1;
-	    queuedAudioPackets = 0;
+	    queuedAudioPackets.clear();
 	}
 
 	if (videoStreamStatus != StreamClosed)
 	{
-	    videoDecoder->queue_event(boost::make_shared<CloseVideoStreamReq>());
+	    videoDecoder->queue_event(boost::make_shared<CloseVideoStreamReq>(event->keepOutput));
 	    videoStreamStatus = StreamClosing;
 	    videoStreamIndex = -1;
-	    queuedVideoPackets = 0;
+	    queuedVideoPackets.clear();
 	}
     }
     else if (systemStreamStatus == SystemStreamClosed)
@@ -338,8 +620,7 @@ void Demuxer::updateSystemStreamStatusClosing()
 	{
 	    systemStreamStatus = SystemStreamClosed;
 
-	    avformat_close_input(&avFormatContext);
-	    avFormatContext = 0;
+	    closeInput();
 
 	    numAnnouncedStreams = 0;
 
@@ -376,6 +657,15 @@ void Demuxer::process(boost::shared_ptr<SeekAbsoluteReq> event)
     {
 	TRACE_DEBUG();
 
+	if (trickPlaySpeed != 0)
+	{
+	    // Continue trick play at the new position:
+	    trickPlayPosition = double(event->seekTarget) / AV_TIME_BASE;
+	    trickPlaySearching = false;
+	    process(boost::make_shared<FlushReq>(-1, trickPlaySpeed));
+	    return;
+	}
+
 	int streamIndex = videoStreamIndex;
 	if (streamIndex == -1) streamIndex = audioStreamIndex;
 	if (streamIndex == -1) return;
@@ -383,10 +673,37 @@ void Demuxer::process(boost::shared_ptr<SeekAbsoluteReq> event)
 	AVRational time_base = avFormatContext->streams[streamIndex]->time_base;
 	int64_t targetTimestamp = av_rescale_q(event->seekTarget, AV_TIME_BASE_Q, time_base);
 
-	int seekFlags = 0;  // AVSEEK_FLAG_BACKWARD
+	timespec_t start = timer::get_current_time();
+	KeyFrameIndex::Entry keyFrame;
+	int ret;
+
+	// Without an indexed key frame, e.g. behind the end of a growing
+	// file at the time it was indexed, FFmpeg seeks on its own:
+	bool indexed =
+	    keyFrameIndex &&
+	    streamIndex == videoStreamIndex &&
+	    keyFrameIndex->find(av_rescale_q(event->seekTarget, AV_TIME_BASE_Q,
+					     keyFrameIndex->getTimeBase()), keyFrame);
 
-	int ret = av_seek_frame(avFormatContext, streamIndex,
+	if (indexed)
+	{
+	    // Directly continue reading at the key frame:
+	    ret = av_seek_frame(avFormatContext, streamIndex,
+				keyFrame.pos, AVSEEK_FLAG_BYTE);
+	}
+	else
+	{
+	    // For an accurate seek the decoders need the key frame
+	    // before the target:
+	    int seekFlags = accurateSeek ? AVSEEK_FLAG_BACKWARD : 0;
+
+	    ret = av_seek_frame(avFormatContext, streamIndex,
 				targetTimestamp, seekFlags);
+	}
+
+	TRACE_INFO(<< "seek " << (indexed ? "with" : "without") << " key frame index: "
+		   << getSeconds(timer::get_current_time() - start) * 1000 << " ms");
+
 	if (ret >= 0)
 	{
 	    // success
@@ -394,7 +711,8 @@ void Demuxer::process(boost::shared_ptr<SeekAbsoluteReq> event)
 	    // systemStreamFailed includes EOF.
 	    systemStreamFailed = false;
 
-	    boost::shared_ptr<FlushReq> flushReq(new FlushReq());
+	    double seekTarget = accurateSeek ? double(event->seekTarget) / AV_TIME_BASE : -1;
+	    boost::shared_ptr<FlushReq> flushReq(new FlushReq(seekTarget));
 	    process(flushReq);
 	}
 	else
@@ -411,21 +729,356 @@ void Demuxer::process(boost::shared_ptr<FlushReq> event)
     audioDecoder->queue_event(event);
 }
 
-void Demuxer::process(boost::shared_ptr<ConfirmAudioPacketEvent>)
+void Demuxer::process(boost::shared_ptr<TrickPlayReq> event)
+{
+    if ( systemStreamStatus == SystemStreamOpened &&
+	 videoStreamStatus != StreamOpened &&
+	 event->speed != 0 )
+    {
+	// No key frames without video. Jump 10 seconds instead and let
+	// the GUI start again with the lowest speed on the next request:
+	TRACE_DEBUG(<< event->speed << ", no video stream");
+	boost::shared_ptr<SeekRelativeReq> req =
+	    boost::make_shared<SeekRelativeReq>(event->speed > 0 ? 10*AV_TIME_BASE : -10*AV_TIME_BASE);
+	req->displayedFramePTS = event->displayedFramePTS;
+	process(req);
+	mediaPlayer->queue_event(boost::make_shared<NotificationTrickPlayEnded>());
+	return;
+    }
+
+    if ( systemStreamStatus == SystemStreamOpened &&
+	 videoStreamStatus == StreamOpened &&
+	 event->speed != trickPlaySpeed )
+    {
+	TRACE_DEBUG(<< event->speed);
+
+	if (event->speed == 0)
+	{
+	    stopTrickPlay();
+	    return;
+	}
+
+	if (trickPlaySpeed == 0)
+	{
+	    trickPlayPosition = event->displayedFramePTS;
+	}
+	trickPlaySpeed = event->speed;
+	trickPlaySearching = false;
+	systemStreamFailed = false;
+
+	// Throw away everything queued with the previous speed:
+	process(boost::make_shared<FlushReq>(-1, trickPlaySpeed));
+    }
+}
+
+void Demuxer::process(boost::shared_ptr<EnableAccurateSeek>)
+{
+    TRACE_DEBUG();
+    accurateSeek = true;
+}
+
+void Demuxer::process(boost::shared_ptr<DisableAccurateSeek>)
+{
+    TRACE_DEBUG();
+    accurateSeek = false;
+}
+
+void Demuxer::process(boost::shared_ptr<ConfirmAudioPacketEvent> event)
 {
     if (audioStreamStatus == StreamOpened)
     {
 	TRACE_DEBUG();
-	queuedAudioPackets--;
+	queuedAudioPackets.remove(event->size, event->duration, packetBufferLimits);
     }
 }
 
-void Demuxer::process(boost::shared_ptr<ConfirmVideoPacketEvent>)
+void Demuxer::process(boost::shared_ptr<ConfirmVideoPacketEvent> event)
 {
     if (videoStreamStatus == StreamOpened)
     {
 	TRACE_DEBUG();
-	queuedVideoPackets--;
+	queuedVideoPackets.remove(event->size, event->duration, packetBufferLimits);
+    }
+}
+
+void Demuxer::process(boost::shared_ptr<SetPacketBufferLimits> event)
+{
+    TRACE_DEBUG(<< event->limits.lowSeconds << "s-" << event->limits.highSeconds << "s, "
+		<< event->limits.lowBytes << "-" << event->limits.highBytes << " bytes");
+    packetBufferLimits = event->limits;
+    queuedAudioPackets.update(packetBufferLimits);
+    queuedVideoPackets.update(packetBufferLimits);
+}
+
+bool Demuxer::needPackets()
+{
+    bool audio = (audioStreamStatus == StreamOpened);
+    bool video = (videoStreamStatus == StreamOpened);
+
+    // Memory ceiling. Reading more packets would exceed it, even if
+    // the other stream needs more packets:
+    if ( (audio && queuedAudioPackets.full(packetBufferLimits)) ||
+	 (video && queuedVideoPackets.full(packetBufferLimits)) )
+    {
+	return false;
+    }
+
+    return (audio && queuedAudioPackets.filling) ||
+	(video && queuedVideoPackets.filling);
+}
+
+// Upper limit for the number of key frames decoded per second. The
+// distance between the key frames grows with the speed instead:
+static const double maxTrickPlayFrameRate = 8;
+
+void Demuxer::seekTrickPlayFrame()
+{
+    double target = trickPlayPosition + trickPlaySpeed / maxTrickPlayFrameRate;
+
+    double startTime = 0;
+    if (avFormatContext->start_time != int64_t(AV_NOPTS_VALUE))
+    {
+	startTime = double(avFormatContext->start_time) / AV_TIME_BASE;
+    }
+    if (target < startTime)
+    {
+	// Rewound to the beginning:
+	trickPlayPosition = startTime;
+	endTrickPlay();
+	return;
+    }
+
+    AVStream* avStream = avFormatContext->streams[videoStreamIndex];
+    int64_t targetTimestamp = av_rescale_q(int64_t(target * AV_TIME_BASE), AV_TIME_BASE_Q,
+					   avStream->time_base);
+    KeyFrameIndex::Entry keyFrame;
+    bool indexed = false;
+    int ret;
+
+    if (keyFrameIndex)
+    {
+	int64_t indexTimestamp = av_rescale_q(int64_t(target * AV_TIME_BASE), AV_TIME_BASE_Q,
+					      keyFrameIndex->getTimeBase());
+	indexed = (trickPlaySpeed > 0)
+	    ? keyFrameIndex->findAfter(indexTimestamp, keyFrame)
+	    : keyFrameIndex->find(indexTimestamp, keyFrame);
+    }
+
+    if (indexed)
+    {
+	ret = av_seek_frame(avFormatContext, videoStreamIndex, keyFrame.pos, AVSEEK_FLAG_BYTE);
+    }
+    else
+    {
+	// Next key frame in playing direction:
+	int seekFlags = (trickPlaySpeed > 0) ? 0 : AVSEEK_FLAG_BACKWARD;
+	ret = av_seek_frame(avFormatContext, videoStreamIndex, targetTimestamp, seekFlags);
+    }
+
+    if (ret < 0)
+    {
+	// E.g. behind the last key frame:
+	TRACE_DEBUG(<< "av_seek_frame failed: " << AvErrorCode(ret));
+	endTrickPlay();
+	return;
+    }
+
+    trickPlayTarget = target;
+    trickPlaySearching = true;
+}
+
+void Demuxer::readTrickPlayFrame(AVPacket* avPacket)
+{
+    int ret = av_read_frame(avFormatContext, avPacket);
+    if (ret < 0)
+    {
+	TRACE_DEBUG(<< "av_read_frame failed: " << AvErrorCode(ret));
+	endTrickPlay();
+	return;
+    }
+
+    if ( avPacket->stream_index != videoStreamIndex ||
+	 !(avPacket->flags & AV_PKT_FLAG_KEY) )
+    {
+	// Audio is muted and only key frames are shown:
+	av_free_packet(avPacket);
+	return;
+    }
+
+    trickPlaySearching = false;
+
+    AVStream* avStream = avFormatContext->streams[videoStreamIndex];
+    int64_t timestamp = avPacket->pts != int64_t(AV_NOPTS_VALUE) ? avPacket->pts : avPacket->dts;
+    double position = (timestamp != int64_t(AV_NOPTS_VALUE))
+	? timestamp * av_q2d(avStream->time_base)
+	: trickPlayTarget;
+
+    if ( (trickPlaySpeed > 0 && position <= trickPlayPosition) ||
+	 (trickPlaySpeed < 0 && position >= trickPlayPosition) )
+    {
+	// Seek ended at the same key frame again. Next seek goes further:
+	trickPlayPosition = trickPlayTarget;
+	av_free_packet(avPacket);
+	return;
+    }
+
+    trickPlayPosition = position;
+
+    double duration = getPacketDuration(avPacket);
+    queuedVideoPackets.add(avPacket->size, duration, packetBufferLimits);
+    videoDecoder->queue_event(make_pooled_event<VideoPacketEvent>(avPacket, duration));
+}
+
+void Demuxer::stopTrickPlay()
+{
+    TRACE_DEBUG(<< "position=" << trickPlayPosition);
+
+    trickPlaySpeed = 0;
+    trickPlaySearching = false;
+
+    // Continue normal playback at the last shown key frame:
+    process(boost::make_shared<SeekAbsoluteReq>(int64_t(trickPlayPosition * AV_TIME_BASE)));
+}
+
+void Demuxer::endTrickPlay()
+{
+    // Not requested by the GUI, which still shows the old speed:
+    stopTrickPlay();
+    mediaPlayer->queue_event(boost::make_shared<NotificationTrickPlayEnded>());
+}
+
+double Demuxer::getPacketDuration(AVPacket* avPacket)
+{
+    AVStream* avStream = avFormatContext->streams[avPacket->stream_index];
+
+    if (avPacket->duration > 0)
+    {
+	return avPacket->duration * av_q2d(avStream->time_base);
+    }
+
+    // Video packets often have no duration, e.g. in MPEG TS:
+    if (avPacket->stream_index == videoStreamIndex &&
+	avStream->r_frame_rate.num > 0 &&
+	avStream->r_frame_rate.den > 0)
+    {
+	return av_q2d(av_inv_q(avStream->r_frame_rate));
+    }
+
+    return 0;
+}
+
+void Demuxer::process(boost::shared_ptr<SetReadAheadSize> event)
+{
+    TRACE_DEBUG(<< event->size);
+    // Used when the next file is opened:
+    readAheadSize = event->size;
+}
+
+void Demuxer::process(boost::shared_ptr<ReadAheadDataAvailable>)
+{
+    // Nothing to do here. The event just wakes up the main loop.
+}
+
+void Demuxer::notifyDataAvailable()
+{
+    // Called by the read-ahead thread:
+    queue_event(boost::make_shared<ReadAheadDataAvailable>());
+}
+
+void Demuxer::openReadAheadFile(const std::string& name, AVFormatContext* formatContext,
+				boost::scoped_ptr<ReadAheadFile>& file, AVIOContext*& ioContext)
+{
+    if (readAheadSize == 0)
+    {
+	return;
+    }
+
+    file.reset(new ReadAheadFile(readAheadSize,
+				 boost::bind(&Demuxer::notifyDataAvailable, this)));
+    if (!file->open(name))
+    {
+	// Not a local file, use the FFmpeg protocols:
+	file.reset();
+	return;
+    }
+
+    const int ioBufferSize = 32768;
+    unsigned char* ioBuffer = (unsigned char*)av_malloc(ioBufferSize);
+    ioContext = avio_alloc_context(ioBuffer, ioBufferSize,
+				   0,   // read only
+				   file.get(),
+				   readPacket,
+				   0,   // no write_packet
+				   seekPacket);
+    formatContext->pb = ioContext;
+}
+
+void Demuxer::closeReadAheadFile(boost::scoped_ptr<ReadAheadFile>& file, AVIOContext*& ioContext)
+{
+    if (ioContext)
+    {
+	// FFmpeg may have replaced the buffer:
+	av_free(ioContext->buffer);
+	av_free(ioContext);
+	ioContext = 0;
+    }
+    file.reset();
+}
+
+void Demuxer::closeInput()
+{
+    trickPlaySpeed = 0;
+    trickPlaySearching = false;
+    keyFrameIndexScanner.reset();
+    keyFrameIndex.reset();
+    avformat_close_input(&avFormatContext);
+    avFormatContext = 0;
+    closeReadAheadFile(readAheadFile, avioContext);
+}
+
+void Demuxer::openKeyFrameIndex()
+{
+    // Only formats seeked by a bisection over the timestamps in the
+    // file need an index, e.g. MPEG PS and TS:
+    int64_t fileSize, modificationTime;
+    if ( videoStreamIndex < 0 ||
+	 !avFormatContext->iformat->read_timestamp ||
+	 !KeyFrameIndex::getFileStatus(fileName, fileSize, modificationTime) )
+    {
+	return;
+    }
+
+    AVStream* avStream = avFormatContext->streams[videoStreamIndex];
+    boost::shared_ptr<KeyFrameIndex> index =
+	boost::make_shared<KeyFrameIndex>(avStream->id, avStream->time_base);
+    if (index->load(fileName))
+    {
+	TRACE_DEBUG(<< "loaded index with " << index->size() << " key frames");
+	keyFrameIndex = index;
+	return;
+    }
+
+    keyFrameIndexScanner.reset(new KeyFrameIndexScanner(fileName, avStream->id,
+							boost::bind(&Demuxer::notifyKeyFrameIndexReady,
+								    this, fileName, _1)));
+}
+
+void Demuxer::notifyKeyFrameIndexReady(std::string indexedFileName,
+				       boost::shared_ptr<KeyFrameIndex> index)
+{
+    // Called by the scan thread:
+    queue_event(boost::make_shared<KeyFrameIndexReady>(indexedFileName, index));
+}
+
+void Demuxer::process(boost::shared_ptr<KeyFrameIndexReady> event)
+{
+    if (systemStreamStatus == SystemStreamOpened &&
+	event->fileName == fileName &&
+	!keyFrameIndex)
+    {
+	TRACE_DEBUG(<< "index with " << event->index->size() << " key frames");
+	keyFrameIndex = event->index;
+	sendFileInfo();
     }
 }
 
@@ -439,11 +1092,28 @@ void Demuxer::operator()()
 	TRACE_DEBUG();
 
 	if ( systemStreamStatus == SystemStreamOpened &&
-	     !systemStreamFailed &&
-	     ( ( audioStreamStatus == StreamOpened &&
-		 queuedAudioPackets < targetQueuedAudioPackets ) ||
-	       ( videoStreamStatus == StreamOpened &&
-		 queuedVideoPackets < targetQueuedVideoPackets ) ) )
+	     trickPlaySpeed != 0 &&
+	     ( trickPlaySearching || queuedVideoPackets.bytes == 0 ) &&
+	     ( !readAheadFile || readAheadFile->readable() ) )
+	{
+	    // Only one key frame is queued at a time. Thus the decoder
+	    // load is limited by the frame rate of the VideoOutput:
+	    if (trickPlaySearching)
+	    {
+		readTrickPlayFrame(avPacket);
+	    }
+	    else
+	    {
+		seekTrickPlayFrame();
+	    }
+
+	    m_event_processor->dequeue_and_process_until_empty();
+	}
+	else if ( systemStreamStatus == SystemStreamOpened &&
+		  trickPlaySpeed == 0 &&
+		  !systemStreamFailed &&
+		  needPackets() &&
+		  ( !readAheadFile || readAheadFile->readable() ) )
 	{
 	    int ret = av_read_frame(avFormatContext, avPacket);
 	    if (ret == 0)
@@ -452,14 +1122,16 @@ void Demuxer::operator()()
 		if (avPacket->stream_index == videoStreamIndex)
 		{
 		    TRACE_DEBUG(<< "sending VideoPacketEvent");
-		    queuedVideoPackets++;
-		    videoDecoder->queue_event(boost::make_shared<VideoPacketEvent>(avPacket));
+		    double duration = getPacketDuration(avPacket);
+		    queuedVideoPackets.add(avPacket->size, duration, packetBufferLimits);
+		    videoDecoder->queue_event(make_pooled_event<VideoPacketEvent>(avPacket, duration));
 		}
 		else if (avPacket->stream_index == audioStreamIndex)
 		{
 		    TRACE_DEBUG(<< "sending AudioPacketEvent");
-		    queuedAudioPackets++;
-		    audioDecoder->queue_event(boost::make_shared<AudioPacketEvent>(avPacket));
+		    double duration = getPacketDuration(avPacket);
+		    queuedAudioPackets.add(avPacket->size, duration, packetBufferLimits);
+		    audioDecoder->queue_event(make_pooled_event<AudioPacketEvent>(avPacket, duration));
 		}
 		else
 		{
@@ -485,10 +1157,7 @@ void Demuxer::operator()()
 		checkForNewStreams();
 	    }
 
-	    while (!m_event_processor->empty())
-	    {
-		m_event_processor->dequeue_and_process();
-	    }
+	    m_event_processor->dequeue_and_process_until_empty();
 	}
 	else
 	{
@@ -23,9 +23,15 @@
 #define DEMUXER_HPP
 
 #include "player/GeneralEvents.hpp"
+#include "player/KeyFrameIndex.hpp"
+#include "player/ProbeCache.hpp"
+#include "player/ReadAheadFile.hpp"
 #include "platform/event_receiver.hpp"
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
 
 class Demuxer : public event_receiver<Demuxer>
 {
@@ -36,6 +42,44 @@ class Demuxer : public event_receiver<Demuxer>
 
     AVFormatContext* avFormatContext;
 
+    // Local files are read through a custom AVIOContext from a
+    // read-ahead buffer. 0 disables the read-ahead:
+    size_t readAheadSize;
+    boost::scoped_ptr<ReadAheadFile> readAheadFile;
+    AVIOContext* avioContext;
+
+    // Used for seeking in formats without an own index. Built by
+    // keyFrameIndexScanner if no valid sidecar file exists:
+    boost::shared_ptr<KeyFrameIndex> keyFrameIndex;
+    boost::scoped_ptr<KeyFrameIndexScanner> keyFrameIndexScanner;
+
+    // Seek to the key frame before the target and let the decoders
+    // skip the frames up to the target:
+    bool accurateSeek;
+
+    // Trick play: Seek from key frame to key frame. The next one is
+    // read when the decoder confirmed the previous one:
+    int trickPlaySpeed;         // 0: normal playback, see TrickPlayReq
+    double trickPlayPosition;   // seconds, last key frame sent
+    double trickPlayTarget;     // seconds, position of the last seek
+    bool trickPlaySearching;    // seeked, waiting for the key frame
+
+    // Next file opened by PreOpenFileReq. avformat_find_stream_info
+    // is already done for it:
+    std::string preOpenedFileName;
+    AVFormatContext* preOpenedFormatContext;
+    boost::scoped_ptr<ReadAheadFile> preOpenedReadAheadFile;
+    AVIOContext* preOpenedAvioContext;
+
+    // The probe runs in preOpenThread, meanwhile the Demuxer thread
+    // still processes seeks and the close request of the current file.
+    // The result is handed over with PreOpenFileResp. Responses of an
+    // aborted thread have an outdated id:
+    std::string preOpeningFileName;
+    unsigned int preOpenId;
+    std::atomic<bool> preOpenAborted;
+    boost::thread preOpenThread;
+
     enum SystemStreamStatus {
 	SystemStreamClosed,
 	SystemStreamOpening,
@@ -58,10 +102,62 @@ class Demuxer : public event_receiver<Demuxer>
     StreamStatus audioStreamStatus;
     StreamStatus videoStreamStatus;
 
-    int queuedAudioPackets;
-    int queuedVideoPackets;
-    int targetQueuedAudioPackets;
-    int targetQueuedVideoPackets;
+    // Packets sent to a decoder and not yet confirmed:
+    struct QueuedPackets
+    {
+	QueuedPackets()
+	    : bytes(0),
+	      seconds(0),
+	      filling(true)
+	{}
+
+	void clear()
+	{
+	    bytes = 0;
+	    seconds = 0;
+	    filling = true;
+	}
+
+	void add(int size, double duration, const PacketBufferLimits& limits)
+	{
+	    bytes += size;
+	    seconds += duration;
+	    update(limits);
+	}
+
+	void remove(int size, double duration, const PacketBufferLimits& limits)
+	{
+	    bytes -= size;
+	    seconds -= duration;
+	    update(limits);
+	}
+
+	// Hysteresis between the low and high watermarks:
+	void update(const PacketBufferLimits& limits)
+	{
+	    if (bytes >= int64_t(limits.highBytes) || seconds >= limits.highSeconds)
+	    {
+		filling = false;
+	    }
+	    else if (bytes < int64_t(limits.lowBytes) && seconds < limits.lowSeconds)
+	    {
+		filling = true;
+	    }
+	}
+
+	bool full(const PacketBufferLimits& limits) const
+	{
+	    return bytes >= int64_t(limits.highBytes);
+	}
+
+	int64_t bytes;
+	double seconds;
+	bool filling;
+    };
+
+    PacketBufferLimits packetBufferLimits;
+    QueuedPackets queuedAudioPackets;
+    QueuedPackets queuedVideoPackets;
 
     std::string fileName;
 
@@ -80,11 +176,16 @@ private:
     boost::shared_ptr<VideoDecoder> videoDecoder;
 
     static int interruptCallback(void*);
+    static int preOpenInterruptCallback(void*);
+    static int readPacket(void* opaque, uint8_t* buf, int size);
+    static int64_t seekPacket(void* opaque, int64_t offset, int whence);
 
     void process(boost::shared_ptr<InitEvent> event);
     void process(boost::shared_ptr<StopEvent> event);
 
     void process(boost::shared_ptr<OpenFileReq> event);
+    void process(boost::shared_ptr<PreOpenFileReq> event);
+    void process(boost::shared_ptr<PreOpenFileResp> event);
     void process(boost::shared_ptr<OpenAudioStreamResp> event);
     void process(boost::shared_ptr<OpenAudioStreamFail> event);
     void process(boost::shared_ptr<OpenVideoStreamResp> event);
@@ -97,10 +198,53 @@ private:
     void process(boost::shared_ptr<SeekRelativeReq> event);
     void process(boost::shared_ptr<SeekAbsoluteReq> event);
     void process(boost::shared_ptr<FlushReq> event);
+    void process(boost::shared_ptr<TrickPlayReq> event);
+    void process(boost::shared_ptr<EnableAccurateSeek> event);
+    void process(boost::shared_ptr<DisableAccurateSeek> event);
 
     void process(boost::shared_ptr<ConfirmAudioPacketEvent> event);
     void process(boost::shared_ptr<ConfirmVideoPacketEvent> event);
 
+    void process(boost::shared_ptr<SetPacketBufferLimits> event);
+    void process(boost::shared_ptr<SetReadAheadSize> event);
+    void process(boost::shared_ptr<ReadAheadDataAvailable> event);
+    void process(boost::shared_ptr<KeyFrameIndexReady> event);
+
+    void notifyDataAvailable();
+    void openReadAheadFile(const std::string& name, AVFormatContext* formatContext,
+			   boost::scoped_ptr<ReadAheadFile>& file, AVIOContext*& ioContext);
+    void closeReadAheadFile(boost::scoped_ptr<ReadAheadFile>& file, AVIOContext*& ioContext);
+    void closeInput();
+    bool openFormatContext(const std::string& name,
+			   AVFormatContext*& formatContext,
+			   boost::scoped_ptr<ReadAheadFile>& file,
+			   AVIOContext*& ioContext,
+			   int (*callback)(void*),
+			   OpenFileFail::Reason& reason);
+    bool probeFormatContext(const std::string& name,
+			    AVFormatContext*& formatContext,
+			    boost::scoped_ptr<ReadAheadFile>& file,
+			    AVIOContext*& ioContext,
+			    int (*callback)(void*),
+			    const ProbeCache::Entry* cached,
+			    OpenFileFail::Reason& reason);
+    void preOpen(unsigned int id, std::string name);
+    void stopPreOpen();
+    bool usePreOpenedFile();
+    void closePreOpenedFile();
+
+    void openKeyFrameIndex();
+    void notifyKeyFrameIndexReady(std::string indexedFileName,
+				  boost::shared_ptr<KeyFrameIndex> index);
+    void sendFileInfo();
+
+    bool needPackets();
+    void seekTrickPlayFrame();
+    void readTrickPlayFrame(AVPacket* avPacket);
+    void stopTrickPlay();
+    void endTrickPlay();
+    double getPacketDuration(AVPacket* avPacket);
+
     void updateSystemStreamStatusOpening();
     void updateSystemStreamStatusClosing();
     void checkForNewStreams();
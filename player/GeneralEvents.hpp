@@ -46,6 +46,8 @@
 
 
 #include "platform/Logging.hpp"
+#include "platform/event_processor.hpp"
+#include "platform/mpsc_ring_queue.hpp"
 
 #include <boost/shared_ptr.hpp>
 #include <list>
@@ -70,6 +72,13 @@ class AudioDecoder;
 class VideoOutput;
 class AudioOutput;
 class Deinterlacer;
+class KeyFrameIndex;
+class ReadAheadFile;
+
+// Queues of the decoder, audio output and GUI threads. Every packet
+// and frame passes them:
+typedef mpsc_ring_queue<receive_fct_t> player_queue_t;
+typedef mpsc_ring_queue<receive_fct_t, with_callback_function> player_gui_queue_t;
 
 // ===================================================================
 // General Events
@@ -120,9 +129,47 @@ struct OpenFileFail
     Reason reason;
 };
 
-struct CloseFileReq {};
+// keepOutput is set when the next file is opened immediately after
+// closing this one. Then the audio device is kept open and the last
+// video frame is kept on the screen:
+struct CloseFileReq
+{
+    CloseFileReq(bool keepOutput = false) : keepOutput(keepOutput) {}
+    bool keepOutput;
+};
 struct CloseFileResp {};
 
+// Sent when the Demuxer reached the end of the current file. A helper
+// thread of the Demuxer opens the file and reads the stream information,
+// while the decoders still have packets of the current file. A following
+// OpenFileReq for the same file then only has to open the decoders.
+struct PreOpenFileReq
+{
+    PreOpenFileReq(std::string fn) : fileName(fn) {}
+    std::string fileName;
+};
+
+// Sent by the pre-open thread when it is finished. The Demuxer takes
+// over the opened file, or closes it if it is no longer needed:
+struct PreOpenFileResp
+{
+    PreOpenFileResp(unsigned int id, const std::string& fileName,
+		    AVFormatContext* formatContext,
+		    ReadAheadFile* readAheadFile,
+		    AVIOContext* avioContext)
+	: id(id),
+	  fileName(fileName),
+	  formatContext(formatContext),
+	  readAheadFile(readAheadFile),
+	  avioContext(avioContext)
+    {}
+    unsigned int id;
+    std::string fileName;
+    AVFormatContext* formatContext;   // 0 if opening failed
+    ReadAheadFile* readAheadFile;
+    AVIOContext* avioContext;
+};
+
 struct OpenAudioStreamFailed {};
 struct OpenVideoStreamFailed {};
 
@@ -178,9 +225,18 @@ struct OpenVideoStreamFail
 
 // ===================================================================
 
-struct CloseAudioStreamReq {};
+struct CloseAudioStreamReq
+{
+    CloseAudioStreamReq(bool keepOutput = false) : keepOutput(keepOutput) {}
+    bool keepOutput;
+};
 struct CloseAudioStreamResp {};
-struct CloseVideoStreamReq {};
+struct CloseVideoStreamReq
+{
+    CloseVideoStreamReq(bool keepOutput = false) : keepOutput(keepOutput) {}
+    bool keepOutput;
+};
+CONTROL_LANE_EVENT(CloseVideoStreamReq)
 struct CloseVideoStreamResp {};
 
 // ===================================================================
@@ -203,7 +259,38 @@ struct SeekRelativeReq
     double displayedFramePTS;
 };
 
-struct FlushReq {};
+// Overtakes queued packets and frames. These are discarded by the
+// receivers, see event_processor::overtaken_by().
+//
+// For an accurate seek seekTarget is the requested position. The
+// decoders then drop all frames before it. They are decoded as fast
+// as possible, but neither converted nor passed to the outputs.
+//
+// trickPlaySpeed is the speed of the following packets, see
+// TrickPlayReq.
+struct FlushReq
+{
+    FlushReq(double seekTarget = -1, int trickPlaySpeed = 0)
+	: seekTarget(seekTarget),
+	  trickPlaySpeed(trickPlaySpeed)
+    {}
+    double seekTarget;  // seconds, negative if not used
+    int trickPlaySpeed;
+};
+CONTROL_LANE_EVENT(FlushReq)
+
+// Fast forward (speed > 1) and rewind (speed < -1). The Demuxer only
+// sends key frames and no audio. 0 continues normal playback at the
+// last shown key frame.
+struct TrickPlayReq
+{
+    TrickPlayReq(int speed)
+	: speed(speed),
+	  displayedFramePTS(0)
+    {}
+    int speed;
+    double displayedFramePTS;
+};
 
 struct AudioFlushedInd {};
 
@@ -211,38 +298,126 @@ struct AudioFlushedInd {};
 
 struct AudioPacketEvent
 {
-    AudioPacketEvent(AVPacket* avp)
-	: avPacket(*avp)
+    // Takes over the payload of avp, which is reset. The payload is only
+    // copied if it is still owned by libavformat, e.g. a parser buffer.
+    // Use make_pooled_event to create this event.
+    AudioPacketEvent(AVPacket* avp, double duration)
+	: avPacket(*avp),
+	  duration(duration)
     {
 	av_dup_packet(&avPacket);
+	av_init_packet(avp);
+	avp->data = 0;
+	avp->size = 0;
     }
     ~AudioPacketEvent()
     {
 	av_free_packet(&avPacket);
     }
     AVPacket avPacket;
+    double duration;  // seconds, 0 if unknown
 };
 
 struct VideoPacketEvent
 {
-    VideoPacketEvent(AVPacket* avp)
-	: avPacket(*avp)
+    // Takes over the payload of avp, which is reset. The payload is only
+    // copied if it is still owned by libavformat, e.g. a parser buffer.
+    // Use make_pooled_event to create this event.
+    VideoPacketEvent(AVPacket* avp, double duration)
+	: avPacket(*avp),
+	  duration(duration)
     {
 	av_dup_packet(&avPacket);
+	av_init_packet(avp);
+	avp->data = 0;
+	avp->size = 0;
     }
     ~VideoPacketEvent()
     {
 	av_free_packet(&avPacket);
     }
     AVPacket avPacket;
+    double duration;  // seconds, 0 if unknown
 };
 
+// Returns size and duration of the packet to the Demuxer, which limits
+// the data queued for each stream:
 struct ConfirmAudioPacketEvent
 {
+    ConfirmAudioPacketEvent(const AudioPacketEvent& packet)
+	: size(packet.avPacket.size),
+	  duration(packet.duration)
+    {}
+    int size;
+    double duration;
 };
 
 struct ConfirmVideoPacketEvent
 {
+    ConfirmVideoPacketEvent(const VideoPacketEvent& packet)
+	: size(packet.avPacket.size),
+	  duration(packet.duration)
+    {}
+    int size;
+    double duration;
+};
+
+// The Demuxer stops reading when a stream reaches highSeconds or
+// highBytes of queued packets and resumes when the stream drops below
+// both lowSeconds and lowBytes. highBytes is also a hard limit: No
+// packets are read while any stream is at highBytes.
+struct PacketBufferLimits
+{
+    PacketBufferLimits()
+	: lowSeconds(1),
+	  highSeconds(3),
+	  lowBytes(4 * 1024 * 1024),
+	  highBytes(16 * 1024 * 1024)
+    {}
+    double lowSeconds;
+    double highSeconds;
+    size_t lowBytes;
+    size_t highBytes;
+};
+
+struct SetPacketBufferLimits
+{
+    SetPacketBufferLimits(const PacketBufferLimits& limits)
+	: limits(limits)
+    {}
+    PacketBufferLimits limits;
+};
+
+struct SetReadAheadSize
+{
+    SetReadAheadSize(size_t size)
+	: size(size)
+    {}
+    size_t size;  // bytes, 0 disables read-ahead
+};
+
+struct SetDecoderThreading
+{
+    SetDecoderThreading(int threads, const std::string& threadTypes)
+	: threads(threads),
+	  threadTypes(threadTypes)
+    {}
+    int threads;              // 0 uses one thread per core
+    std::string threadTypes;  // e.g. "default=frame+slice,h264=slice"
+};
+
+// Sent by the read-ahead thread to wake up the Demuxer:
+struct ReadAheadDataAvailable {};
+
+// Sent by the key frame index scan thread when the index is complete:
+struct KeyFrameIndexReady
+{
+    KeyFrameIndexReady(const std::string& fileName, boost::shared_ptr<KeyFrameIndex> index)
+	: fileName(fileName),
+	  index(index)
+    {}
+    std::string fileName;
+    boost::shared_ptr<KeyFrameIndex> index;
 };
 
 // ===================================================================
@@ -267,53 +442,80 @@ struct OpenAudioOutputReq
 struct OpenAudioOutputResp{};
 struct OpenAudioOutputFail{};
 
-struct CloseAudioOutputReq{};
+struct CloseAudioOutputReq
+{
+    CloseAudioOutputReq(bool keepOutput = false) : keepOutput(keepOutput) {}
+    bool keepOutput;
+};
 struct CloseAudioOutputResp{};
 
+// Closes the audio device kept by CloseAudioOutputReq::keepOutput, e.g.
+// when the next file has no audio stream or cannot be opened:
+struct ReleaseAudioOutputReq{};
+
 // ===================================================================
 
 struct OpenVideoOutputReq
 {
     OpenVideoOutputReq(int width, int height,
 		       int parNum, int parDen,
-		       int fourccFormat)
+		       int fourccFormat,
+		       int imageWidth = 0, int imageHeight = 0)
 	: width(width),
 	  height(height),
 	  parNum(parNum),
 	  parDen(parDen),
-	  fourccFormat(fourccFormat)
+	  fourccFormat(fourccFormat),
+	  imageWidth(imageWidth),
+	  imageHeight(imageHeight)
     {}
     int width;
     int height;
     int parNum;  // pixel aspect ratio numerator
     int parDen;  // pixel aspect ratio denominator
     int fourccFormat;
+    // Size of the created images, if bigger than the video size:
+    int imageWidth;
+    int imageHeight;
 };
 
 struct OpenVideoOutputResp{};
 struct OpenVideoOutputFail{};
 
-struct CloseVideoOutputReq{};
+struct CloseVideoOutputReq
+{
+    CloseVideoOutputReq(bool keepOutput = false) : keepOutput(keepOutput) {}
+    bool keepOutput;
+};
 struct CloseVideoOutputResp{};
 
 struct ResizeVideoOutputReq
 {
     ResizeVideoOutputReq(int width, int height,
 			 int parNum, int parDen,
-			 int fourccFormat)
+			 int fourccFormat,
+			 int imageWidth = 0, int imageHeight = 0)
 	: width(width),
 	  height(height),
 	  parNum(parNum),
 	  parDen(parDen),
-	  fourccFormat(fourccFormat)
+	  fourccFormat(fourccFormat),
+	  imageWidth(imageWidth),
+	  imageHeight(imageHeight)
     {}
     int width;
     int height;
     int parNum;  // pixel aspect ratio numerator
     int parDen;  // pixel aspect ratio denominator
     int fourccFormat;
+    // Size of the created image, if bigger than the video size:
+    int imageWidth;
+    int imageHeight;
 };
 
+// Requests one more XFVideoImage with the current size and format:
+struct CreateVideoImageReq {};
+
 // ===================================================================
 
 struct AudioSyncInfo
@@ -333,6 +535,20 @@ struct NoVideoStream {};
 // ===================================================================
 
 class XFVideoImage;
+class AudioFrame;
+
+// Presentation timestamps shown in the event trace, see platform/event_trace.hpp:
+template<>
+struct event_trace_pts<XFVideoImage>
+{
+    static bool get(const XFVideoImage& image, double& pts);
+};
+
+template<>
+struct event_trace_pts<AudioFrame>
+{
+    static bool get(const AudioFrame& frame, double& pts);
+};
 
 struct DeleteXFVideoImage
 {
@@ -342,6 +558,35 @@ struct DeleteXFVideoImage
     std::unique_ptr<XFVideoImage> image;
 };
 
+// Sent to the VideoDecoder when FFmpeg released the last reference to
+// an XFVideoImage used for direct rendering. May be sent by any thread:
+struct DirectRenderingBufferReleased
+{
+    DirectRenderingBufferReleased(char* data) : data(data) {}
+    char* data;  // XFVideoImage::data()
+};
+
+// Sent by a BandScaler thread to the VideoDecoder:
+struct VideoFrameConverted
+{
+    VideoFrameConverted(int conversionId) : conversionId(conversionId) {}
+    int conversionId;
+};
+
+// Sent by the VideoOutput to the VideoDecoder for each frame shown in
+// sync with the audio clock:
+struct VideoLateness
+{
+    VideoLateness(double pts, double lateness, struct timespec abstime)
+	: pts(pts),
+	  lateness(lateness),
+	  abstime(abstime)
+    {}
+    double pts;               // of the shown frame
+    double lateness;          // audio clock minus pts, positive if late
+    struct timespec abstime;  // when the frame was shown
+};
+
 // ===================================================================
 
 struct EndOfSystemStream {};
@@ -352,6 +597,8 @@ struct EndOfVideoStream {};
 
 struct CommandPlay{};
 struct CommandPause{};
+CONTROL_LANE_EVENT(CommandPlay)
+CONTROL_LANE_EVENT(CommandPause)
 
 struct CommandRewind{};
 struct CommandForward{};
@@ -620,6 +867,9 @@ struct DisableOptimalPixelFormat {};
 struct EnableXvClipping {};
 struct DisableXvClipping {};
 
+struct EnableAccurateSeek {};
+struct DisableAccurateSeek {};
+
 struct SelectDeinterlacer
 {
     SelectDeinterlacer(const std::string& name)
@@ -655,6 +905,10 @@ struct NotificationNewStream
     std::string info;
 };
 
+// The Demuxer stopped trick play without a TrickPlayReq, e.g. when
+// rewinding reached the beginning of the file.
+struct NotificationTrickPlayEnded {};
+
 // ===================================================================
 
 #ifdef SYNCTEST
@@ -0,0 +1,324 @@
+//
+// Key Frame Index
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "player/KeyFrameIndex.hpp"
+#include "platform/Logging.hpp"
+#include "platform/timer.hpp"
+#include "platform/wire_format.hpp"
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// Sidecar file layout, see itf::binary_oarchive:
+//   uint32_t  magic
+//   uint32_t  version
+//   int64_t   size of the media file
+//   int64_t   modification time of the media file
+//   int32_t   AVStream::id of the indexed stream
+//   int32_t   time base numerator
+//   int32_t   time base denominator
+//   uint32_t  number of entries, followed by the entries (pts, pos)
+static const uint32_t sidecarMagic = 0x4946534b;  // "KSFI"
+static const uint32_t sidecarVersion = 1;
+
+KeyFrameIndex::KeyFrameIndex(int streamId, AVRational timeBase)
+    : streamId(streamId),
+      timeBase(timeBase),
+      fileSize(-1),
+      modificationTime(-1)
+{
+}
+
+void KeyFrameIndex::add(int64_t pts, int64_t pos)
+{
+    if (entries.empty() || pts > entries.back().pts)
+    {
+	entries.push_back(Entry(pts, pos));
+    }
+}
+
+static bool lessPts(int64_t pts, const KeyFrameIndex::Entry& entry)
+{
+    return pts < entry.pts;
+}
+
+bool KeyFrameIndex::find(int64_t pts, Entry& entry) const
+{
+    if (entries.empty() || pts > entries.back().pts)
+    {
+	return false;
+    }
+
+    std::vector<Entry>::const_iterator it =
+	std::upper_bound(entries.begin(), entries.end(), pts, lessPts);
+    if (it != entries.begin())
+    {
+	--it;
+    }
+    entry = *it;
+    return true;
+}
+
+static bool lessEntry(const KeyFrameIndex::Entry& entry, int64_t pts)
+{
+    return entry.pts < pts;
+}
+
+bool KeyFrameIndex::findAfter(int64_t pts, Entry& entry) const
+{
+    std::vector<Entry>::const_iterator it =
+	std::lower_bound(entries.begin(), entries.end(), pts, lessEntry);
+    if (it == entries.end())
+    {
+	return false;
+    }
+    entry = *it;
+    return true;
+}
+
+double KeyFrameIndex::getDuration() const
+{
+    if (entries.empty())
+    {
+	return 0;
+    }
+    return (entries.back().pts - entries.front().pts) * av_q2d(timeBase);
+}
+
+void KeyFrameIndex::setFileStatus(int64_t size, int64_t time)
+{
+    fileSize = size;
+    modificationTime = time;
+}
+
+bool KeyFrameIndex::isOutdated(const std::string& mediaFileName) const
+{
+    int64_t size, time;
+    return ( !getFileStatus(mediaFileName, size, time) ||
+	     size != fileSize ||
+	     time != modificationTime );
+}
+
+std::string KeyFrameIndex::getSidecarFileName(const std::string& mediaFileName)
+{
+    std::string path = mediaFileName;
+    if (path.compare(0, 5, "file:") == 0)
+    {
+	path.erase(0, 5);
+    }
+    return path + ".keyframes";
+}
+
+bool KeyFrameIndex::getFileStatus(const std::string& mediaFileName,
+				  int64_t& fileSize, int64_t& modificationTime)
+{
+    std::string path = mediaFileName;
+    if (path.compare(0, 5, "file:") == 0)
+    {
+	path.erase(0, 5);
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+	return false;
+    }
+
+    fileSize = st.st_size;
+    modificationTime = st.st_mtime;
+    return true;
+}
+
+bool KeyFrameIndex::load(const std::string& mediaFileName)
+{
+    int64_t fileSize, modificationTime;
+    if (!getFileStatus(mediaFileName, fileSize, modificationTime))
+    {
+	return false;
+    }
+
+    std::ifstream file(getSidecarFileName(mediaFileName).c_str(), std::ios::binary);
+    if (!file.is_open())
+    {
+	return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+			     std::istreambuf_iterator<char>());
+    if (buffer.empty())
+    {
+	return false;
+    }
+
+    uint32_t magic, version;
+    int64_t indexedFileSize, indexedModificationTime;
+    int32_t indexedStreamId, num, den;
+    std::vector<Entry> indexedEntries;
+
+    itf::binary_iarchive archive(&buffer[0], &buffer[0] + buffer.size());
+    archive >> magic >> version;
+    if (magic != sidecarMagic || version != sidecarVersion)
+    {
+	return false;
+    }
+    archive >> indexedFileSize >> indexedModificationTime
+	    >> indexedStreamId >> num >> den
+	    >> indexedEntries;
+
+    if ( !archive.complete() ||
+	 indexedFileSize != fileSize ||
+	 indexedModificationTime != modificationTime ||
+	 indexedStreamId != streamId ||
+	 num != timeBase.num ||
+	 den != timeBase.den )
+    {
+	TRACE_DEBUG(<< "outdated " << getSidecarFileName(mediaFileName));
+	return false;
+    }
+
+    entries.swap(indexedEntries);
+    setFileStatus(fileSize, modificationTime);
+    return true;
+}
+
+// Writes the file status given by setFileStatus, i.e. the one before
+// the file was scanned. A file that grew during the scan does not get a
+// valid sidecar file.
+bool KeyFrameIndex::save(const std::string& mediaFileName) const
+{
+    if (fileSize < 0)
+    {
+	return false;
+    }
+
+    std::vector<char> buffer;
+    itf::binary_oarchive archive(buffer);
+    archive << sidecarMagic << sidecarVersion
+	    << fileSize << modificationTime
+	    << int32_t(streamId) << int32_t(timeBase.num) << int32_t(timeBase.den)
+	    << entries;
+
+    std::string sidecarFileName = getSidecarFileName(mediaFileName);
+    std::ofstream file(sidecarFileName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+	// E.g. no write permission for the directory. The index is
+	// still used until the file is closed.
+	TRACE_DEBUG(<< "cannot write " << sidecarFileName);
+	return false;
+    }
+    file.write(&buffer[0], buffer.size());
+    return file.good();
+}
+
+// -------------------------------------------------------------------
+
+KeyFrameIndexScanner::KeyFrameIndexScanner(const std::string& fileName, int streamId,
+					   callback_type callback)
+    : fileName(fileName),
+      streamId(streamId),
+      callback(callback),
+      aborted(false)
+{
+    thread = boost::thread(boost::bind(&KeyFrameIndexScanner::operator(), this));
+}
+
+KeyFrameIndexScanner::~KeyFrameIndexScanner()
+{
+    aborted = true;
+    thread.join();
+}
+
+int KeyFrameIndexScanner::interruptCallback(void* ptr)
+{
+    return ((KeyFrameIndexScanner*)ptr)->aborted;
+}
+
+void KeyFrameIndexScanner::operator()()
+{
+    // Before reading anything, see KeyFrameIndex::save:
+    int64_t fileSize, modificationTime;
+    if (!KeyFrameIndex::getFileStatus(fileName, fileSize, modificationTime))
+    {
+	return;
+    }
+
+    AVFormatContext* avFormatContext = avformat_alloc_context();
+    avFormatContext->interrupt_callback.callback = interruptCallback;
+    avFormatContext->interrupt_callback.opaque = this;
+
+    int ret = avformat_open_input(&avFormatContext, fileName.c_str(), 0, 0);
+    if (ret < 0)
+    {
+	TRACE_ERROR(<< "avformat_open_input failed: " << ret);
+	return;
+    }
+
+    // avformat_find_stream_info is not called. It would open decoders,
+    // which is not needed to get key frames from the parsers. Streams
+    // are identified by AVStream::id, because the stream indices depend
+    // on the order streams are found, e.g. for MPEG PS.
+    boost::shared_ptr<KeyFrameIndex> index;
+    timespec_t start = timer::get_current_time();
+
+    AVPacket avPacket;
+    while (!aborted && av_read_frame(avFormatContext, &avPacket) >= 0)
+    {
+	AVStream* avStream = avFormatContext->streams[avPacket.stream_index];
+	if (avStream->id != streamId)
+	{
+	    // Don't parse packets of other streams anymore:
+	    avStream->discard = AVDISCARD_ALL;
+	}
+	else if ((avPacket.flags & AV_PKT_FLAG_KEY) &&
+		 avPacket.pos >= 0)
+	{
+	    int64_t pts = avPacket.pts != int64_t(AV_NOPTS_VALUE) ? avPacket.pts : avPacket.dts;
+	    if (pts != int64_t(AV_NOPTS_VALUE))
+	    {
+		if (!index)
+		{
+		    index = boost::make_shared<KeyFrameIndex>(streamId, avStream->time_base);
+		    index->setFileStatus(fileSize, modificationTime);
+		}
+		index->add(pts, avPacket.pos);
+	    }
+	}
+	av_free_packet(&avPacket);
+    }
+
+    avformat_close_input(&avFormatContext);
+
+    if (aborted || !index)
+    {
+	return;
+    }
+
+    TRACE_INFO(<< fileName << ": " << index->size() << " key frames indexed in "
+	       << getSeconds(timer::get_current_time() - start) << " sec");
+
+    index->save(fileName);
+    callback(index);
+}
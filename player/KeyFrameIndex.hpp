@@ -0,0 +1,139 @@
+//
+// Key Frame Index
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef KEY_FRAME_INDEX_HPP
+#define KEY_FRAME_INDEX_HPP
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+// Maps the PTS of the key frames of one stream to their byte position
+// in the file. Formats without an index, e.g. MPEG PS recordings, are
+// seeked by FFmpeg with a bisection over the file, which reads a lot of
+// data and often ends at a frame that is not a key frame. Seeking to the
+// byte position of a key frame avoids both.
+//
+// The index is stored in a sidecar file next to the media file. It is
+// only used if size and modification time of the media file did not
+// change since the index was created. A file that is still growing,
+// e.g. a live TV recording, is indexed up to the end at scan time. Seeks
+// behind the last indexed key frame are left to FFmpeg.
+
+class KeyFrameIndex
+{
+public:
+    struct Entry
+    {
+	Entry() : pts(0), pos(0) {}
+	Entry(int64_t pts, int64_t pos) : pts(pts), pos(pos) {}
+
+	template<class Archive>
+	void serialize(Archive& ar, const unsigned int)
+	{
+	    ar & pts;
+	    ar & pos;
+	}
+
+	int64_t pts;  // in units of timeBase
+	int64_t pos;  // byte position in the file
+    };
+
+    KeyFrameIndex(int streamId, AVRational timeBase);
+
+    // Entries have to be added with increasing pts. Others are ignored:
+    void add(int64_t pts, int64_t pos);
+
+    // Returns the last key frame with a pts less or equal to pts, or the
+    // first key frame. Returns false if the index is empty or if pts is
+    // behind the last key frame, which may not be the last one of the
+    // file anymore:
+    bool find(int64_t pts, Entry& entry) const;
+
+    // Returns the first key frame with a pts greater or equal to pts.
+    // Returns false if there is none:
+    bool findAfter(int64_t pts, Entry& entry) const;
+
+    int getStreamId() const {return streamId;}
+    AVRational getTimeBase() const {return timeBase;}
+    size_t size() const {return entries.size();}
+
+    // Time between the first and the last key frame in seconds:
+    double getDuration() const;
+
+    // Size and modification time of the media file before it was indexed:
+    void setFileStatus(int64_t fileSize, int64_t modificationTime);
+    // Returns true if the media file changed after it was indexed:
+    bool isOutdated(const std::string& mediaFileName) const;
+
+    bool load(const std::string& mediaFileName);
+    bool save(const std::string& mediaFileName) const;
+
+    // Returns false if mediaFileName is not a regular local file:
+    static bool getFileStatus(const std::string& mediaFileName,
+			      int64_t& fileSize, int64_t& modificationTime);
+
+private:
+    static std::string getSidecarFileName(const std::string& mediaFileName);
+
+    int streamId;
+    AVRational timeBase;
+    std::vector<Entry> entries;
+    int64_t fileSize;
+    int64_t modificationTime;
+};
+
+// Reads the file once in an own thread with an own AVFormatContext and
+// collects the key frames of the stream with the given AVStream::id. The
+// complete index is saved as sidecar file and passed to the callback,
+// which is called by the scan thread. Destroying the scanner aborts the
+// scan.
+
+class KeyFrameIndexScanner : private boost::noncopyable
+{
+public:
+    typedef boost::function<void (boost::shared_ptr<KeyFrameIndex>)> callback_type;
+
+    KeyFrameIndexScanner(const std::string& fileName, int streamId, callback_type callback);
+    ~KeyFrameIndexScanner();
+
+private:
+    void operator()();
+    static int interruptCallback(void* ptr);
+
+    std::string fileName;
+    int streamId;
+    callback_type callback;
+    std::atomic<bool> aborted;
+    boost::thread thread;
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include "player/PlayList.hpp"
 
 #include <boost/make_shared.hpp>
+#include <iostream>
 
 extern "C"
 {
@@ -87,8 +88,7 @@ void logfunc(void* /* p */, int /* i */, const char* format, va_list ap)
 // ===================================================================
 
 MediaPlayer::MediaPlayer(PlayList& playList)
-    : base_type(boost::make_shared<event_processor<
-		concurrent_queue<receive_fct_t, with_callback_function> > >()),
+    : base_type(boost::make_shared<event_processor<player_gui_queue_t> >()),
       m_PlayList(playList),
       hasAudioStream(false),
       hasVideoStream(false),
@@ -100,8 +100,8 @@ MediaPlayer::MediaPlayer(PlayList& playList)
 
     // Create event_processor instances:
     demuxerEventProcessor = boost::make_shared<event_processor<> >();
-    decoderEventProcessor = boost::make_shared<event_processor<> >();
-    outputEventProcessor = boost::make_shared<event_processor<> >();
+    decoderEventProcessor = boost::make_shared<event_processor<player_queue_t> >();
+    outputEventProcessor = boost::make_shared<event_processor<player_queue_t> >();
 
     // Create event_receiver instances:
     demuxer = boost::make_shared<Demuxer>(demuxerEventProcessor);
@@ -121,6 +121,14 @@ MediaPlayer::MediaPlayer(PlayList& playList)
 
 MediaPlayer::~MediaPlayer()
 {
+    {
+	TraceUnit traceUnit;
+#ifdef EVENT_STATISTICS_ENABLED
+	dumpEventStatistics(traceUnit);
+#endif
+	videoDecoder->dumpStatistics(traceUnit);
+    }
+
     boost::shared_ptr<QuitEvent> quitEvent(new QuitEvent());
     demuxerEventProcessor->queue_event(quitEvent);
     decoderEventProcessor->queue_event(quitEvent);
@@ -184,6 +192,12 @@ void MediaPlayer::close()
     demuxer->queue_event(boost::make_shared<CloseFileReq>());
 }
 
+void MediaPlayer::closeForNextFile()
+{
+    // The audio device and the last video frame are kept:
+    demuxer->queue_event(boost::make_shared<CloseFileReq>(true));
+}
+
 void MediaPlayer::play()
 {
     boost::shared_ptr<CommandPlay> commandPlay(new CommandPlay());
@@ -202,7 +216,7 @@ void MediaPlayer::skipBack()
 {
     if (m_PlayList.selectPrevious())
     {
-	close();
+	closeForNextFile();
 	open();
     }
 }
@@ -216,7 +230,7 @@ bool MediaPlayer::skipForwardInt()
 {
     if (m_PlayList.selectNext())
     {
-	close();
+	closeForNextFile();
 	open();
 	return true;
     }
@@ -240,6 +254,14 @@ void MediaPlayer::seekRelative(double secondsDelta)
 			     (secondsDelta*AV_TIME_BASE));
 }
 
+void MediaPlayer::trickPlay(int speed)
+{
+    TRACE_DEBUG(<< speed);
+    // Send TrickPlayReq indirectly to Demuxer via VideoOutput
+    // which has to fill the current PTS:
+    videoOutput->queue_event(boost::make_shared<TrickPlayReq>(speed));
+}
+
 void MediaPlayer::setPlaybackVolume(double volume)
 {
     audioOutput->queue_event(boost::make_shared<CommandSetPlaybackVolume>(volume));
@@ -280,6 +302,16 @@ void MediaPlayer::disableXvClipping()
     videoOutput->queue_event(boost::make_shared<DisableXvClipping>());
 }
 
+void MediaPlayer::enableAccurateSeek()
+{
+    demuxer->queue_event(boost::make_shared<EnableAccurateSeek>());
+}
+
+void MediaPlayer::disableAccurateSeek()
+{
+    demuxer->queue_event(boost::make_shared<DisableAccurateSeek>());
+}
+
 void MediaPlayer::selectDeinterlacer(const std::string& name)
 {
     deinterlacer->queue_event(boost::make_shared<SelectDeinterlacer>(name));
@@ -290,6 +322,42 @@ void MediaPlayer::setVideoAttribute(const std::string& name, int value)
     videoOutput->queue_event(boost::make_shared<ChangeVideoAttribute>(name, value));
 }
 
+void MediaPlayer::setReadAheadSize(int kiloBytes)
+{
+    demuxer->queue_event(boost::make_shared<SetReadAheadSize>(size_t(kiloBytes) * 1024));
+}
+
+void MediaPlayer::setPacketBufferLimits(double lowSeconds, double highSeconds,
+					int lowKiloBytes, int highKiloBytes)
+{
+    PacketBufferLimits limits;
+    limits.lowSeconds = lowSeconds;
+    limits.highSeconds = highSeconds;
+    limits.lowBytes = size_t(lowKiloBytes) * 1024;
+    limits.highBytes = size_t(highKiloBytes) * 1024;
+    demuxer->queue_event(boost::make_shared<SetPacketBufferLimits>(limits));
+}
+
+void MediaPlayer::setDecoderThreading(int threads, const std::string& threadTypes)
+{
+    videoDecoder->queue_event(boost::make_shared<SetDecoderThreading>(threads, threadTypes));
+}
+
+void MediaPlayer::dumpEventStatistics(std::ostream& strm)
+{
+    demuxerEventProcessor->dump_statistics(strm, "demuxer");
+    decoderEventProcessor->dump_statistics(strm, "decoder");
+    outputEventProcessor->dump_statistics(strm, "output");
+    get_event_processor()->dump_statistics(strm, "gui");
+}
+
+void MediaPlayer::dumpStatistics()
+{
+    std::cout << "Statistics snapshot:" << std::endl;
+    dumpEventStatistics(std::cout);
+    videoDecoder->dumpStatistics(std::cout);
+}
+
 void MediaPlayer::process(boost::shared_ptr<OpenFileResp>)
 {
     TRACE_DEBUG();
@@ -307,6 +375,8 @@ void MediaPlayer::process(boost::shared_ptr<OpenFileFail> event)
     }
     else
     {
+	// The audio device of the previous file is not needed anymore:
+	audioOutput->queue_event(boost::make_shared<ReleaseAudioOutputReq>());
 	skipForward();
     }
 }
@@ -321,6 +391,7 @@ void MediaPlayer::process(boost::shared_ptr<NoAudioStream> event)
     TRACE_DEBUG();
     hasAudioStream = false;
     videoOutput->queue_event(event);
+    audioOutput->queue_event(boost::make_shared<ReleaseAudioOutputReq>());
 }
 
 void MediaPlayer::process(boost::shared_ptr<NoVideoStream> event)
@@ -335,6 +406,14 @@ void MediaPlayer::process(boost::shared_ptr<EndOfSystemStream>)
     TRACE_DEBUG();
     endOfAudioStream = false;
     endOfVideoStream = false;
+
+    // The decoders still have packets of the current file. Meanwhile
+    // the Demuxer already reads the stream information of the next one:
+    std::string next = m_PlayList.getNext();
+    if (!next.empty())
+    {
+	demuxer->queue_event(boost::make_shared<PreOpenFileReq>(next));
+    }
 }
 
 void MediaPlayer::process(boost::shared_ptr<EndOfAudioStream>)
@@ -343,9 +422,9 @@ void MediaPlayer::process(boost::shared_ptr<EndOfAudioStream>)
     endOfAudioStream = true;
     if (endOfVideoStream || ! hasVideoStream)
     {
-	close();
 	if (!skipForwardInt())
 	{
+	    close();
 	    // skipForward only skips until the last file is selected.
 	    // Application should see that the whole play list is finished:
 	    m_PlayList.selectEndOfList();
@@ -359,9 +438,9 @@ void MediaPlayer::process(boost::shared_ptr<EndOfVideoStream>)
     endOfVideoStream = true;
     if (endOfAudioStream || ! hasAudioStream)
     {
-	close();
 	if (!skipForwardInt())
 	{
+	    close();
 	    // skipForward only skips until the last file is selected.
 	    // Application should see that the whole play list is finished:
 	    m_PlayList.selectEndOfList();
@@ -28,6 +28,7 @@
 
 #include <boost/thread/thread.hpp>
 #include <boost/shared_ptr.hpp>
+#include <ostream>
 #include <string>
 
 class Demuxer;
@@ -38,11 +39,10 @@ class AudioOutput;
 class Deinterlacer;
 class PlayList;
 
-class MediaPlayer : public event_receiver<MediaPlayer,
-					  concurrent_queue<receive_fct_t, with_callback_function> >
+class MediaPlayer : public event_receiver<MediaPlayer, player_gui_queue_t>
 {
     // The friend declaration allows to define the process methods private:
-    friend class event_processor<concurrent_queue<receive_fct_t, with_callback_function> >;
+    friend class event_processor<player_gui_queue_t>;
 
 public:
     MediaPlayer(PlayList& playList);
@@ -62,6 +62,9 @@ public:
     void seekAbsolute(double second);
     void seekRelative(double secondsDelta);
 
+    // Fast forward and rewind with key frames only, see TrickPlayReq:
+    void trickPlay(int speed);
+
     void setPlaybackVolume(double volume);
     void setPlaybackSwitch(bool enabled);
 
@@ -74,10 +77,37 @@ public:
     void enableXvClipping();
     void disableXvClipping();
 
+    // Continue playback at the requested position instead of the
+    // preceding key frame after seeking:
+    void enableAccurateSeek();
+    void disableAccurateSeek();
+
     void selectDeinterlacer(const std::string& name);
 
     void setVideoAttribute(const std::string& name, int value);
 
+    // Size of the read-ahead buffer for local files in KiB, 0 disables
+    // it. Used when the next file is opened:
+    void setReadAheadSize(int kiloBytes);
+
+    // Watermarks for the packets queued by the Demuxer for each stream,
+    // see PacketBufferLimits:
+    void setPacketBufferLimits(double lowSeconds, double highSeconds,
+			       int lowKiloBytes, int highKiloBytes);
+
+    // Threads used by the video decoder, see SetDecoderThreading.
+    // Used when the next video stream is opened:
+    void setDecoderThreading(int threads, const std::string& threadTypes);
+
+    // Writes a snapshot of the event statistics of all threads:
+    void dumpEventStatistics(std::ostream& strm);
+
+    // Writes the event statistics and the frame dropping counters of
+    // the VideoDecoder to stdout, independent of the trace level and
+    // of EVENT_STATISTICS_ENABLED. Used while playing, e.g. when
+    // playback stutters:
+    void dumpStatistics();
+
 protected:
     // EventReceiver
     boost::shared_ptr<Demuxer> demuxer;
@@ -99,8 +129,8 @@ private:
 
     // EventProcessor:
     boost::shared_ptr<event_processor<> > demuxerEventProcessor;
-    boost::shared_ptr<event_processor<> > decoderEventProcessor;
-    boost::shared_ptr<event_processor<> > outputEventProcessor;
+    boost::shared_ptr<event_processor<player_queue_t> > decoderEventProcessor;
+    boost::shared_ptr<event_processor<player_queue_t> > outputEventProcessor;
 
     // PlayList:
     PlayList& m_PlayList;
@@ -121,6 +151,7 @@ private:
     void process(boost::shared_ptr<AudioSyncInfo> event);
 
     bool skipForwardInt();
+    void closeForNextFile();
 
     bool hasAudioStream;
     bool hasVideoStream;
@@ -136,6 +167,7 @@ private:
     virtual void process(boost::shared_ptr<NotificationDeinterlacerList> event) = 0;
     virtual void process(boost::shared_ptr<NotificationVideoAttribute> event) = 0;
     virtual void process(boost::shared_ptr<NotificationNewStream> event) = 0;
+    virtual void process(boost::shared_ptr<NotificationTrickPlayEnded> event) = 0;
 
     virtual void process(boost::shared_ptr<OpenAudioStreamFailed>) {};
     virtual void process(boost::shared_ptr<OpenVideoStreamFailed>) {};
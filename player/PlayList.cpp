@@ -91,6 +91,24 @@ std::string PlayList::getCurrent()
     }
 }
 
+std::string PlayList::getNext()
+{
+    if (m_current == m_list.end())
+    {
+	return std::string();
+    }
+
+    iterator tmp = m_current;
+    if (++tmp != m_list.end())
+    {
+	return *tmp;
+    }
+    else
+    {
+	return std::string();
+    }
+}
+
 int PlayList::getCurrentIndex()
 {
     // If nothing is selected, then this function returns
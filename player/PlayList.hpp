@@ -42,6 +42,7 @@ public:
     virtual iterator insert(int n, std::string);
 
     std::string getCurrent();
+    std::string getNext();  // Empty if the current entry is the last one.
     int getCurrentIndex();
     int getIndex(iterator it);
     bool selectNext();
@@ -0,0 +1,286 @@
+//
+// Probe Cache
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "player/ProbeCache.hpp"
+#include "platform/Logging.hpp"
+#include "platform/wire_format.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+static const uint32_t cacheMagic = 0x4350534b;  // "KSPC"
+static const uint32_t cacheVersion = 1;
+
+// Entries exceeding this number are dropped, least recently used first:
+static const size_t maxEntries = 1000;
+
+bool ProbeCache::Entry::matches(AVFormatContext* avFormatContext) const
+{
+    if (formatName != avFormatContext->iformat->name)
+    {
+	return false;
+    }
+
+    for (std::vector<Stream>::const_iterator it = streams.begin(); it != streams.end(); it++)
+    {
+	bool found = false;
+	for (unsigned int i = 0; i < avFormatContext->nb_streams && !found; i++)
+	{
+	    AVStream* avStream = avFormatContext->streams[i];
+	    AVCodecContext* avCodecContext = avStream->codec;
+	    if (avStream->id != it->id ||
+		avCodecContext->codec_type != it->codecType ||
+		avCodecContext->codec_id != it->codecId)
+	    {
+		continue;
+	    }
+
+	    switch (avCodecContext->codec_type)
+	    {
+	    case AVMEDIA_TYPE_VIDEO:
+		found = avCodecContext->width > 0 && avCodecContext->height > 0;
+		break;
+	    case AVMEDIA_TYPE_AUDIO:
+		found = avCodecContext->sample_rate > 0 && avCodecContext->channels > 0;
+		break;
+	    default:
+		found = true;
+		break;
+	    }
+	}
+
+	if (!found)
+	{
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+ProbeCache& ProbeCache::instance()
+{
+    static ProbeCache s_instance;
+    return s_instance;
+}
+
+ProbeCache::ProbeCache()
+{
+    char* home = getenv("HOME");
+    if (home)
+    {
+	cacheFileName = std::string(home).append("/.sinema-probe-cache");
+    }
+}
+
+bool ProbeCache::getFileStatus(const std::string& fileName,
+			       int64_t& fileSize, int64_t& modificationTime)
+{
+    std::string path = fileName;
+    if (path.compare(0, 5, "file:") == 0)
+    {
+	path.erase(0, 5);
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+	return false;
+    }
+
+    fileSize = st.st_size;
+    modificationTime = st.st_mtime;
+    return true;
+}
+
+void ProbeCache::eraseLocked(const std::string& fileName)
+{
+    index_type::iterator it = index.find(fileName);
+    if (it != index.end())
+    {
+	entries.erase(it->second);
+	index.erase(it);
+    }
+}
+
+bool ProbeCache::find(const std::string& fileName, Entry& entry)
+{
+    int64_t fileSize, modificationTime;
+    if (!getFileStatus(fileName, fileSize, modificationTime))
+    {
+	return false;
+    }
+
+    boost::mutex::scoped_lock lock(mutex);
+    index_type::iterator it = index.find(fileName);
+    if (it == index.end())
+    {
+	return false;
+    }
+
+    if (it->second->fileSize != fileSize ||
+	it->second->modificationTime != modificationTime)
+    {
+	// File was modified:
+	eraseLocked(fileName);
+	return false;
+    }
+
+    // List iterators stay valid:
+    entries.splice(entries.begin(), entries, it->second);
+    entry = *it->second;
+    return true;
+}
+
+double ProbeCache::getDuration(const std::string& fileName)
+{
+    boost::mutex::scoped_lock lock(mutex);
+    index_type::iterator it = index.find(fileName);
+    return it != index.end() ? it->second->duration : 0;
+}
+
+void ProbeCache::store(const std::string& fileName, AVFormatContext* avFormatContext)
+{
+    Entry entry;
+    if (!getFileStatus(fileName, entry.fileSize, entry.modificationTime))
+    {
+	return;
+    }
+
+    entry.fileName = fileName;
+    entry.formatName = avFormatContext->iformat->name;
+    if (avFormatContext->duration != int64_t(AV_NOPTS_VALUE))
+    {
+	entry.duration = double(avFormatContext->duration) / AV_TIME_BASE;
+    }
+
+    for (unsigned int i = 0; i < avFormatContext->nb_streams; i++)
+    {
+	AVCodecContext* avCodecContext = avFormatContext->streams[i]->codec;
+	if (avCodecContext->codec_type == AVMEDIA_TYPE_VIDEO ||
+	    avCodecContext->codec_type == AVMEDIA_TYPE_AUDIO)
+	{
+	    Stream stream;
+	    stream.id = avFormatContext->streams[i]->id;
+	    stream.codecType = avCodecContext->codec_type;
+	    stream.codecId = avCodecContext->codec_id;
+	    entry.streams.push_back(stream);
+	}
+    }
+
+    boost::mutex::scoped_lock saveLock(saveMutex);
+    std::vector<Entry> stored;
+    {
+	boost::mutex::scoped_lock lock(mutex);
+
+	eraseLocked(fileName);
+	entries.push_front(entry);
+	index[fileName] = entries.begin();
+	while (entries.size() > maxEntries)
+	{
+	    index.erase(entries.back().fileName);
+	    entries.pop_back();
+	}
+
+	stored.assign(entries.begin(), entries.end());
+    }
+
+    save(stored);
+}
+
+void ProbeCache::load()
+{
+    if (cacheFileName.empty())
+    {
+	return;
+    }
+
+    std::ifstream file(cacheFileName.c_str(), std::ios::binary);
+    if (!file.is_open())
+    {
+	return;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+			     std::istreambuf_iterator<char>());
+    if (buffer.empty())
+    {
+	return;
+    }
+
+    uint32_t magic, version;
+    std::vector<Entry> loaded;
+
+    itf::binary_iarchive archive(&buffer[0], &buffer[0] + buffer.size());
+    archive >> magic >> version;
+    if (magic != cacheMagic || version != cacheVersion)
+    {
+	return;
+    }
+    archive >> loaded;
+    if (!archive.complete())
+    {
+	TRACE_ERROR(<< "invalid " << cacheFileName);
+	return;
+    }
+
+    // The GUI thread may already look up durations:
+    boost::mutex::scoped_lock lock(mutex);
+    for (std::vector<Entry>::iterator it = loaded.begin(); it != loaded.end(); it++)
+    {
+	if (index.find(it->fileName) == index.end())
+	{
+	    index[it->fileName] = entries.insert(entries.end(), *it);
+	}
+    }
+}
+
+// Called without holding mutex, see store():
+void ProbeCache::save(const std::vector<Entry>& stored)
+{
+    if (cacheFileName.empty())
+    {
+	return;
+    }
+
+    std::vector<char> buffer;
+    itf::binary_oarchive archive(buffer);
+    archive << cacheMagic << cacheVersion << stored;
+
+    // Replace the file atomically, another instance may read it:
+    std::string tmpFileName = cacheFileName + ".tmp";
+    {
+	std::ofstream file(tmpFileName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+	    return;
+	}
+	file.write(&buffer[0], buffer.size());
+	if (!file.good())
+	{
+	    return;
+	}
+    }
+    rename(tmpFileName.c_str(), cacheFileName.c_str());
+}
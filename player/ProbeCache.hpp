@@ -0,0 +1,135 @@
+//
+// Probe Cache
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef PROBE_CACHE_HPP
+#define PROBE_CACHE_HPP
+
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+// Remembers the result of avformat_find_stream_info for local files in
+// ~/.sinema-probe-cache. An entry is only valid while size and
+// modification time of the file are unchanged.
+//
+// For MPEG PS and TS avformat_find_stream_info reads up to probesize
+// bytes, because new streams may appear at any time. If the streams of
+// a file are already known, the Demuxer forces the input format and
+// probes with a much smaller probesize. If this does not find all
+// cached streams, the file is probed again with the defaults.
+//
+// The cache is used by the Demuxer thread and the GUI thread, which
+// shows the duration in the play list. The GUI thread only takes mutex
+// for a map lookup. The cache file is read by the Demuxer thread when
+// it is initialized and written without holding mutex.
+
+class ProbeCache : private boost::noncopyable
+{
+public:
+    struct Stream
+    {
+	Stream() : id(0), codecType(0), codecId(0) {}
+
+	template<class Archive>
+	void serialize(Archive& ar, const unsigned int)
+	{
+	    ar & id;
+	    ar & codecType;
+	    ar & codecId;
+	}
+
+	int32_t id;         // AVStream::id
+	int32_t codecType;  // AVMediaType
+	int32_t codecId;    // AVCodecID
+    };
+
+    struct Entry
+    {
+	Entry() : fileSize(0), modificationTime(0), duration(0) {}
+
+	template<class Archive>
+	void serialize(Archive& ar, const unsigned int)
+	{
+	    ar & fileName;
+	    ar & fileSize;
+	    ar & modificationTime;
+	    ar & formatName;
+	    ar & duration;
+	    ar & streams;
+	}
+
+	// True if avFormatContext contains all cached streams with
+	// complete codec parameters:
+	bool matches(AVFormatContext* avFormatContext) const;
+
+	std::string fileName;
+	int64_t fileSize;
+	int64_t modificationTime;
+	std::string formatName;
+	double duration;  // seconds, 0 if unknown
+	std::vector<Stream> streams;
+    };
+
+    static ProbeCache& instance();
+
+    // Reads the cache file. Called once by the Demuxer thread before
+    // any file is opened, the GUI thread never waits for the file:
+    void load();
+
+    bool find(const std::string& fileName, Entry& entry);
+    void store(const std::string& fileName, AVFormatContext* avFormatContext);
+
+    // Returns 0 if unknown. The file is not accessed, i.e. the entry is
+    // not validated before the file is opened with find():
+    double getDuration(const std::string& fileName);
+
+private:
+    ProbeCache();
+
+    typedef std::list<Entry> list_type;
+    typedef std::map<std::string, list_type::iterator> index_type;
+
+    static bool getFileStatus(const std::string& fileName,
+			      int64_t& fileSize, int64_t& modificationTime);
+
+    void eraseLocked(const std::string& fileName);
+    void save(const std::vector<Entry>& stored);
+
+    boost::mutex mutex;
+    // Serializes writing the cache file, taken before mutex:
+    boost::mutex saveMutex;
+    std::string cacheFileName;
+    // Most recently used entry first:
+    list_type entries;
+    // Entries by file name:
+    index_type index;
+};
+
+#endif
@@ -0,0 +1,257 @@
+//
+// Read-Ahead File
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "player/ReadAheadFile.hpp"
+#include "platform/Logging.hpp"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Size of a single read system call:
+static const size_t chunkSize = 256 * 1024;
+
+ReadAheadFile::ReadAheadFile(size_t windowSize, boost::function<void ()> notify)
+    : m_windowSize(std::max(windowSize, 4 * chunkSize)),
+      m_lowWatermark(std::min(m_windowSize / 4, size_t(2 * 1024 * 1024))),
+      m_keepBehind(m_windowSize / 8),
+      m_notify(notify),
+      m_fd(-1),
+      m_fileSize(-1),
+      m_start(0),
+      m_pos(0),
+      m_end(0),
+      m_generation(0),
+      m_eof(false),
+      m_error(false),
+      m_starving(false),
+      m_quit(false)
+{
+}
+
+ReadAheadFile::~ReadAheadFile()
+{
+    close();
+}
+
+bool ReadAheadFile::open(const std::string& fileName)
+{
+    std::string path = fileName;
+    if (path.compare(0, 5, "file:") == 0)
+    {
+	path.erase(0, 5);
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+	return false;
+    }
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0)
+    {
+	TRACE_ERROR(<< "open " << path << " failed: " << strerror(errno));
+	return false;
+    }
+
+    posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    m_fileSize = st.st_size;
+    m_buffer.resize(m_windowSize);
+    m_start = m_pos = m_end = 0;
+    m_eof = m_error = m_starving = m_quit = false;
+
+    m_thread = boost::thread(boost::bind(&ReadAheadFile::operator(), this));
+
+    return true;
+}
+
+void ReadAheadFile::close()
+{
+    if (m_fd < 0)
+    {
+	return;
+    }
+
+    {
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_quit = true;
+    }
+    m_spaceAvailable.notify_one();
+    m_dataAvailable.notify_one();
+    m_thread.join();
+
+    ::close(m_fd);
+    m_fd = -1;
+    m_fileSize = -1;
+    std::vector<uint8_t>().swap(m_buffer);
+}
+
+int ReadAheadFile::read(uint8_t* buf, int size)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    while (buffered() == 0 && !m_eof && !m_error && !m_quit)
+    {
+	m_dataAvailable.wait(lock);
+    }
+
+    if (buffered() == 0)
+    {
+	return m_error ? -1 : 0;
+    }
+
+    size_t length = std::min(size_t(size), buffered());
+    size_t offset = m_pos % m_windowSize;
+    size_t first = std::min(length, m_windowSize - offset);
+    memcpy(buf, &m_buffer[offset], first);
+    memcpy(buf + first, &m_buffer[0], length - first);
+    m_pos += length;
+
+    lock.unlock();
+    m_spaceAvailable.notify_one();
+
+    return length;
+}
+
+int64_t ReadAheadFile::seek(int64_t offset, int whence)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    int64_t target;
+    switch (whence)
+    {
+    case SEEK_SET: target = offset; break;
+    case SEEK_CUR: target = m_pos + offset; break;
+    case SEEK_END: target = m_fileSize + offset; break;
+    default: return -1;
+    }
+
+    if (target < 0)
+    {
+	return -1;
+    }
+
+    if (uint64_t(target) >= m_start && uint64_t(target) <= m_end)
+    {
+	// Still buffered:
+	m_pos = target;
+    }
+    else
+    {
+	// Discard the window. Data that is currently read by the
+	// read-ahead thread is dropped when m_generation changed:
+	m_generation++;
+	m_start = m_pos = m_end = target;
+	m_eof = false;
+	m_error = false;
+	lock.unlock();
+	m_spaceAvailable.notify_one();
+    }
+
+    return target;
+}
+
+bool ReadAheadFile::readable()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (readableLocked())
+    {
+	return true;
+    }
+    m_starving = true;
+    return false;
+}
+
+bool ReadAheadFile::readableLocked() const
+{
+    return buffered() >= m_lowWatermark || m_eof || m_error;
+}
+
+void ReadAheadFile::operator()()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    while (!m_quit)
+    {
+	// Keep some data behind the read position for short backward seeks:
+	uint64_t keepFrom = m_pos > m_keepBehind ? m_pos - m_keepBehind : 0;
+	if (m_start < keepFrom)
+	{
+	    m_start = keepFrom;
+	}
+
+	size_t space = m_windowSize - (m_end - m_start);
+	if (m_eof || m_error || space == 0)
+	{
+	    m_spaceAvailable.wait(lock);
+	    continue;
+	}
+
+	// Read into the free part of the ring buffer. That part is not
+	// accessed by the Demuxer thread:
+	uint64_t end = m_end;
+	unsigned int generation = m_generation;
+	size_t offset = end % m_windowSize;
+	size_t length = std::min(std::min(space, chunkSize), m_windowSize - offset);
+
+	lock.unlock();
+	ssize_t ret = pread(m_fd, &m_buffer[offset], length, end);
+	int err = errno;
+	lock.lock();
+
+	if (generation != m_generation)
+	{
+	    // Seek outside the window in between.
+	    continue;
+	}
+
+	if (ret > 0)
+	{
+	    m_end += ret;
+	}
+	else if (ret == 0)
+	{
+	    m_eof = true;
+	}
+	else if (err != EINTR)
+	{
+	    TRACE_ERROR(<< "read failed: " << strerror(err));
+	    m_error = true;
+	}
+
+	m_dataAvailable.notify_one();
+
+	if (m_starving && readableLocked())
+	{
+	    m_starving = false;
+	    lock.unlock();
+	    m_notify();
+	    lock.lock();
+	}
+    }
+}
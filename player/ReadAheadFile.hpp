@@ -0,0 +1,101 @@
+//
+// Read-Ahead File
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef READ_AHEAD_FILE_HPP
+#define READ_AHEAD_FILE_HPP
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Reads a local file in an own thread into a ring buffer. The Demuxer
+// reads from the buffer through a custom AVIOContext. Thus a slow disk
+// does not block the Demuxer thread, which also has to process Flush
+// and Confirm events.
+//
+// The buffer holds a window of the file around the read position. A
+// seek into the window only moves the read position. Any other seek
+// discards the window and the thread refills it starting at the new
+// position, while seek returns immediately.
+
+class ReadAheadFile : private boost::noncopyable
+{
+public:
+    // notify is called by the read-ahead thread when readable() returned
+    // false before and enough data is available now:
+    ReadAheadFile(size_t windowSize, boost::function<void ()> notify);
+    ~ReadAheadFile();
+
+    // Returns false if fileName is not a regular local file:
+    bool open(const std::string& fileName);
+    void close();
+
+    // Called by the Demuxer thread. Blocks until at least one byte is
+    // available. Returns 0 at end of file and -1 on read errors:
+    int read(uint8_t* buf, int size);
+    int64_t seek(int64_t offset, int whence);
+    int64_t size() const {return m_fileSize;}
+
+    // True if data for at least one packet is buffered, i.e. read does
+    // not block:
+    bool readable();
+
+private:
+    void operator()();
+
+    size_t buffered() const {return m_end - m_pos;}
+    bool readableLocked() const;
+
+    const size_t m_windowSize;
+    const size_t m_lowWatermark;
+    const size_t m_keepBehind;
+    boost::function<void ()> m_notify;
+
+    int m_fd;
+    int64_t m_fileSize;
+    std::vector<uint8_t> m_buffer;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_dataAvailable;
+    boost::condition_variable m_spaceAvailable;
+
+    // The file range [m_start, m_end) is buffered, m_pos is the read
+    // position within this range:
+    uint64_t m_start;
+    uint64_t m_pos;
+    uint64_t m_end;
+
+    // Incremented when the window is discarded:
+    unsigned int m_generation;
+    bool m_eof;
+    bool m_error;
+    bool m_starving;
+    bool m_quit;
+
+    boost::thread m_thread;
+};
+
+#endif
@@ -347,8 +347,8 @@ SyncTestApp::SyncTestApp()
 {
     // Create event_processor instances:
     testEventProcessor = boost::make_shared<event_processor<> >();
-    audioOutputEventProcessor = boost::make_shared<event_processor<> >();
-    videoOutputEventProcessor = boost::make_shared<event_processor<concurrent_queue<receive_fct_t, with_callback_function> > >();
+    audioOutputEventProcessor = boost::make_shared<event_processor<player_queue_t> >();
+    videoOutputEventProcessor = boost::make_shared<event_processor<player_gui_queue_t> >();
 
     // Create event_receiver instances:
     test = boost::make_shared<SyncTest>(testEventProcessor);
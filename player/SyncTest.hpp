@@ -84,6 +84,7 @@ private:
     void process(boost::shared_ptr<NotificationCurrentTime>) {}
     void process(boost::shared_ptr<NotificationCurrentVolume>) {}
     void process(boost::shared_ptr<SeekRelativeReq>) {}
+    void process(boost::shared_ptr<VideoLateness>) {}
 
     void generate();
     void generateAudioFrameTonleiter(boost::shared_ptr<AudioFrame> audioFrame);
@@ -118,8 +119,8 @@ private:
 
     // EventProcessor:
     boost::shared_ptr<event_processor<> > testEventProcessor;
-    boost::shared_ptr<event_processor<> > audioOutputEventProcessor;
-    boost::shared_ptr<event_processor<concurrent_queue<receive_fct_t, with_callback_function> > > videoOutputEventProcessor;
+    boost::shared_ptr<event_processor<player_queue_t> > audioOutputEventProcessor;
+    boost::shared_ptr<event_processor<player_gui_queue_t> > videoOutputEventProcessor;
     void sendInitEvents();
 };
 
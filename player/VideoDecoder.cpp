@@ -27,9 +27,15 @@
 #include "player/XlibFacade.hpp"
 #include "player/XlibHelpers.hpp"
 #include "player/JpegWriter.hpp"
+#include "platform/event_pool.hpp"
 
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
 #include <iomanip>
+#include <iterator>
+#include <sstream>
 #include <sys/types.h>
 
 using namespace std;
@@ -46,14 +52,43 @@ VideoDecoder::VideoDecoder(event_processor_ptr_type evt_proc)
       avFrame(avcodec_alloc_frame()),
       avFrameIsFree(true),
       pts(0),
+      seekTarget(-1),
+      numSkippedFrames(0),
+      trickPlay(false),
+      trickPlayDrained(false),
       m_fourccFormat(0),
       m_dstWidth(0),
       m_dstHeight(0),
+      m_directRendering(false),
+      m_imageRequested(false),
       eos(false),
-      swsContext(0),
+      m_convertedFrame(avcodec_alloc_frame()),
+      m_converting(false),
+      m_conversionId(0),
       m_topFieldFirst(true),
-      m_useOptimumImageFormat(true)
+      m_useOptimumImageFormat(true),
+      m_decoderThreads(0),
+      m_discardLevel(0),
+      m_lateness(0),
+      m_clockValid(false),
+      m_clockPTS(0),
+      m_droppedInRow(0),
+      m_numDroppedFrames(0),
+      m_numDiscardedPackets(0),
+      m_maxDiscardLevel(0),
+      m_totalDroppedFrames(0),
+      m_totalDiscardedPackets(0),
+      m_totalSkippedFrames(0),
+      m_currentDiscardLevel(0)
 {
+    m_discardLevelTime.tv_sec = 0;
+    m_discardLevelTime.tv_nsec = 0;
+    m_clockTime.tv_sec = 0;
+    m_clockTime.tv_nsec = 0;
+    m_lastLateTime.tv_sec = 0;
+    m_lastLateTime.tv_nsec = 0;
+
+    m_threadTypes["default"] = FF_THREAD_FRAME | FF_THREAD_SLICE;
     TRACE_DEBUG(<< "tid = " << gettid());
 }
 
@@ -63,15 +98,28 @@ VideoDecoder::~VideoDecoder()
 
     if (avFrame)
     {
+	av_frame_unref(avFrame);
 	av_free(avFrame);
     }
-    
-    if (swsContext)
+
+    if (m_convertedFrame)
     {
-	sws_freeContext(swsContext);
+	m_scaler.wait();
+	av_frame_unref(m_convertedFrame);
+	av_free(m_convertedFrame);
     }
 }
 
+void VideoDecoder::dumpStatistics(std::ostream& strm)
+{
+    strm << "Video decoder statistics"
+	 << ": dropped frames=" << m_totalDroppedFrames.load(std::memory_order_relaxed)
+	 << ", discarded packets=" << m_totalDiscardedPackets.load(std::memory_order_relaxed)
+	 << ", skipped frames=" << m_totalSkippedFrames.load(std::memory_order_relaxed)
+	 << ", discard level=" << m_currentDiscardLevel.load(std::memory_order_relaxed)
+	 << std::endl;
+}
+
 void VideoDecoder::process(boost::shared_ptr<InitEvent> event)
 {
     TRACE_DEBUG(<< "tid = " << gettid());
@@ -132,9 +180,35 @@ void VideoDecoder::process(boost::shared_ptr<OpenVideoStreamReq> event)
 		avCodec = avcodec_find_decoder(avCodecContext->codec_id);
 		if (avCodec)
 		{
+		    // Decode YUV420P directly into the XvImages:
+		    m_directRendering = (avCodec->capabilities & CODEC_CAP_DR1) &&
+			avCodecContext->pix_fmt == PIX_FMT_YUV420P;
+		    avCodecContext->opaque = this;
+		    if (m_directRendering)
+		    {
+			// The XvImages have no edges around the picture:
+			avCodecContext->get_buffer2 = getBuffer2;
+			avCodecContext->flags |= CODEC_FLAG_EMU_EDGE;
+		    }
+		    else
+		    {
+			avCodecContext->get_buffer2 = avcodec_default_get_buffer2;
+		    }
+
+		    // Frames are kept while converted, see queue():
+		    avCodecContext->refcounted_frames = 1;
+
+		    resetFrameDropping();
+		    setupThreading();
 		    int ret = avcodec_open2(avCodecContext, avCodec, 0);
 		    if (ret == 0)
 		    {
+			TRACE_INFO(<< avCodec->name << ": thread_count = " << avCodecContext->thread_count
+				   << ", active_thread_type ="
+				   << (avCodecContext->active_thread_type & FF_THREAD_FRAME ? " frame" : "")
+				   << (avCodecContext->active_thread_type & FF_THREAD_SLICE ? " slice" : "")
+				   << (avCodecContext->active_thread_type == 0 ? " none" : ""));
+
 			avStream = avFormatContext->streams[videoStreamIndex];
 			int w = avCodecContext->width;
 			int h = avCodecContext->height;
@@ -154,8 +228,11 @@ void VideoDecoder::process(boost::shared_ptr<OpenVideoStreamReq> event)
 			    // Set format needed to use the deinterlacer:
 			    setFourccFormat(GUID_YUY2_PACKED);
 			}
+			int iw, ih;
+			getImageSize(iw, ih);
 			videoOutput->queue_event(boost::make_shared<OpenVideoOutputReq>(w,h,pn,pd,
-											m_fourccFormat));
+											m_fourccFormat,
+											iw,ih));
 
 			state = Opening;
 
@@ -223,14 +300,24 @@ void VideoDecoder::process(boost::shared_ptr<OpenVideoOutputFail>)
     }
 }
 
-void VideoDecoder::process(boost::shared_ptr<CloseVideoStreamReq>)
+void VideoDecoder::process(boost::shared_ptr<CloseVideoStreamReq> event)
 {
     if (state != Closed)
     {
 	TRACE_DEBUG();
 
+	if (m_converting)
+	{
+	    finishConversion(false);
+	}
+	av_frame_unref(avFrame);
+
 	if (state == Opened)
 	{
+	    TRACE_INFO(<< "frame dropping: dropped " << m_numDroppedFrames
+		       << " frames, discarded " << m_numDiscardedPackets
+		       << " packets, max discard level " << m_maxDiscardLevel);
+
 	    avcodec_close(avCodecContext);
 	}
 
@@ -242,14 +329,17 @@ void VideoDecoder::process(boost::shared_ptr<CloseVideoStreamReq>)
 
 	avPacketIsFree = true;
 
-	// Throw away all queued frames:
+	// Throw away all queued frames. FFmpeg released all of them, but
+	// DirectRenderingBufferReleased may not yet be received:
 	while (!frameQueue.empty())
 	{
 	    std::unique_ptr<XFVideoImage> xfVideoImage(std::move(frameQueue.front()));
-	    frameQueue.pop();
-	    videoOutput->queue_event(std::move(std::unique_ptr<DeleteXFVideoImage>(new DeleteXFVideoImage(std::move(xfVideoImage)))));
+	    frameQueue.pop_front();
+	    deleteImage(std::move(xfVideoImage));
 	}
 	avFrameIsFree = true;
+	m_directRendering = false;
+	m_imageRequested = false;
 
 	// Do the same as the Deinterlacer when receiving CloseVideoOutputReq:
 	m_topFieldFirst = true;
@@ -257,7 +347,7 @@ void VideoDecoder::process(boost::shared_ptr<CloseVideoStreamReq>)
 	// Do not reset m_useOptimumImageFormat, it is a configuration parameter.
 
 	// Send event via Deinterlacer to VideoOutput:
-	deinterlacer->queue_event(boost::make_shared<CloseVideoOutputReq>());
+	deinterlacer->queue_event(boost::make_shared<CloseVideoOutputReq>(event->keepOutput));
 
 	state = Closing;
     }
@@ -279,13 +369,11 @@ void VideoDecoder::process(boost::shared_ptr<CloseVideoOutputResp>)
 	// Keep avFrame.
 	avFrameIsFree = true;
 	pts = 0;
+	seekTarget = -1;
+	trickPlay = false;
 	m_fourccFormat = 0;
 
-	if (swsContext)
-	{
-	    sws_freeContext(swsContext);
-	    swsContext = 0;
-	}
+	m_scaler.reset();
 
 	m_dstWidth = 0;
 	m_dstHeight = 0;
@@ -298,6 +386,13 @@ void VideoDecoder::process(boost::shared_ptr<CloseVideoOutputResp>)
 
 void VideoDecoder::process(boost::shared_ptr<VideoPacketEvent> event)
 {
+    if (overtaken_by<FlushReq>())
+    {
+	// Packet was sent before the FlushReq:
+	demuxer->queue_event(make_pooled_event<ConfirmVideoPacketEvent>(*event));
+	return;
+    }
+
     if (state == Opened)
     {
 	TRACE_DEBUG();
@@ -329,28 +424,34 @@ void VideoDecoder::process(std::unique_ptr<XFVideoImage> event)
 			<< " got: " << event->width() << "*" << event->height()
 			<< std::hex << ", 0x" << fourccFormat );
 
-	    videoOutput->queue_event(std::move(std::unique_ptr<DeleteXFVideoImage>(new DeleteXFVideoImage(std::move(event)))));
+	    deleteImage(std::move(event));
 
 	    requestNewFrame();
 
 	    return;
 	}
-	else if (m_dstWidth != int(event->width()) ||
-		 m_dstHeight != int(event->height()))
+
+	// Images used for direct rendering may be bigger than the video,
+	// but only the video size is displayed:
+	int dstWidth = std::min(int(event->width()), event->requestedWidth());
+	int dstHeight = std::min(int(event->height()), event->requestedHeight());
+	if (m_dstWidth != dstWidth ||
+	    m_dstHeight != dstHeight)
 	{
-	    m_dstWidth = event->width();
-	    m_dstHeight = event->height();
+	    m_dstWidth = dstWidth;
+	    m_dstHeight = dstHeight;
 	    getSwsContext();
 	}
 
 	// Add XFVideoImage with correct size and format to frameQueue:
-	frameQueue.push(std::move(event));
+	frameQueue.push_back(std::move(event));
+	m_imageRequested = false;
 	queue();
 	decode();
     }
     else
     {
-      	videoOutput->queue_event(std::move(std::unique_ptr<DeleteXFVideoImage>(new DeleteXFVideoImage(std::move(event)))));
+	deleteImage(std::move(event));
     }
 }
 
@@ -360,40 +461,55 @@ void VideoDecoder::process(boost::shared_ptr<FlushReq> event)
     {
 	TRACE_DEBUG();
 
+	if (m_converting)
+	{
+	    finishConversion(false);
+	}
+	av_frame_unref(avFrame);
+
 	// Flush buffers in ffmpeg decoder:
 	avcodec_flush_buffers(avCodecContext);
 
 	// Throw away everything received from the Demuxer:
-	boost::shared_ptr<ConfirmVideoPacketEvent> confirm(new ConfirmVideoPacketEvent());
 	while (!packetQueue.empty())
 	{
+	    demuxer->queue_event(make_pooled_event<ConfirmVideoPacketEvent>(*packetQueue.front()));
 	    packetQueue.pop();
-	    demuxer->queue_event(confirm);
 	}
 
 	avPacketIsFree = true;
 	avFrameIsFree = true;
 
+	// In trick play only intra frames are decoded:
+	trickPlay = (event->trickPlaySpeed != 0);
+	trickPlayDrained = false;
+	avCodecContext->skip_frame = trickPlay ? AVDISCARD_NONKEY : getSkipFrame();
+	seekTarget = event->seekTarget;
+	if (seekTarget >= 0)
+	{
+	    seekStart = timer::get_current_time();
+	    numSkippedFrames = 0;
+	}
+
+	// The audio clock restarts at the new position:
+	m_clockValid = false;
+	m_lateness = 0;
+	m_droppedInRow = 0;
+
 	// Forward event via Deinterlacer to VideoOutput:
 	deinterlacer->queue_event(event);
     }
 }
 
-void VideoDecoder::process(boost::shared_ptr<EndOfVideoStream> event)
+void VideoDecoder::process(boost::shared_ptr<EndOfVideoStream>)
 {
     if (state == Opened)
     {
 	TRACE_DEBUG();
 	eos = true;
 
-	if (packetQueue.empty())
-	{
-	    // Decoded everything in this stream.
-
-	    // Forward event via Deinterlacer to VideoOutput:
-	    deinterlacer->queue_event(event);
-	    eos = false;
-	}
+	// Frames delayed by the decoder are still missing:
+	decode();
     }
 }
 
@@ -427,6 +543,213 @@ void VideoDecoder::process(boost::shared_ptr<DisableOptimalPixelFormat>)
     }
 }
 
+void VideoDecoder::process(boost::shared_ptr<SetDecoderThreading> event)
+{
+    TRACE_DEBUG(<< event->threads << ", " << event->threadTypes);
+
+    m_decoderThreads = event->threads;
+    m_threadTypes.clear();
+    m_threadTypes["default"] = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    std::istringstream iss(event->threadTypes);
+    std::string entry;
+    while (std::getline(iss, entry, ','))
+    {
+	if (entry.empty())
+	{
+	    continue;
+	}
+
+	std::string::size_type n = entry.find('=');
+	if (n == std::string::npos)
+	{
+	    TRACE_ERROR(<< "invalid thread type entry: " << entry);
+	    continue;
+	}
+
+	std::string types = entry.substr(n + 1);
+	int threadType = 0;
+	if (types == "frame")             threadType = FF_THREAD_FRAME;
+	else if (types == "slice")        threadType = FF_THREAD_SLICE;
+	else if (types == "frame+slice")  threadType = FF_THREAD_FRAME | FF_THREAD_SLICE;
+	else if (types != "none")
+	{
+	    TRACE_ERROR(<< "invalid thread type: " << entry);
+	    continue;
+	}
+
+	m_threadTypes[entry.substr(0, n)] = threadType;
+    }
+}
+
+void VideoDecoder::setupThreading()
+{
+    // Must be set before avcodec_open2. FFmpeg uses only the thread
+    // types supported by the codec, see active_thread_type.
+    int threads = m_decoderThreads;
+    if (threads <= 0)
+    {
+	threads = std::min(std::max(int(boost::thread::hardware_concurrency()), 1), 16);
+    }
+
+    std::map<std::string, int>::const_iterator it = m_threadTypes.find(avCodec->name);
+    if (it == m_threadTypes.end())
+    {
+	it = m_threadTypes.find("default");
+    }
+    int threadType = (it != m_threadTypes.end()) ? it->second : 0;
+
+    avCodecContext->thread_count = threadType ? threads : 1;
+    avCodecContext->thread_type = threadType;
+}
+
+void VideoDecoder::process(boost::shared_ptr<DirectRenderingBufferReleased> event)
+{
+    TRACE_DEBUG();
+
+    m_referencedImages.erase(event->data);
+
+    for (std::list<std::unique_ptr<XFVideoImage> >::iterator it = m_deletedImages.begin();
+	 it != m_deletedImages.end(); it++)
+    {
+	if ((*it)->data() == event->data)
+	{
+	    std::unique_ptr<XFVideoImage> xfVideoImage(std::move(*it));
+	    m_deletedImages.erase(it);
+	    videoOutput->queue_event(std::unique_ptr<DeleteXFVideoImage>(new DeleteXFVideoImage(std::move(xfVideoImage))));
+	    return;
+	}
+    }
+
+    if (state == Opened)
+    {
+	// The image may be used again:
+	queue();
+	decode();
+    }
+}
+
+int VideoDecoder::getBuffer2(AVCodecContext* avCodecContext, AVFrame* frame, int flags)
+{
+    // Without thread_safe_callbacks FFmpeg calls this in the VideoDecoder
+    // thread, also for frame threading.
+    return ((VideoDecoder*)avCodecContext->opaque)->getBuffer(frame, flags);
+}
+
+void VideoDecoder::releaseBuffer(void* opaque, uint8_t* data)
+{
+    // May be called by the threads of FFmpeg:
+    ((VideoDecoder*)opaque)->queue_event(make_pooled_event<DirectRenderingBufferReleased>((char*)data));
+}
+
+int VideoDecoder::getBuffer(AVFrame* frame, int flags)
+{
+    if (!m_directRendering ||
+	frame->format != PIX_FMT_YUV420P ||
+	m_fourccFormat != GUID_YUV12_PLANAR)
+    {
+	return avcodec_default_get_buffer2(avCodecContext, frame, flags);
+    }
+
+    int w = frame->width;
+    int h = frame->height;
+    int linesizeAlign[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(avCodecContext, &w, &h, linesizeAlign);
+
+    // Keep one image for frames that are not decoded directly:
+    frame_queue_type::iterator it = findFreeImage(frameQueue.begin());
+    if (it == frameQueue.end() ||
+	findFreeImage(std::next(it)) == frameQueue.end())
+    {
+	return avcodec_default_get_buffer2(avCodecContext, frame, flags);
+    }
+
+    XvImage* yuvImage = (*it)->xvImage();
+    if (yuvImage->id != GUID_YUV12_PLANAR ||
+	yuvImage->width < w ||
+	yuvImage->height < h)
+    {
+	return avcodec_default_get_buffer2(avCodecContext, frame, flags);
+    }
+
+    // XvImage planes are Y, V, U:
+    static const int plane[3] = {0, 2, 1};
+    for (int i = 0; i < 3; i++)
+    {
+	frame->data[i] = (uint8_t*)yuvImage->data + yuvImage->offsets[plane[i]];
+	frame->linesize[i] = yuvImage->pitches[plane[i]];
+	if (frame->linesize[i] % linesizeAlign[i] ||
+	    uintptr_t(frame->data[i]) % linesizeAlign[i])
+	{
+	    TRACE_DEBUG(<< "XvImage pitches not usable for direct rendering");
+	    return avcodec_default_get_buffer2(avCodecContext, frame, flags);
+	}
+    }
+    for (int i = 3; i < AV_NUM_DATA_POINTERS; i++)
+    {
+	frame->data[i] = 0;
+	frame->linesize[i] = 0;
+    }
+    frame->extended_data = frame->data;
+
+    // One buffer for all planes. It is released when FFmpeg no longer
+    // needs the frame, which may be long after it was displayed:
+    frame->buf[0] = av_buffer_create((uint8_t*)yuvImage->data, yuvImage->data_size,
+				     releaseBuffer, this, 0);
+    if (!frame->buf[0])
+    {
+	return AVERROR(ENOMEM);
+    }
+
+    m_referencedImages.insert(yuvImage->data);
+    return 0;
+}
+
+void VideoDecoder::getImageSize(int& width, int& height)
+{
+    width = avCodecContext->width;
+    height = avCodecContext->height;
+
+    if (m_directRendering && m_fourccFormat == GUID_YUV12_PLANAR)
+    {
+	// The decoder needs aligned buffers, e.g. 1088 lines for H.264 1080p:
+	int linesizeAlign[AV_NUM_DATA_POINTERS];
+	width = std::max(width, avCodecContext->coded_width);
+	height = std::max(height, avCodecContext->coded_height);
+	avcodec_align_dimensions2(avCodecContext, &width, &height, linesizeAlign);
+
+	// The chroma planes have half the width:
+	width = FFALIGN(width, 2 * linesizeAlign[0]);
+    }
+}
+
+bool VideoDecoder::isReferenced(XFVideoImage* xfVideoImage)
+{
+    return m_referencedImages.count(xfVideoImage->data()) != 0;
+}
+
+VideoDecoder::frame_queue_type::iterator VideoDecoder::findFreeImage(frame_queue_type::iterator it)
+{
+    // Returns the first image that is not referenced by FFmpeg:
+    while (it != frameQueue.end() && isReferenced(it->get()))
+    {
+	it++;
+    }
+    return it;
+}
+
+void VideoDecoder::deleteImage(std::unique_ptr<XFVideoImage> xfVideoImage)
+{
+    if (isReferenced(xfVideoImage.get()))
+    {
+	// Deleted when DirectRenderingBufferReleased is received:
+	m_deletedImages.push_back(std::move(xfVideoImage));
+	return;
+    }
+
+    videoOutput->queue_event(std::unique_ptr<DeleteXFVideoImage>(new DeleteXFVideoImage(std::move(xfVideoImage))));
+}
+
 std::ostream& operator<<(std::ostream& strm, AVRational r)
 {
     strm << r.num << "/" << r.den;
@@ -459,14 +782,48 @@ void VideoDecoder::decode()
 
 	if (avPacket.size == 0)
 	{
+	    if (trickPlay && !trickPlayDrained)
+	    {
+		// Only key frames are received, maybe in reverse order.
+		// Get the frame delayed by the decoder now:
+		if (decodeDelayedFrame())
+		{
+		    if (!avFrameIsFree)
+		    {
+			// Call queue() again when a frame is available.
+			return;
+		    }
+		    continue;
+		}
+		trickPlayDrained = true;
+		continue;
+	    }
+
+	    if (trickPlay)
+	    {
+		// The next key frame is decoded without references:
+		avcodec_flush_buffers(avCodecContext);
+		trickPlayDrained = false;
+	    }
+
 	    // Decoded complete packet.
+	    TRACE_DEBUG(<< "Queueing ConfirmVideoPacketEvent");
+	    demuxer->queue_event(make_pooled_event<ConfirmVideoPacketEvent>(*packetQueue.front()));
 	    packetQueue.pop();
 	    avPacketIsFree = true;
-	    TRACE_DEBUG(<< "Queueing ConfirmVideoPacketEvent");
-	    demuxer->queue_event(boost::make_shared<ConfirmVideoPacketEvent>());
 	    continue;
 	}
 
+	if (seekTarget >= 0)
+	{
+	    // Don't decode frames before the seek target, that are not
+	    // needed as reference for other frames. Without timestamp the
+	    // packet may contain the target frame:
+	    int64_t timestamp = avPacket.pts != int64_t(AV_NOPTS_VALUE) ? avPacket.pts : avPacket.dts;
+	    avCodecContext->skip_frame =
+		isBeforeSeekTarget(timestamp) ? std::max(AVDISCARD_NONREF, getSkipFrame()) : getSkipFrame();
+	}
+
 	int frameFinished;
 	int ret = avcodec_decode_video2(avCodecContext, avFrame, &frameFinished, &avPacket);
 
@@ -478,36 +835,20 @@ void VideoDecoder::decode()
 
 	    if (frameFinished)
 	    {
-		int64_t int_pts = av_frame_get_best_effort_timestamp(avFrame);
+		processFrame();
 
-		if (int_pts != AV_NOPTS_VALUE)
+		if (!avFrameIsFree)
 		{
-		    pts = int_pts;
-		    pts *= av_q2d(avStream->time_base);
-		    avFrameIsFree = false;
-
-		    {
-			static double lastPts = 0;
-
-			TRACE_INFO( << "VDEC: pts=" << std::fixed << std::setprecision(3) << pts
-				    << "(" << pts - lastPts << ")"
-				    << ", pts=" << avFrame->pts
-				    << ", dts=" << avPacket.dts
-				    << ", time_base=" << avStream->time_base
-				    << ", frameFinished=" << frameFinished );
-
-			lastPts = pts;
-		    }
-
-		    queue();
-
-		    if (!avFrameIsFree)
-		    {
-			// Call queue() again when a frame is available.
-			return;
-		    }
+		    // Call queue() again when a frame is available.
+		    return;
 		}
 	    }
+	    else if (avCodecContext->skip_frame > AVDISCARD_DEFAULT &&
+		     seekTarget < 0 && !trickPlay)
+	    {
+		m_numDiscardedPackets++;
+		m_totalDiscardedPackets.fetch_add(1, std::memory_order_relaxed);
+	    }
 	}
 	else if (ret == 0)
 	{
@@ -525,6 +866,17 @@ void VideoDecoder::decode()
 
     if (eos && avFrameIsFree && packetQueue.empty())
     {
+	// With frame threading the decoder returns each frame up to
+	// thread_count - 1 packets later. Get the remaining frames:
+	while (decodeDelayedFrame())
+	{
+	    if (!avFrameIsFree)
+	    {
+		// Call queue() again when a frame is available.
+		return;
+	    }
+	}
+
 	// Decoded everything in this stream.
 
 	// Forward event via Deinterlacer to VideoOutput:
@@ -535,6 +887,235 @@ void VideoDecoder::decode()
 
 }
 
+bool VideoDecoder::decodeDelayedFrame()
+{
+    // Returns true if a frame was delayed by the decoder. The frame is
+    // passed to processFrame, which may drop it.
+    AVPacket emptyPacket;
+    av_init_packet(&emptyPacket);
+    emptyPacket.data = 0;
+    emptyPacket.size = 0;
+
+    int frameFinished = 0;
+    int ret = avcodec_decode_video2(avCodecContext, avFrame, &frameFinished, &emptyPacket);
+    if (ret < 0 || !frameFinished)
+    {
+	return false;
+    }
+
+    processFrame();
+    return true;
+}
+
+void VideoDecoder::processFrame()
+{
+    int64_t int_pts = av_frame_get_best_effort_timestamp(avFrame);
+
+    if (int_pts != AV_NOPTS_VALUE && seekTarget >= 0)
+    {
+	if (isBeforeSeekTarget(int_pts))
+	{
+	    // Neither converted nor shown:
+	    numSkippedFrames++;
+	    m_totalSkippedFrames.fetch_add(1, std::memory_order_relaxed);
+	    av_frame_unref(avFrame);
+	    return;
+	}
+	finishSeek();
+    }
+
+    if (int_pts != AV_NOPTS_VALUE)
+    {
+	pts = int_pts;
+	pts *= av_q2d(avStream->time_base);
+	avFrameIsFree = false;
+
+	// With frame threading avPacket is not the packet of this frame:
+	TRACE_RECORD("decoded frame: pts, dts", pts, avFrame->pkt_dts);
+
+	{
+	    static double lastPts = 0;
+
+	    TRACE_INFO( << "VDEC: pts=" << std::fixed << std::setprecision(3) << pts
+			<< "(" << pts - lastPts << ")"
+			<< ", pts=" << avFrame->pts
+			<< ", dts=" << avFrame->pkt_dts
+			<< ", time_base=" << avStream->time_base );
+
+	    lastPts = pts;
+	}
+
+	if (isLate())
+	{
+	    // It would be shown late anyway:
+	    TRACE_DEBUG(<< "dropping late frame");
+	    m_numDroppedFrames++;
+	    m_totalDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+	    m_droppedInRow++;
+	    av_frame_unref(avFrame);
+	    avFrameIsFree = true;
+	    return;
+	}
+	m_droppedInRow = 0;
+
+	queue();
+    }
+    else
+    {
+	av_frame_unref(avFrame);
+    }
+}
+
+bool VideoDecoder::isBeforeSeekTarget(int64_t timestamp)
+{
+    if (timestamp == int64_t(AV_NOPTS_VALUE))
+    {
+	return false;
+    }
+
+    // The frame at the seek target may have a slightly smaller timestamp:
+    double tolerance = 0;
+    if (avStream->r_frame_rate.num > 0 && avStream->r_frame_rate.den > 0)
+    {
+	tolerance = av_q2d(av_inv_q(avStream->r_frame_rate)) / 2;
+    }
+
+    return timestamp * av_q2d(avStream->time_base) < seekTarget - tolerance;
+}
+
+void VideoDecoder::finishSeek()
+{
+    avCodecContext->skip_frame = getSkipFrame();
+    seekTarget = -1;
+
+    TRACE_INFO(<< "accurate seek: skipped " << numSkippedFrames << " frames in "
+	       << getSeconds(timer::get_current_time() - seekStart) * 1000 << " ms");
+}
+
+// -------------------------------------------------------------------
+// Frame dropping
+
+struct DiscardLevel
+{
+    AVDiscard skipLoopFilter;
+    AVDiscard skipFrame;
+};
+
+// Ordered by the visible degradation. Frames discarded with BIDIR and
+// NONKEY may still be references of other frames, which then show
+// artefacts:
+static const DiscardLevel discardLevels[] =
+{
+    {AVDISCARD_DEFAULT, AVDISCARD_DEFAULT},
+    {AVDISCARD_NONREF,  AVDISCARD_DEFAULT},
+    {AVDISCARD_BIDIR,   AVDISCARD_NONREF},
+    {AVDISCARD_ALL,     AVDISCARD_BIDIR},
+    {AVDISCARD_ALL,     AVDISCARD_NONKEY}
+};
+static const int numDiscardLevels = sizeof(discardLevels) / sizeof(discardLevels[0]);
+
+// Lateness is smoothed over about 10 frames:
+static const double latenessSmoothing = 0.1;
+// The discard level is increased if frames are shown later than this:
+static const double maxLateness = 0.040;
+// and decreased if they are shown in time for relaxTime:
+static const double minLateness = 0.010;
+// Seconds between two changes. Relaxing is slower to avoid oscillation:
+static const double escalateTime = 1.0;
+static const double relaxTime = 5.0;
+// The audio clock is not extrapolated longer, e.g. when paused:
+static const double maxClockAge = 0.5;
+// Some frames are shown, even if all of them are late:
+static const int maxDroppedInRow = 5;
+
+void VideoDecoder::process(boost::shared_ptr<VideoLateness> event)
+{
+    if (state != Opened)
+    {
+	return;
+    }
+
+    m_clockValid = true;
+    m_clockPTS = event->pts + event->lateness;
+    m_clockTime = event->abstime;
+
+    m_lateness += latenessSmoothing * (event->lateness - m_lateness);
+
+    timespec_t currentTime = timer::get_current_time();
+    if (m_lateness >= minLateness)
+    {
+	m_lastLateTime = currentTime;
+    }
+
+    double levelTime = getSeconds(currentTime - m_discardLevelTime);
+    if (m_lateness > maxLateness &&
+	levelTime > escalateTime &&
+	m_discardLevel < numDiscardLevels - 1)
+    {
+	setDiscardLevel(m_discardLevel + 1);
+    }
+    else if (m_discardLevel > 0 &&
+	     levelTime > relaxTime &&
+	     getSeconds(currentTime - m_lastLateTime) > relaxTime)
+    {
+	setDiscardLevel(m_discardLevel - 1);
+    }
+}
+
+AVDiscard VideoDecoder::getSkipFrame()
+{
+    return discardLevels[m_discardLevel].skipFrame;
+}
+
+void VideoDecoder::setDiscardLevel(int level)
+{
+    TRACE_INFO(<< "discard level " << m_discardLevel << " -> " << level
+	       << ", lateness = " << m_lateness
+	       << ", dropped " << m_numDroppedFrames << " frames"
+	       << ", discarded " << m_numDiscardedPackets << " packets");
+
+    m_discardLevel = level;
+    m_currentDiscardLevel.store(level, std::memory_order_relaxed);
+    m_maxDiscardLevel = std::max(m_maxDiscardLevel, level);
+    m_discardLevelTime = timer::get_current_time();
+
+    avCodecContext->skip_loop_filter = discardLevels[level].skipLoopFilter;
+    if (seekTarget < 0 && !trickPlay)
+    {
+	avCodecContext->skip_frame = discardLevels[level].skipFrame;
+    }
+}
+
+bool VideoDecoder::isLate()
+{
+    if (!m_clockValid || trickPlay || m_droppedInRow >= maxDroppedInRow)
+    {
+	return false;
+    }
+
+    double clockAge = getSeconds(timer::get_current_time() - m_clockTime);
+    if (clockAge > maxClockAge)
+    {
+	return false;
+    }
+
+    return pts < m_clockPTS + clockAge;
+}
+
+void VideoDecoder::resetFrameDropping()
+{
+    // A new stream may be decoded much faster or slower:
+    m_discardLevel = 0;
+    m_maxDiscardLevel = 0;
+    m_discardLevelTime = timer::get_current_time();
+    m_lastLateTime = m_discardLevelTime;
+    m_lateness = 0;
+    m_clockValid = false;
+    m_droppedInRow = 0;
+    m_numDroppedFrames = 0;
+    m_numDiscardedPackets = 0;
+}
+
 void VideoDecoder::queue()
 {
     if (avFrameIsFree)
@@ -544,15 +1125,62 @@ void VideoDecoder::queue()
 	return;
     }
 
-    if (frameQueue.empty())
+    if (m_converting)
+    {
+	// Frames are queued in order. Continue when VideoFrameConverted
+	// is received.
+	TRACE_DEBUG(<< "conversion of previous frame not yet finished");
+	return;
+    }
+
+    if (!avFrame->interlaced_frame && !m_referencedImages.empty())
+    {
+	// The frame may be decoded directly into an image of frameQueue,
+	// which is found by its Y plane. If the decoder returns a frame
+	// twice, the image is already queued and the frame is copied below.
+	for (frame_queue_type::iterator it = frameQueue.begin(); it != frameQueue.end(); it++)
+	{
+	    XvImage* yuvImage = (*it)->xvImage();
+	    if ((char*)avFrame->data[0] == yuvImage->data + yuvImage->offsets[0] &&
+		isReferenced(it->get()))
+	    {
+		std::unique_ptr<XFVideoImage> xfVideoImage(std::move(*it));
+		frameQueue.erase(it);
+
+		xfVideoImage->setPTS(pts);
+
+#ifdef STORE_DECODER_OUTPUT_ENABLED
+		JpegWriter::write("video", pts, avFrame);
+#endif
+
+		TRACE_DEBUG(<< "Queueing XFVideoImage, direct rendering");
+		videoOutput->queue_event(std::move(xfVideoImage));
+
+		av_frame_unref(avFrame);
+		avFrameIsFree = true;
+		return;
+	    }
+	}
+    }
+
+    frame_queue_type::iterator it = findFreeImage(frameQueue.begin());
+    if (it == frameQueue.end())
     {
 	TRACE_DEBUG(<< "no frames available");
+
+	if (!frameQueue.empty() && !m_imageRequested)
+	{
+	    // All images are referenced by FFmpeg. VideoOutput may not
+	    // return another one before it receives this frame:
+	    videoOutput->queue_event(boost::make_shared<CreateVideoImageReq>());
+	    m_imageRequested = true;
+	}
 	return;
     }
 
     if (avFrame->interlaced_frame)
     {
-	if (frameQueue.size() < 2)
+	if (findFreeImage(std::next(it)) == frameQueue.end())
 	{
 	    return;
 	}
@@ -567,8 +1195,8 @@ void VideoDecoder::queue()
 	}
     }
 
-    std::unique_ptr<XFVideoImage> xfVideoImage(std::move(frameQueue.front()));
-    frameQueue.pop();
+    std::unique_ptr<XFVideoImage> xfVideoImage(std::move(*it));
+    frameQueue.erase(it);
 
     TRACE_DEBUG( << "interlaced_frame = " << avFrame->interlaced_frame
 		 << ", top_field_first = " << avFrame->top_field_first);
@@ -618,15 +1246,6 @@ void VideoDecoder::queue()
 	return;
     }
 
-    // Convert image into YUV format:
-    sws_scale(swsContext,
-	      avFrame->data,            // srcSlice:  Array with pointers to planes
-	      avFrame->linesize,        // srcStride: Array with strides of each plane
-	      0,                        // srcSliceY: position
-	      avCodecContext->height,   // srcSliceH: height of the source slice
-	      avPicture.data,                // dstSlice:  Array with pointers to planes
-	      avPicture.linesize);           // dstStride: Array with strides of each plane
-
     xfVideoImage->setPTS(pts);
 
 #ifdef STORE_DECODER_OUTPUT_ENABLED
@@ -636,7 +1255,72 @@ void VideoDecoder::queue()
 
     if (avFrame->interlaced_frame && yuvImage->id == GUID_YUY2_PACKED)
     {
-	bool tff = avFrame->top_field_first ? true : false;
+	// The deinterlacer needs two frames:
+	frame_queue_type::iterator it2 = findFreeImage(frameQueue.begin());
+	m_convertedImage2 = std::move(*it2);
+	frameQueue.erase(it2);
+    }
+    m_convertedImage = std::move(xfVideoImage);
+
+    // Convert image into YUV format. The next frame is decoded
+    // meanwhile, the decoder keeps the referenced frame unchanged:
+    av_frame_move_ref(m_convertedFrame, avFrame);
+    avFrameIsFree = true;
+    m_converting = true;
+    m_conversionId++;
+    m_scaler.start(m_convertedFrame->data,   // Source planes
+		   m_convertedFrame->linesize,
+		   avPicture.data,               // Destination planes
+		   avPicture.linesize,
+		   m_convertedFrame->interlaced_frame,
+		   boost::bind(&VideoDecoder::sendVideoFrameConverted, this, m_conversionId));
+}
+
+void VideoDecoder::sendVideoFrameConverted(int conversionId)
+{
+    // Called by a BandScaler thread:
+    queue_event(make_pooled_event<VideoFrameConverted>(conversionId));
+}
+
+void VideoDecoder::process(boost::shared_ptr<VideoFrameConverted> event)
+{
+    if (m_converting && event->conversionId == m_conversionId)
+    {
+	TRACE_DEBUG();
+
+	finishConversion(true);
+
+	if (state == Opened)
+	{
+	    queue();
+	    decode();
+	}
+    }
+}
+
+void VideoDecoder::finishConversion(bool forward)
+{
+    m_scaler.wait();
+    m_converting = false;
+
+    std::unique_ptr<XFVideoImage> xfVideoImage(std::move(m_convertedImage));
+    std::unique_ptr<XFVideoImage> xfVideoImage2(std::move(m_convertedImage2));
+    bool tff = m_convertedFrame->top_field_first ? true : false;
+    av_frame_unref(m_convertedFrame);
+
+    if (!forward)
+    {
+	// Not shown, e.g. when flushing:
+	frameQueue.push_back(std::move(xfVideoImage));
+	if (xfVideoImage2)
+	{
+	    frameQueue.push_back(std::move(xfVideoImage2));
+	}
+	return;
+    }
+
+    if (xfVideoImage2)
+    {
 	if (m_topFieldFirst != tff)
 	{
 	    // Deinterlacer needs an update.
@@ -655,10 +1339,6 @@ void VideoDecoder::queue()
 	// The deinterlacer needs two frames.
 	TRACE_DEBUG(<< "Queueing XFVideoImage");
 	deinterlacer->queue_event(std::move(xfVideoImage));
-
-	std::unique_ptr<XFVideoImage> xfVideoImage2(std::move(frameQueue.front()));
-	frameQueue.pop();
-
 	deinterlacer->queue_event(std::move(xfVideoImage2));
     }
     else
@@ -666,8 +1346,6 @@ void VideoDecoder::queue()
 	TRACE_DEBUG(<< "Queueing XFVideoImage");
 	videoOutput->queue_event(std::move(xfVideoImage));
     }
-
-    avFrameIsFree = true;
 }
 
 void VideoDecoder::setFourccFormat(int fourccFormat)
@@ -684,17 +1362,19 @@ void VideoDecoder::setFourccFormat(int fourccFormat)
 
 void VideoDecoder::getSwsContext()
 {
-    if (swsContext)
+    if (m_converting)
     {
-	sws_freeContext(swsContext);
+	// Converted with the old settings:
+	finishConversion(true);
     }
+    m_scaler.reset();
 
     // Throw away all queued frames:
     while(!frameQueue.empty())
     {
 	std::unique_ptr<XFVideoImage> xfVideoImage(std::move(frameQueue.front()));
-	frameQueue.pop();
-	videoOutput->queue_event(std::unique_ptr<DeleteXFVideoImage>(new DeleteXFVideoImage(std::move(xfVideoImage))));
+	frameQueue.pop_front();
+	deleteImage(std::move(xfVideoImage));
 
 	requestNewFrame();
     }
@@ -711,21 +1391,17 @@ void VideoDecoder::getSwsContext()
     int srcWidth = avCodecContext->width;
     int srcHeight = avCodecContext->height;
 
+    // swscale detects the CPU capabilities itself. Same size conversions
+    // from YUV420P don't use it at all, see BandScaler:
     int flags =
 	SWS_BICUBIC |
-	SWS_CPU_CAPS_MMX | SWS_CPU_CAPS_MMX2 | // SWS_CPU_CAPS_3DNOW |
 	SWS_PRINT_INFO;
 
-    swsContext = sws_getContext(srcWidth, srcHeight,      // Source Size
-				avCodecContext->pix_fmt,  // Source Format
-				m_dstWidth, m_dstHeight,  // Destination Size
-				dstPixFmt,                // Destination Format
-				flags,                    // Flags
-				NULL, NULL, NULL);        // SwsFilter*
-    if (!swsContext)
-    {
-	TRACE_THROW(std::string, << "sws_getContext failed");
-    }
+    m_scaler.init(srcWidth, srcHeight,      // Source Size
+		  avCodecContext->pix_fmt,  // Source Format
+		  m_dstWidth, m_dstHeight,  // Destination Size
+		  dstPixFmt,                // Destination Format
+		  flags);                   // Flags
 }
 
 void VideoDecoder::requestNewFrame()
@@ -737,7 +1413,10 @@ void VideoDecoder::requestNewFrame()
     int pd = par.den;
     if (pn == 0 || pd == 0) {pn = pd = 1;}
 
-    videoOutput->queue_event(boost::make_shared<ResizeVideoOutputReq>(w,h,pn,pd,m_fourccFormat));
+    int iw, ih;
+    getImageSize(iw, ih);
+
+    videoOutput->queue_event(boost::make_shared<ResizeVideoOutputReq>(w,h,pn,pd,m_fourccFormat,iw,ih));
 }
 
 // -------------------------------------------------------------------
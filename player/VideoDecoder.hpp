@@ -22,16 +22,23 @@
 #ifndef VIDEO_DECODER_HPP
 #define VIDEO_DECODER_HPP
 
+#include "player/BandScaler.hpp"
 #include "player/GeneralEvents.hpp"
 #include "platform/event_receiver.hpp"
 
 #include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <list>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
 
 class XFVideoImage;
 
-class VideoDecoder : public event_receiver<VideoDecoder>
+class VideoDecoder : public event_receiver<VideoDecoder, player_queue_t>
 {
-    friend class event_processor<>;
+    friend class event_processor<player_queue_t>;
 
     enum state_t {
 	Closed,
@@ -55,25 +62,82 @@ class VideoDecoder : public event_receiver<VideoDecoder>
     bool avFrameIsFree;
     double pts;
 
+    // Accurate seek: Frames before seekTarget are decoded but dropped.
+    double seekTarget;  // seconds, negative if not seeking
+    timespec_t seekStart;
+    int numSkippedFrames;
+
+    // Trick play: Each key frame is decoded on its own, see FlushReq:
+    bool trickPlay;
+    bool trickPlayDrained;
+
     int m_fourccFormat;
     int m_dstWidth;   // size of images in frameQueue
     int m_dstHeight;
-    std::queue<std::unique_ptr<XFVideoImage> > frameQueue;
+    typedef std::list<std::unique_ptr<XFVideoImage> > frame_queue_type;
+    frame_queue_type frameQueue;
+
+    // Direct rendering: For YUV420P the decoder decodes directly into
+    // the XvImages of frameQueue, see getBuffer. An image is referenced
+    // by FFmpeg until DirectRenderingBufferReleased is received, e.g. as
+    // long as it is a reference frame. Meanwhile it may be displayed,
+    // but must not be overwritten or deleted.
+    bool m_directRendering;
+    std::set<char*> m_referencedImages;  // XFVideoImage::data()
+    std::list<std::unique_ptr<XFVideoImage> > m_deletedImages;
+    bool m_imageRequested;
 
     std::queue<boost::shared_ptr<VideoPacketEvent> > packetQueue;
 
     bool eos;
 
-    struct SwsContext* swsContext;
+    // Frames are converted by the BandScaler threads, while the next
+    // frame is decoded. Only one frame is converted at a time:
+    BandScaler m_scaler;
+    AVFrame* m_convertedFrame;
+    std::unique_ptr<XFVideoImage> m_convertedImage;
+    std::unique_ptr<XFVideoImage> m_convertedImage2;  // for the Deinterlacer
+    bool m_converting;
+    int m_conversionId;
 
     bool m_topFieldFirst;
 
     bool m_useOptimumImageFormat;
 
+    // Decoder threading, see SetDecoderThreading:
+    int m_decoderThreads;
+    std::map<std::string, int> m_threadTypes;  // codec name -> FF_THREAD_*
+
+    // Frame dropping: If the VideoOutput shows frames late, the decoder
+    // skips more work with each discard level, and relaxes again when
+    // frames are shown in time. Frames, that are already late when they
+    // are decoded, are dropped before conversion. See VideoLateness.
+    int m_discardLevel;
+    double m_lateness;          // smoothed, seconds
+    timespec_t m_discardLevelTime;
+    bool m_clockValid;
+    double m_clockPTS;          // audio clock at m_clockTime
+    timespec_t m_clockTime;
+    timespec_t m_lastLateTime;
+    int m_droppedInRow;
+    int m_numDroppedFrames;     // not converted
+    int m_numDiscardedPackets;  // decoded without picture
+    int m_maxDiscardLevel;
+
+    // Totals of all streams. Read by another thread, see dumpStatistics:
+    std::atomic<int> m_totalDroppedFrames;
+    std::atomic<int> m_totalDiscardedPackets;
+    std::atomic<int> m_totalSkippedFrames;
+    std::atomic<int> m_currentDiscardLevel;
+
 public:
     VideoDecoder(event_processor_ptr_type evt_proc);
     ~VideoDecoder();
 
+    // Frame dropping and accurate seek counters, see
+    // MediaPlayer::dumpStatistics. May be called by any thread:
+    void dumpStatistics(std::ostream& strm);
+
 private:
     MediaPlayer* mediaPlayer;
     boost::shared_ptr<Demuxer> demuxer;
@@ -92,9 +156,34 @@ private:
     void process(boost::shared_ptr<EndOfVideoStream> event);
     void process(boost::shared_ptr<EnableOptimalPixelFormat> event);
     void process(boost::shared_ptr<DisableOptimalPixelFormat> event);
+    void process(boost::shared_ptr<SetDecoderThreading> event);
+    void process(boost::shared_ptr<DirectRenderingBufferReleased> event);
+    void process(boost::shared_ptr<VideoFrameConverted> event);
+    void process(boost::shared_ptr<VideoLateness> event);
 
     void decode();
+    bool decodeDelayedFrame();
     void queue();
+    void sendVideoFrameConverted(int conversionId);
+    void finishConversion(bool forward);
+
+    void processFrame();
+    bool isBeforeSeekTarget(int64_t timestamp);
+    void finishSeek();
+    AVDiscard getSkipFrame();
+    void setDiscardLevel(int level);
+    bool isLate();
+    void resetFrameDropping();
+
+    void setupThreading();
+
+    static int getBuffer2(AVCodecContext* avCodecContext, AVFrame* frame, int flags);
+    static void releaseBuffer(void* opaque, uint8_t* data);
+    int getBuffer(AVFrame* frame, int flags);
+    void getImageSize(int& width, int& height);
+    bool isReferenced(XFVideoImage* xfVideoImage);
+    frame_queue_type::iterator findFreeImage(frame_queue_type::iterator it);
+    void deleteImage(std::unique_ptr<XFVideoImage> xfVideoImage);
 
     void setFourccFormat(int fourccFormat);
     void getSwsContext();
@@ -0,0 +1,90 @@
+//
+// Video Image Pool
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "player/VideoImagePool.hpp"
+#include "player/XlibFacade.hpp"
+#include "platform/Logging.hpp"
+
+VideoImagePool::VideoImagePool(int maxBytes)
+    : maxBytes(maxBytes),
+      bytes(0),
+      numCreated(0),
+      numReused(0)
+{
+}
+
+VideoImagePool::~VideoImagePool()
+{
+    TRACE_DEBUG(<< "created " << numCreated << ", reused " << numReused);
+}
+
+VideoImagePool::list_type::iterator VideoImagePool::find(boost::shared_ptr<XFVideo> xfVideo)
+{
+    list_type::iterator it = images.begin();
+    while (it != images.end() && !(*it)->fits(xfVideo.get()))
+    {
+	it++;
+    }
+    return it;
+}
+
+bool VideoImagePool::contains(boost::shared_ptr<XFVideo> xfVideo)
+{
+    return find(xfVideo) != images.end();
+}
+
+std::unique_ptr<XFVideoImage> VideoImagePool::get(boost::shared_ptr<XFVideo> xfVideo)
+{
+    list_type::iterator it = find(xfVideo);
+    if (it == images.end())
+    {
+	numCreated++;
+	return std::unique_ptr<XFVideoImage>(new XFVideoImage(xfVideo));
+    }
+
+    std::unique_ptr<XFVideoImage> image(std::move(*it));
+    images.erase(it);
+    bytes -= image->dataSize();
+    numReused++;
+
+    image->reuse(xfVideo.get());
+    return image;
+}
+
+void VideoImagePool::put(std::unique_ptr<XFVideoImage> image)
+{
+    bytes += image->dataSize();
+    images.push_front(std::move(image));
+
+    while (bytes > maxBytes)
+    {
+	// Deletes the XvImage and its shared memory:
+	bytes -= images.back()->dataSize();
+	images.pop_back();
+    }
+}
+
+void VideoImagePool::clear()
+{
+    images.clear();
+    bytes = 0;
+}
@@ -0,0 +1,75 @@
+//
+// Video Image Pool
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef VIDEO_IMAGE_POOL_HPP
+#define VIDEO_IMAGE_POOL_HPP
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <list>
+#include <memory>
+
+class XFVideo;
+class XFVideoImage;
+
+// Keeps unused XFVideoImages for reuse. Creating an image needs several
+// round trips to the X server and a new shared memory segment. Images
+// are returned when the video size or the image format changes, e.g. if
+// the VideoDecoder switches to YUY2 for interlaced frames. Switching
+// back, or opening the next file with the same size, then takes images
+// from the pool.
+//
+// Kept images are deleted, least recently used first, if their shared
+// memory exceeds maxBytes. Images in use are not counted.
+//
+// Like XFVideoImage, the pool may only be used by the VideoOutput thread.
+
+class VideoImagePool : private boost::noncopyable
+{
+public:
+    explicit VideoImagePool(int maxBytes);
+    ~VideoImagePool();
+
+    // Returns an image of the size and format xfVideo currently creates:
+    std::unique_ptr<XFVideoImage> get(boost::shared_ptr<XFVideo> xfVideo);
+    void put(std::unique_ptr<XFVideoImage> image);
+
+    // True if get can return a kept image:
+    bool contains(boost::shared_ptr<XFVideo> xfVideo);
+
+    void clear();
+
+private:
+    typedef std::list<std::unique_ptr<XFVideoImage> > list_type;
+
+    list_type::iterator find(boost::shared_ptr<XFVideo> xfVideo);
+
+    int maxBytes;
+    int bytes;
+    // Most recently returned image first:
+    list_type images;
+
+    int numCreated;
+    int numReused;
+};
+
+#endif
@@ -25,17 +25,28 @@
 #include "player/MediaPlayer.hpp"
 #include "player/Demuxer.hpp"
 #include "player/XlibFacade.hpp"
+#include "platform/event_pool.hpp"
 
 #include <boost/make_shared.hpp>
 #include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
 #include <sys/types.h>
 
 using namespace std;
 
 int tidVideoOutput = 0;
 
+// Number of images created for the VideoDecoder when the output is opened:
+static const int numVideoImages = 10;
+// Of these the first are created immediately, the others one per event:
+static const int numImmediateVideoImages = 2;
+// Shared memory of unused images kept for reuse, see VideoImagePool:
+static const int maxPoolBytes = 64 * 1024 * 1024;
+
 VideoOutput::VideoOutput(event_processor_ptr_type evt_proc)
     : base_type(evt_proc),
+      imagePool(maxPoolBytes),
       eos(false),
       state(IDLE),
       audioSync(false),
@@ -43,7 +54,8 @@ VideoOutput::VideoOutput(event_processor_ptr_type evt_proc)
       ignoreAudioSync(0),
       videoStreamOnly(false),
       lastNotifiedTime(-1),
-      displayedFramePTS(0)
+      displayedFramePTS(0),
+      trickPlaySpeed(0)
 {
     TRACE_DEBUG(<< "tid = " << gettid());
 
@@ -79,10 +91,20 @@ void VideoOutput::process(boost::shared_ptr<OpenVideoOutputReq> event)
     {
 	TRACE_DEBUG();
 
-	xfVideo->resize(event->width, event->height, event->parNum, event->parDen, event->fourccFormat);
-	for (int i=0; i<10; i++)
+	xfVideo->resize(event->width, event->height, event->parNum, event->parDen, event->fourccFormat,
+			event->imageWidth, event->imageHeight);
+	for (int i=0; i<numVideoImages; i++)
 	{
-	    createVideoImage();
+	    if (i < numImmediateVideoImages || imagePool.contains(xfVideo))
+	    {
+		createVideoImage();
+	    }
+	    else
+	    {
+		// Creating an image needs several round trips to the X
+		// server. Meanwhile the GUI thread shows the first frames:
+		queue_event(boost::make_shared<CreateVideoImageReq>());
+	    }
 	}
 
 	state = OPEN;
@@ -91,17 +113,24 @@ void VideoOutput::process(boost::shared_ptr<OpenVideoOutputReq> event)
     }
 }
 
-void VideoOutput::process(boost::shared_ptr<CloseVideoOutputReq>)
+void VideoOutput::process(boost::shared_ptr<CloseVideoOutputReq> event)
 {
     if (isOpen())
     {
 	TRACE_DEBUG();
 
-	showBlackFrame();
+	if (!event->keepOutput)
+	{
+	    showBlackFrame();
+	}
+	// Otherwise the last frame is shown until the first frame of
+	// the next file is available.
 
-	// Throw away all queued frames:
+	// Throw away all queued frames. The images are kept for the
+	// next file:
 	while ( !frameQueue.empty() )
 	{
+	    imagePool.put(std::move(frameQueue.front()));
 	    frameQueue.pop_front();
 	}
 
@@ -110,6 +139,7 @@ void VideoOutput::process(boost::shared_ptr<CloseVideoOutputReq>)
 	lastNotifiedTime = -1;
 	displayedFramePTS = 0;
 	ignoreAudioSync = 0;
+	trickPlaySpeed = 0;
 
 	audioSyncInfo.reset();
 
@@ -132,13 +162,36 @@ void VideoOutput::process(boost::shared_ptr<ResizeVideoOutputReq> event)
     {
 	TRACE_DEBUG();
 
-	xfVideo->resize(event->width, event->height, event->parNum, event->parDen, event->fourccFormat);
+	xfVideo->resize(event->width, event->height, event->parNum, event->parDen, event->fourccFormat,
+			event->imageWidth, event->imageHeight);
+	createVideoImage();
+    }
+}
+
+void VideoOutput::process(boost::shared_ptr<CreateVideoImageReq>)
+{
+    // VideoDecoder sends this event if all its images are still
+    // referenced by FFmpeg for direct rendering. VideoOutput sends
+    // it to itself when opened.
+
+    if (isOpen())
+    {
+	TRACE_DEBUG();
+
 	createVideoImage();
     }
 }
 
 void VideoOutput::process(std::unique_ptr<XFVideoImage> event)
 {
+    if (isOpen() && overtaken_by<FlushReq>())
+    {
+	// Frame was sent before the FlushReq. Send it back to
+	// VideoDecoder without showing it:
+	videoDecoder->queue_event(std::move(event));
+	return;
+    }
+
     if (isOpen())
     {
 	TRACE_DEBUG();
@@ -170,13 +223,18 @@ void VideoOutput::process(std::unique_ptr<XFVideoImage> event)
     }
 }
 
-void VideoOutput::process(std::unique_ptr<DeleteXFVideoImage>)
+void VideoOutput::process(std::unique_ptr<DeleteXFVideoImage> event)
 {
     // This class is running in the GUI thread. Here it is safe to delete
-    // X11 resources. The XvImage contained in the XFVideoImage object
-    // is deleted by not storing the shared_ptr.
+    // X11 resources. The image is kept by the pool, which deletes it
+    // when its memory is needed for other images.
 
     TRACE_DEBUG(<< "tid = " << gettid());
+
+    if (event->image)
+    {
+	imagePool.put(std::move(event->image));
+    }
 }
 
 void VideoOutput::process(boost::shared_ptr<ShowNextFrame>)
@@ -221,12 +279,14 @@ void VideoOutput::process(boost::shared_ptr<AudioSyncInfo> event)
     }
 }
 
-void VideoOutput::process(boost::shared_ptr<FlushReq>)
+void VideoOutput::process(boost::shared_ptr<FlushReq> event)
 {
     if (isOpen())
     {
 	TRACE_DEBUG();
 
+	trickPlaySpeed = event->trickPlaySpeed;
+
 	// Send received frames back to VideoDecoder without showing them:
 	while (!frameQueue.empty())
 	{
@@ -273,6 +333,12 @@ void VideoOutput::process(boost::shared_ptr<SeekRelativeReq> event)
     demuxer->queue_event(event);
 }
 
+void VideoOutput::process(boost::shared_ptr<TrickPlayReq> event)
+{
+    event->displayedFramePTS = displayedFramePTS;
+    demuxer->queue_event(event);
+}
+
 void VideoOutput::process(boost::shared_ptr<EndOfVideoStream>)
 {
     if (isOpen())
@@ -413,7 +479,7 @@ void VideoOutput::process(boost::shared_ptr<CommandPause>)
 
 void VideoOutput::createVideoImage()
 {
-    videoDecoder->queue_event(std::unique_ptr<XFVideoImage>(new XFVideoImage(xfVideo)));
+    videoDecoder->queue_event(imagePool.get(xfVideo));
 }
 
 void VideoOutput::displayNextFrame()
@@ -456,6 +522,16 @@ void VideoOutput::displayNextFrame()
 	{
 	    videoDecoder->queue_event(std::move(previousImage));
 	}
+
+	if (audioSync && trickPlaySpeed == 0)
+	{
+	    // The VideoDecoder skips work if frames are shown late:
+	    timespec_t currentTime = frameTimer.get_current_time();
+	    double currentAudioPTS = audioSnapshotPTS + getSeconds(currentTime - audioSnapshotTime);
+	    videoDecoder->queue_event(make_pooled_event<VideoLateness>(displayedFramePTS,
+								      currentAudioPTS - displayedFramePTS,
+								      currentTime));
+	}
     }
 
     startFrameTimer();
@@ -493,6 +569,21 @@ void VideoOutput::startFrameTimer()
 	return;
     }
 
+    if (trickPlaySpeed != 0)
+    {
+	// No audio is played. Show the key frames with the distance of
+	// their PTS divided by the speed, but at least one per second:
+	double nextFrameVideoPTS = frameQueue.front()->getPTS();
+	double delay = std::min(std::abs(nextFrameVideoPTS - displayedFramePTS) / std::abs(trickPlaySpeed),
+				1.0);
+
+	frameTimer.relative(getTimespec(delay));
+	start_timer(boost::make_shared<ShowNextFrame>(), frameTimer);
+
+	state = PLAYING;
+	return;
+    }
+
     if (videoStreamOnly)
     {
 	// No audio stream available
@@ -544,15 +635,19 @@ void VideoOutput::startFrameTimer()
 
 void VideoOutput::showBlackFrame()
 {
-    std::unique_ptr<XFVideoImage> yuvImage(new XFVideoImage(xfVideo));
+    std::unique_ptr<XFVideoImage> yuvImage(imagePool.get(xfVideo));
     yuvImage->createBlackImage();
     // yuvImage->createPatternImage();
     // yuvImage->createDemoImage();
 
-    // Above a new XFVideoImage object was created. Now the XFVideoImage object returned by
-    // the XFVideo::show method is thrown away. This keeps the number of created XFVideoImage
-    // objects at a constant level.
-    xfVideo->show(std::move(yuvImage));
+    // Above an XFVideoImage object was taken from the pool. Now the XFVideoImage object
+    // returned by the XFVideo::show method is given back. This keeps the number of
+    // XFVideoImage objects at a constant level.
+    std::unique_ptr<XFVideoImage> previousImage = xfVideo->show(std::move(yuvImage));
+    if (previousImage)
+    {
+	imagePool.put(std::move(previousImage));
+    }
 }
 
 void VideoOutput::sendNotificationVideoSize(boost::shared_ptr<NotificationVideoSize> event)
@@ -23,6 +23,7 @@
 #define VIDEO_OUTPUT_HPP
 
 #include "player/GeneralEvents.hpp"
+#include "player/VideoImagePool.hpp"
 #include "platform/event_receiver.hpp"
 
 #include <sys/ipc.h>  // to allocate shared memory
@@ -37,10 +38,9 @@ struct ShowNextFrame {};
 class XFVideo;
 class XFVideoImage;
 
-class VideoOutput : public event_receiver<VideoOutput,
-					  concurrent_queue<receive_fct_t, with_callback_function> >
+class VideoOutput : public event_receiver<VideoOutput, player_gui_queue_t>
 {
-    friend class event_processor<concurrent_queue<receive_fct_t, with_callback_function> >;
+    friend class event_processor<player_gui_queue_t>;
 
 public:
     VideoOutput(event_processor_ptr_type evt_proc);
@@ -55,6 +55,8 @@ private:
     timer frameTimer;
 
     boost::shared_ptr<XFVideo> xfVideo;
+    // Deleted before xfVideo:
+    VideoImagePool imagePool;
     std::list<std::unique_ptr<XFVideoImage> > frameQueue;
 
     bool eos;
@@ -87,10 +89,15 @@ private:
     double displayedFramePTS;
     bool firstFrame;
 
+    // Trick play: Frames are shown without audio synchronization with
+    // a rate depending on the speed, see TrickPlayReq:
+    int trickPlaySpeed;
+
     void process(boost::shared_ptr<InitEvent> event);
     void process(boost::shared_ptr<OpenVideoOutputReq> event);
     void process(boost::shared_ptr<CloseVideoOutputReq> event);
     void process(boost::shared_ptr<ResizeVideoOutputReq> event);
+    void process(boost::shared_ptr<CreateVideoImageReq> event);
     void process(  std::unique_ptr<XFVideoImage> event);
     void process(  std::unique_ptr<DeleteXFVideoImage> event);
     void process(boost::shared_ptr<ShowNextFrame> event);
@@ -98,6 +105,7 @@ private:
     void process(boost::shared_ptr<FlushReq> event);
     void process(boost::shared_ptr<AudioFlushedInd> event);
     void process(boost::shared_ptr<SeekRelativeReq> event);
+    void process(boost::shared_ptr<TrickPlayReq> event);
     void process(boost::shared_ptr<EndOfVideoStream> event);		 
     void process(boost::shared_ptr<NoAudioStream> event);		 
     void process(boost::shared_ptr<WindowRealizeEvent> event);
@@ -23,6 +23,7 @@
 #include "player/XlibHelpers.hpp"
 #include "platform/Logging.hpp"
 
+#include <algorithm>
 #include <sys/ipc.h>  // to allocate shared memory
 #include <sys/shm.h>  // to allocate shared memory
 #include <errno.h>
@@ -219,6 +220,8 @@ XFVideo::XFVideo(Display* display, Window window,
       displayedFourccFormat(0),
       widthVid(width),
       heightVid(height),
+      widthImg(width),
+      heightImg(height),
       widthWin(width),
       heightWin(height),
       leftSrc(0),
@@ -610,7 +613,8 @@ bool XFVideo::isFourccFormatValid(int fourccFormat)
 
 void XFVideo::resize(unsigned int width, unsigned int height,
 		     unsigned int parNum, unsigned int parDen,
-		     int fourccFormat)
+		     int fourccFormat,
+		     unsigned int imageWidth, unsigned int imageHeight)
 {
     // This method is called when the video size changes.
     // It is not called when the widget is resized.
@@ -619,6 +623,11 @@ void XFVideo::resize(unsigned int width, unsigned int height,
     widthVid  = width;
     heightVid = height;
 
+    // The VideoDecoder may need bigger images for direct rendering.
+    // Only the video size is displayed:
+    widthImg  = std::max(imageWidth, width);
+    heightImg = std::max(imageHeight, height);
+
     // Display the full image:
     leftSrc = 0;
     topSrc = 0;
@@ -981,17 +990,19 @@ XFVideoImage::XFVideoImage(boost::shared_ptr<XFVideo> xfVideo)
     : pts(0)
 {
     TRACE_DEBUG(<< "tid = " << gettid());
-    init(xfVideo.get(), xfVideo->widthVid, xfVideo->heightVid, xfVideo->fourccFormat);
+    init(xfVideo.get(), xfVideo->widthVid, xfVideo->heightVid, xfVideo->fourccFormat,
+	 xfVideo->widthImg, xfVideo->heightImg);
 }
 
 XFVideoImage::XFVideoImage(XFVideo* xfVideo, int width, int height, int fourccFormat)
     : pts(0)
 {
     TRACE_DEBUG(<< "tid = " << gettid());
-    init(xfVideo, width, height, fourccFormat);
+    init(xfVideo, width, height, fourccFormat, width, height);
 }
 
-void XFVideoImage::init(XFVideo* xfVideo, int width, int height, int fourccFormat)
+void XFVideoImage::init(XFVideo* xfVideo, int width, int height, int fourccFormat,
+			int imageWidth, int imageHeight)
 {
     if (!xfVideo->isFourccFormatValid(fourccFormat))
     {
@@ -1000,12 +1011,14 @@ void XFVideoImage::init(XFVideo* xfVideo, int width, int height, int fourccForma
 
     m_requestedWidth = width;
     m_requestedHeight = height;
+    m_imageWidth = imageWidth;
+    m_imageHeight = imageHeight;
 
     yuvImage = XvShmCreateImage(xfVideo->display(),
 				xfVideo->xvPortId,
 				fourccFormat,
 				0, // char* data
-				width, height,
+				imageWidth, imageHeight,
 				&yuvShmInfo);
 
     if (!yuvImage)
@@ -1013,7 +1026,7 @@ void XFVideoImage::init(XFVideo* xfVideo, int width, int height, int fourccForma
 	TRACE_THROW(std::string, << "XvShmCreateImage failed.");
     }
 
-    TRACE_DEBUG(<< std::dec << "requested: " << width << "*" << height
+    TRACE_DEBUG(<< std::dec << "requested: " << imageWidth << "*" << imageHeight
 		<< " got: " << yuvImage->width << "*" << yuvImage->height);
     TRACE_DEBUG(<< "yuvImage = " << std::hex << uint64_t(yuvImage));
     TRACE_DEBUG(<< "fourccFormat  = " << std::hex << fourccFormat);
@@ -1061,6 +1074,27 @@ void XFVideoImage::init(XFVideo* xfVideo, int width, int height, int fourccForma
     TRACE_DEBUG( "yuvImage data_size = " << std::dec << yuvImage->data_size );
 }
 
+bool XFVideoImage::fits(XFVideo* xfVideo)
+{
+    return m_display == xfVideo->display() &&
+	yuvImage->id == xfVideo->fourccFormat &&
+	m_imageWidth == int(xfVideo->widthImg) &&
+	m_imageHeight == int(xfVideo->heightImg);
+}
+
+void XFVideoImage::reuse(XFVideo* xfVideo)
+{
+    m_requestedWidth = xfVideo->widthVid;
+    m_requestedHeight = xfVideo->heightVid;
+    pts = 0;
+}
+
+bool event_trace_pts<XFVideoImage>::get(const XFVideoImage& image, double& pts)
+{
+    pts = image.getPTS();
+    return true;
+}
+
 XFVideoImage::~XFVideoImage()
 {
     TRACE_DEBUG(<< "tid = " << gettid());
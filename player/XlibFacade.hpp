@@ -129,7 +129,8 @@ public:
     void selectEvents();
     void resize(unsigned int width, unsigned int height,
 		unsigned int sarNom, unsigned int sarDen,
-		int fourccFormat);
+		int fourccFormat,
+		unsigned int imageWidth, unsigned int imageHeight);
     std::unique_ptr<XFVideoImage> show(std::unique_ptr<XFVideoImage> xfVideoImage);
     void show();
     void handleConfigureEvent(boost::shared_ptr<WindowConfigureEvent> event);
@@ -186,6 +187,10 @@ private:
     unsigned int widthVid;
     unsigned int heightVid;
 
+    // size of created images, may be bigger than the video size:
+    unsigned int widthImg;
+    unsigned int heightImg;
+
     // window size:
     unsigned int widthWin;
     unsigned int heightWin;
@@ -242,11 +247,18 @@ public:
     XvImage* xvImage() {return yuvImage;}
 
     void setPTS(double pts_) {pts = pts_;}
-    double getPTS() {return pts;}
+    double getPTS() const {return pts;}
+
+    // See VideoImagePool: An image fits, if its XvImage has the size
+    // and format xfVideo currently creates. reuse takes the video size.
+    bool fits(XFVideo* xfVideo);
+    void reuse(XFVideo* xfVideo);
+    int dataSize() {return yuvImage->data_size;}
 
 private:
     XFVideoImage();  // No implementation.
-    void init(XFVideo* xfVideo, int width, int height, int fourccFormat);
+    void init(XFVideo* xfVideo, int width, int height, int fourccFormat,
+	      int imageWidth, int imageHeight);
 
     XShmSegmentInfo yuvShmInfo;
     XvImage* yuvImage;
@@ -256,6 +268,8 @@ private:
 
     int m_requestedWidth;
     int m_requestedHeight;
+    int m_imageWidth;
+    int m_imageHeight;
 };
 
 #endif
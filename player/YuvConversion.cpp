@@ -0,0 +1,209 @@
+//
+// YUV Conversion
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "player/YuvConversion.hpp"
+
+#include <string.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#define YUV_CONVERSION_X86
+#include <immintrin.h>
+#endif
+
+// Chroma line of a luma line. Chroma lines of an interlaced 4:2:0 frame
+// alternate between the fields like the luma lines.
+static inline int getChromaLine(int line, bool interlaced)
+{
+    return interlaced ? ((line >> 2) << 1) | (line & 1) : line >> 1;
+}
+
+// Converts pixel pairs from x up to width:
+static inline void yuy2LineGeneric(const uint8_t* Y, const uint8_t* U, const uint8_t* V,
+				   uint8_t* dst, int x, int width)
+{
+    for (; x < width; x += 2)
+    {
+	dst[2*x]   = Y[x];
+	dst[2*x+1] = U[x/2];
+	dst[2*x+2] = Y[x+1];
+	dst[2*x+3] = V[x/2];
+    }
+}
+
+static void yuy2Generic(const uint8_t* const src[], const int srcStride[],
+			uint8_t* dst, int dstStride,
+			int width, int firstLine, int lastLine,
+			bool interlaced)
+{
+    for (int line = firstLine; line < lastLine; line++)
+    {
+	int chromaLine = getChromaLine(line, interlaced);
+	yuy2LineGeneric(src[0] + line * srcStride[0],
+			src[1] + chromaLine * srcStride[1],
+			src[2] + chromaLine * srcStride[2],
+			dst + line * dstStride,
+			0, width);
+    }
+}
+
+#ifdef YUV_CONVERSION_X86
+
+// 16 pixels per iteration:
+__attribute__((target("sse2")))
+static void yuy2SSE2(const uint8_t* const src[], const int srcStride[],
+		     uint8_t* dst, int dstStride,
+		     int width, int firstLine, int lastLine,
+		     bool interlaced)
+{
+    for (int line = firstLine; line < lastLine; line++)
+    {
+	int chromaLine = getChromaLine(line, interlaced);
+	const uint8_t* Y = src[0] + line * srcStride[0];
+	const uint8_t* U = src[1] + chromaLine * srcStride[1];
+	const uint8_t* V = src[2] + chromaLine * srcStride[2];
+	uint8_t* D = dst + line * dstStride;
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16)
+	{
+	    __m128i y  = _mm_loadu_si128((const __m128i*)(Y + x));
+	    __m128i u  = _mm_loadl_epi64((const __m128i*)(U + x/2));
+	    __m128i v  = _mm_loadl_epi64((const __m128i*)(V + x/2));
+	    __m128i uv = _mm_unpacklo_epi8(u, v);
+	    _mm_storeu_si128((__m128i*)(D + 2*x),      _mm_unpacklo_epi8(y, uv));
+	    _mm_storeu_si128((__m128i*)(D + 2*x + 16), _mm_unpackhi_epi8(y, uv));
+	}
+	yuy2LineGeneric(Y, U, V, D, x, width);
+    }
+}
+
+// 32 pixels per iteration. The AVX2 unpack instructions work on each
+// 128 bit lane, thus the results are reordered before they are stored.
+__attribute__((target("avx2")))
+static void yuy2AVX2(const uint8_t* const src[], const int srcStride[],
+		     uint8_t* dst, int dstStride,
+		     int width, int firstLine, int lastLine,
+		     bool interlaced)
+{
+    for (int line = firstLine; line < lastLine; line++)
+    {
+	int chromaLine = getChromaLine(line, interlaced);
+	const uint8_t* Y = src[0] + line * srcStride[0];
+	const uint8_t* U = src[1] + chromaLine * srcStride[1];
+	const uint8_t* V = src[2] + chromaLine * srcStride[2];
+	uint8_t* D = dst + line * dstStride;
+
+	int x = 0;
+	for (; x + 32 <= width; x += 32)
+	{
+	    __m256i y = _mm256_loadu_si256((const __m256i*)(Y + x));
+	    __m128i u = _mm_loadu_si128((const __m128i*)(U + x/2));
+	    __m128i v = _mm_loadu_si128((const __m128i*)(V + x/2));
+	    // Lane 0: chroma of pixels 0-15, lane 1: pixels 16-31
+	    __m256i uv = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(u, v)),
+						 _mm_unpackhi_epi8(u, v), 1);
+	    __m256i lo = _mm256_unpacklo_epi8(y, uv);  // pixels 0-7, 16-23
+	    __m256i hi = _mm256_unpackhi_epi8(y, uv);  // pixels 8-15, 24-31
+	    _mm256_storeu_si256((__m256i*)(D + 2*x),      _mm256_permute2x128_si256(lo, hi, 0x20));
+	    _mm256_storeu_si256((__m256i*)(D + 2*x + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+	yuy2LineGeneric(Y, U, V, D, x, width);
+    }
+}
+
+#endif
+
+YuvConversion::Implementation YuvConversion::getImplementation()
+{
+    static const Implementation impl =
+	isSupported(AVX2) ? AVX2 :
+	isSupported(SSE2) ? SSE2 :
+	Generic;
+    return impl;
+}
+
+bool YuvConversion::isSupported(Implementation impl)
+{
+    switch (impl)
+    {
+    case Generic:
+	return true;
+#ifdef YUV_CONVERSION_X86
+    case SSE2:
+	return __builtin_cpu_supports("sse2");
+    case AVX2:
+	return __builtin_cpu_supports("avx2");
+#endif
+    default:
+	return false;
+    }
+}
+
+const char* YuvConversion::getName(Implementation impl)
+{
+    switch (impl)
+    {
+    case Generic: return "generic";
+    case SSE2:    return "sse2";
+    case AVX2:    return "avx2";
+    }
+    return "unknown";
+}
+
+void YuvConversion::copyYuv420p(const uint8_t* const src[], const int srcStride[],
+				uint8_t* const dst[], const int dstStride[],
+				int width, int firstLine, int lastLine)
+{
+    // memcpy of the C library is already vectorized.
+    for (int line = firstLine; line < lastLine; line++)
+    {
+	memcpy(dst[0] + line * dstStride[0], src[0] + line * srcStride[0], width);
+    }
+
+    int chromaWidth = (width + 1) / 2;
+    for (int line = firstLine / 2; line < (lastLine + 1) / 2; line++)
+    {
+	memcpy(dst[1] + line * dstStride[1], src[1] + line * srcStride[1], chromaWidth);
+	memcpy(dst[2] + line * dstStride[2], src[2] + line * srcStride[2], chromaWidth);
+    }
+}
+
+void YuvConversion::yuv420pToYuy2(Implementation impl,
+				  const uint8_t* const src[], const int srcStride[],
+				  uint8_t* dst, int dstStride,
+				  int width, int firstLine, int lastLine,
+				  bool interlaced)
+{
+    switch (impl)
+    {
+#ifdef YUV_CONVERSION_X86
+    case AVX2:
+	yuy2AVX2(src, srcStride, dst, dstStride, width, firstLine, lastLine, interlaced);
+	return;
+    case SSE2:
+	yuy2SSE2(src, srcStride, dst, dstStride, width, firstLine, lastLine, interlaced);
+	return;
+#endif
+    default:
+	yuy2Generic(src, srcStride, dst, dstStride, width, firstLine, lastLine, interlaced);
+	return;
+    }
+}
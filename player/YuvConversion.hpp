@@ -0,0 +1,76 @@
+//
+// YUV Conversion
+//
+// Copyright (C) Joachim Erbs, 2013
+//
+//    This file is part of Sinema.
+//
+//    Sinema is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Sinema is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with Sinema.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef YUV_CONVERSION_HPP
+#define YUV_CONVERSION_HPP
+
+#include <stdint.h>
+
+// Conversions of YUV420P frames into Xv images of the same size. These
+// are the common cases, for which a generic sws_scale is much slower
+// than needed. Both convert the lines firstLine up to lastLine (not
+// included) of the luma plane. firstLine has to be a multiple of 4.
+//
+// Planes are passed in FFmpeg order (Y, U, V). The chroma planes of a
+// YV12 image have to be swapped by the caller.
+
+class YuvConversion
+{
+public:
+    enum Implementation
+    {
+	Generic,
+	SSE2,
+	AVX2
+    };
+
+    // The best implementation supported by the CPU:
+    static Implementation getImplementation();
+    static bool isSupported(Implementation impl);
+    static const char* getName(Implementation impl);
+
+    // Copies the planes line by line, the pitches of Xv images usually
+    // differ from the FFmpeg line sizes:
+    static void copyYuv420p(const uint8_t* const src[], const int srcStride[],
+			    uint8_t* const dst[], const int dstStride[],
+			    int width, int firstLine, int lastLine);
+
+    // Each chroma line is used for two luma lines. For interlaced frames
+    // these are lines of the same field. Odd widths are rounded up, the
+    // FFmpeg line sizes are padded anyway.
+    static void yuv420pToYuy2(const uint8_t* const src[], const int srcStride[],
+			      uint8_t* dst, int dstStride,
+			      int width, int firstLine, int lastLine,
+			      bool interlaced)
+    {
+	yuv420pToYuy2(getImplementation(), src, srcStride, dst, dstStride,
+		      width, firstLine, lastLine, interlaced);
+    }
+
+    // Uses the given implementation, which has to be supported:
+    static void yuv420pToYuy2(Implementation impl,
+			      const uint8_t* const src[], const int srcStride[],
+			      uint8_t* dst, int dstStride,
+			      int width, int firstLine, int lastLine,
+			      bool interlaced);
+};
+
+#endif
@@ -0,0 +1,158 @@
+//
+//  tracedump, decoder for binary trace files written with SINEMA_BINLOG
+//
+//  Copyright (C) 2012 Joachim Erbs <joachim.erbs@gmx.de>
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Usage: tracedump <file>
+//
+// Prints one line per record, sorted by time:
+//   <seconds since first record> <tid> <file>:<line> <text> <args>
+//
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <string.h>
+
+#include "platform/BinaryTrace.hpp"
+
+using namespace std;
+
+struct Site
+{
+    unsigned int line;
+    string file;
+    string function;
+    string text;
+};
+
+static bool earlier(const BinaryTraceRecord& r1, const BinaryTraceRecord& r2)
+{
+    return r1.time < r2.time;
+}
+
+template<typename T>
+static bool read(ifstream& ifs, T& val)
+{
+    return !ifs.read((char*)&val, sizeof(val)).fail();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+	cerr << "Usage: " << argv[0] << " <file>" << endl;
+	return 1;
+    }
+
+    ifstream ifs(argv[1], ios::binary);
+    if (!ifs)
+    {
+	cerr << "Cannot open " << argv[1] << endl;
+	return 1;
+    }
+
+    char magic[sizeof(binaryTraceMagic)];
+    if (!ifs.read(magic, sizeof(magic)) ||
+	memcmp(magic, binaryTraceMagic, sizeof(magic)) != 0)
+    {
+	cerr << argv[1] << " is not a binary trace file" << endl;
+	return 1;
+    }
+
+    map<unsigned int, Site> sites;
+    vector<BinaryTraceRecord> records;
+    map<unsigned int, unsigned int> lost;
+
+    uint32_t tag;
+    while (read(ifs, tag))
+    {
+	if (tag == BinaryTraceSite)
+	{
+	    uint32_t id;
+	    uint32_t line;
+	    Site site;
+	    read(ifs, id);
+	    read(ifs, line);
+	    site.line = line;
+	    getline(ifs, site.file, '\0');
+	    getline(ifs, site.function, '\0');
+	    getline(ifs, site.text, '\0');
+	    sites[id] = site;
+	}
+	else if (tag == BinaryTraceRecords)
+	{
+	    uint32_t count;
+	    read(ifs, count);
+	    for (uint32_t i = 0; i < count; i++)
+	    {
+		BinaryTraceRecord record;
+		if (!read(ifs, record))
+		{
+		    break;
+		}
+		records.push_back(record);
+	    }
+	}
+	else if (tag == BinaryTraceLost)
+	{
+	    uint32_t tid;
+	    uint32_t count;
+	    read(ifs, tid);
+	    read(ifs, count);
+	    lost[tid] += count;
+	}
+	else
+	{
+	    cerr << "Unknown tag " << tag << ", file is corrupted" << endl;
+	    break;
+	}
+    }
+
+    // Records of different threads are written interleaved:
+    stable_sort(records.begin(), records.end(), earlier);
+
+    uint64_t start = records.empty() ? 0 : records.front().time;
+
+    for (vector<BinaryTraceRecord>::iterator it = records.begin(); it != records.end(); it++)
+    {
+	const Site& site = sites[it->site];
+
+	cout << fixed << setprecision(6) << double(it->time - start) / 1e9
+	     << " " << it->tid
+	     << " " << site.file << ":" << site.line
+	     << " " << site.text;
+
+	cout.unsetf(ios::floatfield);
+	cout << setprecision(15);
+	for (int i = 0; i < it->numArgs && i < 4; i++)
+	{
+	    cout << " " << it->arg[i];
+	}
+	cout << endl;
+    }
+
+    for (map<unsigned int, unsigned int>::iterator it = lost.begin(); it != lost.end(); it++)
+    {
+	cout << "tid " << it->first << ": " << it->second << " records lost" << endl;
+    }
+
+    return 0;
+}